@@ -0,0 +1,18 @@
+# Writes the current git revision into a header, run on every build so incremental builds never report a stale one.
+# The header is only replaced when the revision changed, so an unchanged tree does not recompile the driver.
+
+execute_process(
+        COMMAND git rev-parse --short HEAD
+        WORKING_DIRECTORY ${SOURCE_DIR}
+        OUTPUT_VARIABLE BENCH_REVISION
+        OUTPUT_STRIP_TRAILING_WHITESPACE
+        ERROR_QUIET
+)
+
+if(NOT BENCH_REVISION)
+    set(BENCH_REVISION "unknown")
+endif()
+
+file(WRITE ${OUTPUT}.tmp "#pragma once\n#define MEXTRACE_BENCH_REVISION \"${BENCH_REVISION}\"\n")
+file(COPY_FILE ${OUTPUT}.tmp ${OUTPUT} ONLY_IF_DIFFERENT)
+file(REMOVE ${OUTPUT}.tmp)
@@ -0,0 +1,17 @@
+// One link of a chain of shared libraries. Each copy is built with BENCH_SELF naming its
+// entry point and, except for the last, BENCH_NEXT naming the entry point of the next library.
+
+#ifdef BENCH_NEXT
+extern "C" void BENCH_NEXT(void (*leaf)());
+#endif
+
+extern "C" __attribute__((noinline)) void BENCH_SELF(void (*leaf)())
+{
+#ifdef BENCH_NEXT
+    BENCH_NEXT(leaf);
+#else
+    leaf();
+#endif
+    // Keeps the call above from becoming a tail call, so every library shows up as a frame.
+    asm volatile("" ::: "memory");
+}
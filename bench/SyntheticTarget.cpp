@@ -0,0 +1,103 @@
+// Synthetic target process for mexTraceBench. It builds a known stack shape, prints "ready"
+// on stdout once every thread is parked in it and then waits to be captured.
+//
+//   recursion <depth>   one thread parked <depth> frames deep
+//   threads <count>     <count> threads, each parked 16 frames deep
+//   libraries           one thread parked at the end of a chain of shared libraries
+
+#include <atomic>
+#include <charconv>
+#include <cstdio>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#ifdef BENCH_WITH_LIBRARIES
+extern "C" void benchLibrary0(void (*leaf)());
+#endif
+
+/// @brief Anonymous namespace
+namespace
+{
+    std::atomic<int> parkedThreads{0};
+    // Never set; it keeps the compiler from proving that recurse() cannot return.
+    std::atomic<bool> released{false};
+
+    void park()
+    {
+        parkedThreads.fetch_add(1, std::memory_order_release);
+        while (!released.load(std::memory_order_relaxed))
+        {
+            pause();
+        }
+    }
+
+    __attribute__((noinline)) void recurse(const int depth)
+    {
+        if (depth > 0)
+        {
+            recurse(depth - 1);
+        }
+        else
+        {
+            park();
+        }
+        asm volatile("" ::: "memory");
+    }
+
+    int parseCount(const char* text, const int fallback)
+    {
+        const std::string_view view(text);
+        int value = fallback;
+        std::from_chars(view.data(), view.data() + view.size(), value);
+        return value;
+    }
+
+    void waitAndSignalReady(const int threads)
+    {
+        while (parkedThreads.load(std::memory_order_acquire) < threads)
+        {
+            std::this_thread::yield();
+        }
+
+        // Give the last thread time to enter pause() after announcing itself.
+        usleep(10'000);
+        std::puts("ready");
+        std::fflush(stdout);
+    }
+}
+
+int main(const int argc, char* argv[])
+{
+    const std::string_view mode = argc > 1 ? argv[1] : "recursion";
+
+    if (mode == "threads")
+    {
+        const int count = argc > 2 ? parseCount(argv[2], 64) : 64;
+        std::vector<std::thread> threads;
+        for (int i = 0; i < count; ++i)
+        {
+            threads.emplace_back([] { recurse(16); });
+        }
+        waitAndSignalReady(count);
+        for (;;)
+        {
+            pause();
+        }
+    }
+
+#ifdef BENCH_WITH_LIBRARIES
+    if (mode == "libraries")
+    {
+        std::thread([] { waitAndSignalReady(1); }).detach();
+        benchLibrary0([] { park(); });
+        return 0;
+    }
+#endif
+
+    const int depth = argc > 2 ? parseCount(argv[2], 64) : 64;
+    std::thread([] { waitAndSignalReady(1); }).detach();
+    recurse(depth);
+    return 0;
+}
@@ -0,0 +1,387 @@
+// Benchmarks the capture pipeline against synthetic targets and writes the results as JSON,
+// one object per measurement, so runs of different commits can be compared.
+
+#include "ConsolePrinter.h"
+#include "ModuleMap.h"
+#include "PlatformUtils.h"
+#include "StackTrace.h"
+#include "Symbolizer.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#if __has_include("BenchRevision.h")
+#include "BenchRevision.h"
+#endif
+
+#ifndef MEXTRACE_BENCH_REVISION
+#define MEXTRACE_BENCH_REVISION "unknown"
+#endif
+
+/// @brief Anonymous namespace
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    /// @brief TargetSpec names a synthetic target binary and how to start it. \struct TargetSpec
+    struct TargetSpec
+    {
+        std::string_view name;
+        std::string_view path;
+        std::vector<std::string> args;
+    };
+
+    /// @brief Result is one measurement, either a latency distribution or a single throughput value. \struct Result
+    struct Result
+    {
+        std::string name;
+        std::string unit;
+        std::vector<double> samples;
+        std::optional<double> value;
+    };
+
+    /// @brief SpawnedTarget runs a synthetic target until it is destroyed. \class SpawnedTarget
+    class SpawnedTarget
+    {
+    public:
+
+        /**
+         * @brief Ctor, starts the target and waits until it reports that its stacks are in place.
+         * @param spec The target to start.
+         */
+        explicit SpawnedTarget(const TargetSpec& spec)
+        {
+            int pipeFds[2];
+            if (pipe(pipeFds) == -1)
+            {
+                return;
+            }
+
+            // Everything the child needs is built here; after fork() it only calls async-signal-safe functions.
+            std::string path(spec.path);
+            std::vector<char*> argv{path.data()};
+            for (const auto& arg : spec.args)
+            {
+                argv.push_back(const_cast<char*>(arg.c_str()));
+            }
+            argv.push_back(nullptr);
+
+            m_pid = fork();
+            if (m_pid == 0)
+            {
+                dup2(pipeFds[1], STDOUT_FILENO);
+                close(pipeFds[0]);
+                close(pipeFds[1]);
+                execv(argv[0], argv.data());
+                _exit(127);
+            }
+
+            close(pipeFds[1]);
+            pollfd readyFd{pipeFds[0], POLLIN, 0};
+            std::array<char, 16> line{};
+            if (m_pid > 0 && poll(&readyFd, 1, 10'000) == 1 && read(pipeFds[0], line.data(), line.size()) > 0)
+            {
+                m_ready = std::string_view(line.data()).starts_with("ready");
+            }
+            close(pipeFds[0]);
+        }
+
+        /**
+         * @brief Destructor, kills and reaps the target.
+         */
+        ~SpawnedTarget()
+        {
+            if (m_pid > 0)
+            {
+                kill(m_pid, SIGKILL);
+                waitpid(m_pid, nullptr, 0);
+            }
+        }
+
+        SpawnedTarget(const SpawnedTarget&) = delete;
+        SpawnedTarget& operator=(const SpawnedTarget&) = delete;
+
+        /**
+         * @brief Gets the process ID of the target.
+         * @return The PID, or -1 if it could not be started.
+         */
+        [[nodiscard]] pid_t pid() const noexcept
+        {
+            return m_ready ? m_pid : -1;
+        }
+
+    private:
+        pid_t m_pid{-1};
+        bool m_ready{false};
+    };
+
+    double micros(const Clock::duration duration)
+    {
+        return std::chrono::duration<double, std::micro>(duration).count();
+    }
+
+    double percentile(std::vector<double> samples, const double fraction)
+    {
+        std::ranges::sort(samples);
+        const auto index = static_cast<size_t>(fraction * static_cast<double>(samples.size() - 1) + 0.5);
+        return samples[index];
+    }
+
+    void benchCapture(const TargetSpec& spec, const size_t iterations, std::vector<Result>& results)
+    {
+        const SpawnedTarget target(spec);
+        if (target.pid() == -1)
+        {
+            std::cerr << std::format("Failed to start {}\n", spec.name);
+            return;
+        }
+
+        const StackTrace tracer;
+        Result latency{std::format("capture/{}/latency", spec.name), "us", {}, std::nullopt};
+        Result stop{std::format("capture/{}/stop", spec.name), "us", {}, std::nullopt};
+        Result depth{std::format("capture/{}/frames", spec.name), "frames", {}, std::nullopt};
+
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            StackTrace::CaptureStats stats;
+            const auto start = Clock::now();
+            const auto frames = tracer.captureProcess(target.pid(), &stats);
+            const auto elapsed = Clock::now() - start;
+
+            if (frames)
+            {
+                latency.samples.push_back(micros(elapsed));
+                stop.samples.push_back(micros(stats.totalStop));
+                depth.value = static_cast<double>(frames->size());
+            }
+        }
+
+        results.push_back(std::move(latency));
+        results.push_back(std::move(stop));
+        results.push_back(std::move(depth));
+    }
+
+    void benchAllThreads(const TargetSpec& spec, const size_t iterations, std::vector<Result>& results)
+    {
+        const SpawnedTarget target(spec);
+        if (target.pid() == -1)
+        {
+            std::cerr << std::format("Failed to start {}\n", spec.name);
+            return;
+        }
+
+        const StackTrace tracer;
+        Result latency{std::format("threads/{}/latency", spec.name), "us", {}, std::nullopt};
+        Result stop{std::format("threads/{}/stop", spec.name), "us", {}, std::nullopt};
+
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            StackTrace::CaptureStats stats;
+            const auto start = Clock::now();
+            const auto threads = tracer.captureThreadGroups(target.pid(), &stats);
+            const auto elapsed = Clock::now() - start;
+
+            if (threads)
+            {
+                latency.samples.push_back(micros(elapsed));
+                stop.samples.push_back(micros(stats.totalStop));
+            }
+        }
+
+        results.push_back(std::move(latency));
+        results.push_back(std::move(stop));
+    }
+
+    void benchResolve(const TargetSpec& spec, std::vector<Result>& results)
+    {
+        const SpawnedTarget target(spec);
+        if (target.pid() == -1)
+        {
+            std::cerr << std::format("Failed to start {}\n", spec.name);
+            return;
+        }
+
+        const auto modules = ModuleMap::read(target.pid());
+        if (!modules)
+        {
+            std::cerr << std::format("Failed to read the mappings of {}\n", spec.name);
+            return;
+        }
+
+        // Spread lookups evenly over every executable mapping of every module.
+        constexpr size_t addressesPerMapping = 2048;
+        std::vector<uintptr_t> addresses;
+        for (const auto& mapping : modules->mappings())
+        {
+            if (mapping.moduleId == ModuleMap::noModule || !mapping.executable)
+            {
+                continue;
+            }
+
+            const auto step = std::max<uintptr_t>(1, (mapping.end - mapping.start) / addressesPerMapping);
+            for (auto address = mapping.start; address < mapping.end; address += step)
+            {
+                addresses.push_back(address);
+            }
+        }
+
+        auto measure = [&](const std::string& name, ThreadPool* pool, const bool cold)
+        {
+            if (cold)
+            {
+                Symbolizer::instance().clear();
+            }
+
+            const auto start = Clock::now();
+            const auto frames = PlatformUtils::resolveModuleAddresses(*modules, addresses, pool);
+            const auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            results.push_back(Result{name, "addresses/s", {}, static_cast<double>(frames.size()) / seconds});
+        };
+
+        measure(std::format("resolve/{}/cold", spec.name), nullptr, true);
+        measure(std::format("resolve/{}/warm", spec.name), nullptr, false);
+        measure(std::format("resolve/{}/cold-parallel", spec.name), &ThreadPool::shared(), true);
+        measure(std::format("resolve/{}/warm-parallel", spec.name), &ThreadPool::shared(), false);
+    }
+
+    void benchPrint(const TargetSpec& spec, std::vector<Result>& results)
+    {
+        const SpawnedTarget target(spec);
+        if (target.pid() == -1)
+        {
+            std::cerr << std::format("Failed to start {}\n", spec.name);
+            return;
+        }
+
+        const StackTrace tracer;
+        const auto frames = tracer.captureProcess(target.pid());
+        if (!frames || frames->empty())
+        {
+            std::cerr << std::format("Failed to capture {}\n", spec.name);
+            return;
+        }
+
+        constexpr size_t targetFrames = 200'000;
+        const auto repetitions = std::max<size_t>(1, targetFrames / frames->size());
+
+        std::ostringstream sink;
+        const ConsolePrinter printer(sink);
+        const auto start = Clock::now();
+        for (size_t i = 0; i < repetitions; ++i)
+        {
+            printer.printStackTrace(*frames);
+        }
+        const auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        const auto printed = static_cast<double>(repetitions * frames->size());
+        results.push_back(Result{"print/frames", "frames/s", {}, printed / seconds});
+        results.push_back(Result{"print/bytes", "MB/s", {}, static_cast<double>(sink.view().size()) / seconds / 1e6});
+    }
+
+    void writeJson(std::ostream& os, const std::vector<Result>& results, const size_t iterations)
+    {
+        const auto now = std::chrono::system_clock::now().time_since_epoch();
+        os << "{\n";
+        os << std::format("  \"revision\": \"{}\",\n", MEXTRACE_BENCH_REVISION);
+        os << std::format("  \"timestamp\": {},\n", std::chrono::duration_cast<std::chrono::seconds>(now).count());
+        os << std::format("  \"cpus\": {},\n", std::thread::hardware_concurrency());
+        os << std::format("  \"iterations\": {},\n", iterations);
+        os << "  \"results\": [\n";
+
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const auto& result = results[i];
+            os << std::format("    {{\"name\": \"{}\", \"unit\": \"{}\"", result.name, result.unit);
+
+            if (result.value)
+            {
+                os << std::format(", \"value\": {:.3f}", *result.value);
+            }
+            if (!result.samples.empty())
+            {
+                const auto [min, max] = std::ranges::minmax(result.samples);
+                os << std::format(", \"count\": {}, \"min\": {:.3f}, \"median\": {:.3f}, \"p95\": {:.3f}, \"max\": {:.3f}",
+                    result.samples.size(), min, percentile(result.samples, 0.5), percentile(result.samples, 0.95), max);
+            }
+            os << (i + 1 < results.size() ? "},\n" : "}\n");
+        }
+
+        os << "  ]\n}\n";
+    }
+}
+
+int main(const int argc, char* argv[])
+{
+    size_t iterations = 50;
+    std::string outputPath;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+        if ((arg == "-n" || arg == "--iterations") && i + 1 < argc)
+        {
+            const std::string_view count = argv[++i];
+            std::from_chars(count.data(), count.data() + count.size(), iterations);
+        }
+        else if ((arg == "-o" || arg == "--output") && i + 1 < argc)
+        {
+            outputPath = argv[++i];
+        }
+        else
+        {
+            std::cerr << "Usage: mexTraceBench [-n|--iterations <n>] [-o|--output <file.json>]\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    const std::vector<TargetSpec> recursionTargets{
+        {"recursion-pie-fp", MEXTRACE_BENCH_TARGET_PIE, {"recursion", "64"}},
+        {"recursion-pie-nofp", MEXTRACE_BENCH_TARGET_NOFP, {"recursion", "64"}},
+        {"recursion-nopie-fp", MEXTRACE_BENCH_TARGET_NOPIE, {"recursion", "64"}},
+        {"recursion-deep", MEXTRACE_BENCH_TARGET_NOFP, {"recursion", "1000"}},
+        {"libraries", MEXTRACE_BENCH_TARGET_LIBRARIES, {"libraries"}}
+    };
+    const TargetSpec threadsTarget{"threads-64", MEXTRACE_BENCH_TARGET_NOFP, {"threads", "64"}};
+    const TargetSpec librariesTarget{"libraries", MEXTRACE_BENCH_TARGET_LIBRARIES, {"libraries"}};
+
+    std::vector<Result> results;
+    for (const auto& spec : recursionTargets)
+    {
+        benchCapture(spec, iterations, results);
+    }
+    benchAllThreads(threadsTarget, iterations, results);
+    benchResolve(librariesTarget, results);
+    benchPrint(recursionTargets.front(), results);
+
+    if (outputPath.empty())
+    {
+        writeJson(std::cout, results, iterations);
+        return EXIT_SUCCESS;
+    }
+
+    std::ofstream file(outputPath, std::ios::trunc);
+    if (!file)
+    {
+        std::cerr << std::format("Failed to open {}\n", outputPath);
+        return EXIT_FAILURE;
+    }
+    writeJson(file, results, iterations);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,135 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+#include "ElfFile.h"
+
+/// @brief CfiTable indexes the DWARF call frame information (.eh_frame) of a module and evaluates it per address. \class CfiTable
+class CfiTable
+{
+public:
+
+    /// @brief Enum describing how a register of the caller is recovered. \enum RuleKind
+    enum class RuleKind : uint8_t
+    {
+        Undefined,
+        SameValue,
+        Offset,
+        ValOffset,
+        Register,
+        Expression
+    };
+
+    /// @brief RegisterRule is one column of a CFI row. \struct RegisterRule
+    struct RegisterRule
+    {
+        RuleKind kind{RuleKind::Undefined};
+        int32_t value{0};
+    };
+
+    /// @brief Row is the compact unwind rule set valid from its location up to the next row. \struct Row
+    struct Row
+    {
+        uint64_t location{0};
+        int32_t cfaOffset{0};
+        uint16_t cfaRegister{0};
+        bool cfaIsExpression{false};
+        RegisterRule returnAddress;
+        RegisterRule framePointer;
+    };
+
+    /**
+     * @brief Builds the FDE index of a module from .eh_frame_hdr, or by scanning .eh_frame if there is no header table.
+     * @param elf The mapped ELF file, which must outlive the table.
+     * @param framePointerRegister The DWARF register number of the frame pointer on this architecture.
+     * @return The CFI table, empty if the module has no .eh_frame.
+     */
+    [[nodiscard]] static CfiTable build(const ElfFile& elf, uint16_t framePointerRegister);
+
+    /**
+     * @brief Default Ctor, creates an empty table.
+     */
+    CfiTable() noexcept = default;
+
+    /**
+     * @brief Move constructor, takes over the index and the decoded rows of another table.
+     * @param other The CfiTable to move from.
+     */
+    CfiTable(CfiTable&& other) noexcept;
+
+    /**
+     * @brief Move assignment, takes over the index and the decoded rows of another table.
+     * @param other The CfiTable to move from.
+     * @return A reference to this CfiTable.
+     */
+    CfiTable& operator=(CfiTable&& other) noexcept;
+
+    CfiTable(const CfiTable&) = delete;
+    CfiTable& operator=(const CfiTable&) = delete;
+
+    /**
+     * @brief Checks whether the table covers any code.
+     * @return A boolean indicating whether there are no FDEs.
+     */
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return m_fdes.empty() && m_hdrTable.empty();
+    }
+
+    /**
+     * @brief Finds the unwind row for a link-time address, decoding and caching the rows of its FDE on first use.
+     * @param address The address relative to the file's link-time layout.
+     * @return The row, or std::nullopt if no FDE covers the address.
+     */
+    [[nodiscard]] std::optional<Row> find(uint64_t address) const;
+
+private:
+
+    /// @brief Fde is an index entry pointing at one frame description entry in .eh_frame. \struct Fde
+    struct Fde
+    {
+        uint64_t pcBegin{0};
+        uint64_t offset{0};
+    };
+
+    /// @brief DecodedFde caches the rows of one FDE together with its covered range. \struct DecodedFde
+    struct DecodedFde
+    {
+        uint64_t pcBegin{0};
+        uint64_t pcEnd{0};
+        std::vector<Row> rows;
+    };
+
+    std::span<const std::byte> m_ehFrame;
+    uint64_t m_ehFrameAddress{0};
+    std::span<const std::byte> m_hdrTable;
+    uint64_t m_hdrAddress{0};
+    std::vector<Fde> m_fdes;
+    uint16_t m_framePointerRegister{0};
+
+    mutable std::mutex m_cacheMutex;
+    mutable std::unordered_map<uint64_t, DecodedFde> m_cache;
+
+    /**
+     * @brief Finds the .eh_frame offset of the FDE whose start is the closest at or below an address.
+     * @param address The link-time address.
+     * @return The offset, or std::nullopt if the address lies below every FDE.
+     */
+    [[nodiscard]] std::optional<uint64_t> findFdeOffset(uint64_t address) const noexcept;
+
+    /**
+     * @brief Parses an FDE and its CIE and evaluates their instructions into rows.
+     * @param offset The offset of the FDE inside .eh_frame.
+     * @return The decoded FDE, or std::nullopt if it is malformed.
+     */
+    [[nodiscard]] std::optional<DecodedFde> decodeFde(uint64_t offset) const;
+
+    /**
+     * @brief Scans every entry of .eh_frame and indexes the FDEs by start address.
+     */
+    void scanEhFrame();
+};
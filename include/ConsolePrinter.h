@@ -4,10 +4,19 @@
 #include <string_view>
 #include <ostream>
 #include <cstdint>
+#include <format>
+#include <iterator>
 #include <memory>
+#include <span>
+#include "HangDetector.h"
+#include "ProcessScanner.h"
 #include "StackFrame.h"
+#include "StackTrace.h"
+#include "StackWatcher.h"
+#include "ThreadGroups.h"
 
-/// @brief ConsolePrinter is a utility class for printing formatted messages to the console. \class ConsolePrinter
+/// @brief ConsolePrinter is a utility class for printing formatted messages to the console.
+///        Every print formats into one reusable buffer that is written out in large chunks. \class ConsolePrinter
 class ConsolePrinter
 {
 public:
@@ -47,6 +56,43 @@ public:
      */
     void printStackTrace(const std::vector<StackFrame>& frames) const;
 
+    /**
+     * @brief Prints each distinct stack of a thread dump once, with its thread count and TID list.
+     * @param groups The grouped and symbolized thread stacks.
+     */
+    void printThreadGroups(const ThreadGroups& groups) const;
+
+    /**
+     * @brief Prints the prefix tree of a thread dump, indenting where stacks diverge.
+     * @param root The root node built by ThreadGroups::buildTrie().
+     */
+    void printStackTrie(const ThreadGroups::TrieNode& root) const;
+
+    /**
+     * @brief Prints the threads whose stacks changed since the previous poll, marking the frames that differ.
+     * @param changes The changes reported by StackWatcher::poll().
+     */
+    void printStackChanges(std::span<const StackWatcher::Change> changes) const;
+
+    /**
+     * @brief Prints the stuck threads of a hang detection with their stacks and blocking syscall,
+     *        followed by the lock cycles and convoys found among them.
+     * @param report The report returned by HangDetector::detect().
+     */
+    void printHangReport(const HangDetector::Report& report) const;
+
+    /**
+     * @brief Prints the heading of a captured thread: its state, syscall, wchan, context switches and CPU times.
+     * @param thread The captured thread.
+     */
+    void printThreadHeader(const StackTrace::ThreadStack& thread) const;
+
+    /**
+     * @brief Prints a process table with one aligned row per process.
+     * @param processes The rows to print, in display order.
+     */
+    void printProcessTable(std::span<const ProcessScanner::ProcessInfo> processes) const;
+
     /**
      * @brief Prints an error message to the console.
      * @param message The error message to print.
@@ -71,18 +117,67 @@ public:
      */
     void printWarning(std::string_view message) const;
 
-    /**
-     * @brief Colorizes the given text with the specified color and optional bold formatting.
-     * @param text The text to colorize.
-     * @param color The color to apply to the text.
-     * @param bold The optional flag to make the text bold. Defaults to false.
-     * @return A string containing the colorized text.
-     */
-    [[nodiscard]] std::string colorize(std::string_view text, Color color, bool bold = false) const;
-
 private:
+    /// @brief The buffered size at which output is written out in the middle of a print.
+    static constexpr size_t flushThreshold = 64 * 1024;
+
     std::ostream& m_outputStream;
+    int m_outputFd;
     bool m_useColors;
+    mutable std::string m_buffer;
+
+    /**
+     * @brief Formats text onto the end of the output buffer.
+     * @param fmt The format string.
+     * @param args The arguments to format.
+     */
+    template <typename... Args>
+    void append(std::format_string<Args...> fmt, Args&&... args) const
+    {
+        std::format_to(std::back_inserter(m_buffer), fmt, std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Appends the escape code that starts a color, if colors are enabled.
+     * @param color The color.
+     * @param bold The flag indicating whether the text should be bold.
+     */
+    void beginColor(Color color, bool bold = false) const;
+
+    /**
+     * @brief Appends the escape code that resets the color, if colors are enabled.
+     */
+    void endColor() const;
+
+    /**
+     * @brief Appends a colored prefix, a message and a newline.
+     * @param prefix The prefix, e.g. "[INFO] ".
+     * @param color The color of the prefix.
+     * @param message The message.
+     */
+    void appendMessage(std::string_view prefix, Color color, std::string_view message) const;
+
+    /**
+     * @brief Appends a stack trace without writing it out.
+     * @param frames The frames of the stack trace.
+     */
+    void appendStackTrace(const std::vector<StackFrame>& frames) const;
+
+    /**
+     * @brief Writes the buffered output to the stream, or with write(2) when the stream is stdout or stderr.
+     */
+    void flush() const;
+
+    /**
+     * @brief Writes the buffered output out once it has grown past flushThreshold.
+     */
+    void flushIfFull() const
+    {
+        if (m_buffer.size() >= flushThreshold)
+        {
+            flush();
+        }
+    }
 
     /**
      * @brief Returns the ANSI escape code for the specified color and boldness.
@@ -93,9 +188,36 @@ private:
     [[nodiscard]] static std::string_view getColorCode(Color color, bool bold) noexcept;
 
     /**
-     * @brief Prints a single stack frame to the console.
+     * @brief Appends a stack frame as its function name and source location, or its address if unresolved.
+     * @param frame The StackFrame object to format.
+     */
+    void appendFrameText(const StackFrame& frame) const;
+
+    /**
+     * @brief Appends a trie node and its descendants.
+     * @param node The node to print.
+     * @param depth The indentation level, increased only where stacks diverge.
+     */
+    void appendTrieNode(const ThreadGroups::TrieNode& node, size_t depth) const;
+
+    /**
+     * @brief Appends a single stack frame.
      * @param frame The StackFrame object to print.
      * @param index The index of the frame in the stack trace.
      */
-    void printFrame(const StackFrame& frame, size_t index) const;
+    void appendFrame(const StackFrame& frame, size_t index) const;
+
+    /**
+     * @brief Appends a single stack frame of a watched thread, highlighted and marked with '*' if it changed.
+     * @param frame The StackFrame object to print.
+     * @param index The index of the frame in the stack trace.
+     * @param changed The flag indicating whether the frame differs from the previous poll.
+     */
+    void appendWatchedFrame(const StackFrame& frame, size_t index, bool changed) const;
+
+    /**
+     * @brief Appends the syscall a thread is blocked in, e.g. "futex(0x7f00, 128, 2)", or "user code".
+     * @param syscall The syscall, std::nullopt if unknown.
+     */
+    void appendSyscall(const std::optional<StackSnapshot::Syscall>& syscall) const;
 };
\ No newline at end of file
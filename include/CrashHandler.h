@@ -0,0 +1,133 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/types.h>
+#include "Export.h"
+#include "ModuleMap.h"
+#include "StackFrame.h"
+
+class ThreadPool;
+
+/// @brief CrashHandler writes a raw trace record of the faulting thread when the process crashes. \class CrashHandler
+class MEXTRACE_API CrashHandler
+{
+public:
+
+    /// @brief The signals the handler is installed for.
+    static constexpr std::array<int, 3> signals{SIGSEGV, SIGABRT, SIGBUS};
+
+    /// @brief The most frames written per record.
+    static constexpr size_t maxFrames = 256;
+
+    /// @brief The size of the buffer /proc/self/maps is read into when crashing; longer maps are truncated.
+    static constexpr size_t maxMapsBytes = 512 * 1024;
+
+    /// @brief The size of the alternate signal stack the handler runs on.
+    static constexpr size_t alternateStackBytes = 64 * 1024;
+
+    /// @brief RecordHeader starts every record; registers, frames and the maps text follow it in that order.
+    ///        Header fields, registers and frames are stored in the byte order of the crashing machine, registers and
+    ///        frames as 64-bit words, so records are read back on the same architecture. This is format version 1;
+    ///        any change to the layout bumps recordVersion. \struct RecordHeader
+    struct RecordHeader
+    {
+        std::array<char, 8> magic{};
+        uint32_t version{0};
+        int32_t signal{0};
+        int32_t code{0};
+        int32_t pid{0};
+        int32_t tid{0};
+        uint32_t registerCount{0};
+        uint32_t frameCount{0};
+        uint32_t mapsBytes{0};
+        uint64_t faultAddress{0};
+        uint64_t timestampNs{0};
+    };
+
+    // The eight 32-bit fields end on an 8-byte boundary, so the header has no padding to leak or misread.
+    static_assert(sizeof(RecordHeader) == 56);
+    static_assert(offsetof(RecordHeader, version) == 8 && offsetof(RecordHeader, signal) == 12);
+    static_assert(offsetof(RecordHeader, code) == 16 && offsetof(RecordHeader, pid) == 20 && offsetof(RecordHeader, tid) == 24);
+    static_assert(offsetof(RecordHeader, registerCount) == 28 && offsetof(RecordHeader, frameCount) == 32);
+    static_assert(offsetof(RecordHeader, mapsBytes) == 36 && offsetof(RecordHeader, faultAddress) == 40);
+    static_assert(offsetof(RecordHeader, timestampNs) == 48);
+    static_assert(sizeof(uintptr_t) == sizeof(uint64_t), "Frames are written as 64-bit words");
+
+    /// @brief The magic and format version every RecordHeader carries.
+    static constexpr std::array<char, 8> recordMagic{'m', 'e', 'x', 'C', 'r', 'a', 's', 'h'};
+    static constexpr uint32_t recordVersion = 1;
+
+    /// @brief Report is one parsed record. \struct Report
+    struct Report
+    {
+        int signal{0};
+        int code{0};
+        pid_t pid{0};
+        pid_t tid{0};
+        uintptr_t faultAddress{0};
+        std::chrono::system_clock::time_point timestamp;
+        std::vector<uint64_t> registers;
+        std::vector<uintptr_t> addresses;
+        ModuleMap modules;
+    };
+
+    /**
+     * @brief Installs the handler for SIGSEGV, SIGABRT and SIGBUS and an alternate signal stack for the calling thread.
+     *        All memory the handler needs is allocated here; when a signal arrives it only walks the stack,
+     *        reads /proc/self/maps and writes one record to the file descriptor, then re-raises the signal.
+     * @param fd The descriptor to write records to, opened by the caller and kept open.
+     * @return A std::expected that is empty on success, or contains an error message on failure.
+     */
+    [[nodiscard]] static std::expected<void, std::string> install(int fd);
+
+    /**
+     * @brief Gives the calling thread its own alternate signal stack, so a stack overflow on it can still be reported.
+     *        The thread that called install() already has one.
+     * @return A std::expected that is empty on success, or contains an error message on failure.
+     */
+    [[nodiscard]] static std::expected<void, std::string> installThreadStack();
+
+    /**
+     * @brief Parses the records of a crash file.
+     * @param data The file contents, holding one or more records back to back.
+     * @return A std::expected containing the reports on success, or an error message if a record is malformed.
+     */
+    [[nodiscard]] static std::expected<std::vector<Report>, std::string> parse(std::span<const std::byte> data);
+
+    /**
+     * @brief Reads and parses a crash file.
+     * @param path The file written through the descriptor passed to install().
+     * @return A std::expected containing the reports on success, or an error message if the file cannot be read or is malformed.
+     */
+    [[nodiscard]] static std::expected<std::vector<Report>, std::string> read(const std::string& path);
+
+    /**
+     * @brief Symbolizes the stack of a report against the binaries on disk, which must not have changed since the crash.
+     * @param report The report.
+     * @param pool The pool to resolve the addresses on, or nullptr to resolve on the calling thread.
+     * @return One StackFrame per address.
+     */
+    [[nodiscard]] static std::vector<StackFrame> symbolize(const Report& report, ThreadPool* pool = nullptr);
+
+    /**
+     * @brief Gets the name of a register as written by the handler on this architecture.
+     * @param index The index into Report::registers.
+     * @return The name, or "?" if the index is out of range.
+     */
+    [[nodiscard]] static std::string_view registerName(size_t index) noexcept;
+
+private:
+
+    /**
+     * @brief Private destructor to prevent deletion of this utility class.
+     */
+    ~CrashHandler() = delete;
+};
@@ -0,0 +1,138 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "ElfFile.h"
+
+/// @brief DwarfLineTable is a sorted address to (file, line) index decoded from a module's .debug_line section. \class DwarfLineTable
+class DwarfLineTable
+{
+public:
+
+    /// @brief Row is the compact record for one address range start, line 0 marks the end of a sequence. \struct Row
+    struct Row
+    {
+        uint64_t address{0};
+        uint32_t fileIndex{0};
+        uint32_t line{0};
+    };
+
+    /// @brief Location is the result of a successful lookup. \struct Location
+    struct Location
+    {
+        std::string_view file;
+        uint32_t line{0};
+    };
+
+    /**
+     * @brief Decodes every line number program in the .debug_line section of an ELF file.
+     * @param elf The mapped ELF file.
+     * @return The line table, empty if the file has no (uncompressed) line information.
+     */
+    [[nodiscard]] static DwarfLineTable build(const ElfFile& elf);
+
+    /**
+     * @brief Creates a table that looks up directly in externally owned storage, e.g. a mapped cache file.
+     * @param rows The sorted rows.
+     * @param fileOffsets Offsets into fileNames, indexed by Row::fileIndex.
+     * @param fileNames The NUL-separated file name blob.
+     * @param backing Keeps the storage alive for the lifetime of the table.
+     * @return The line table.
+     */
+    [[nodiscard]] static DwarfLineTable fromStorage(
+        std::span<const Row> rows,
+        std::span<const uint32_t> fileOffsets,
+        std::span<const char> fileNames,
+        std::shared_ptr<const void> backing) noexcept;
+
+    /**
+     * @brief Default Ctor, creates an empty table.
+     */
+    DwarfLineTable() noexcept = default;
+
+    DwarfLineTable(DwarfLineTable&&) noexcept = default;
+    DwarfLineTable& operator=(DwarfLineTable&&) noexcept = default;
+    DwarfLineTable(const DwarfLineTable&) = delete;
+    DwarfLineTable& operator=(const DwarfLineTable&) = delete;
+
+    /**
+     * @brief Checks whether the table contains any rows.
+     * @return A boolean indicating whether the table is empty.
+     */
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return m_rows.empty();
+    }
+
+    /**
+     * @brief Gets the number of rows in the table.
+     * @return The number of rows.
+     */
+    [[nodiscard]] size_t size() const noexcept
+    {
+        return m_rows.size();
+    }
+
+    /**
+     * @brief Finds the source location of the given file address.
+     * @param address The address relative to the file's link-time layout.
+     * @return The location, or std::nullopt if the address is not covered by any sequence.
+     */
+    [[nodiscard]] std::optional<Location> lookup(uint64_t address) const noexcept;
+
+    /**
+     * @brief Gets the sorted rows, e.g. for serialization.
+     * @return A span over the rows.
+     */
+    [[nodiscard]] std::span<const Row> rows() const noexcept
+    {
+        return m_rows;
+    }
+
+    /**
+     * @brief Gets the offsets of each file name in the file name blob.
+     * @return A span over the offsets, indexed by Row::fileIndex.
+     */
+    [[nodiscard]] std::span<const uint32_t> fileOffsets() const noexcept
+    {
+        return m_fileOffsets;
+    }
+
+    /**
+     * @brief Gets the NUL-separated file name blob.
+     * @return A span over the file names.
+     */
+    [[nodiscard]] std::span<const char> fileNames() const noexcept
+    {
+        return m_fileNames;
+    }
+
+private:
+    std::vector<Row> m_ownedRows;
+    std::vector<uint32_t> m_ownedFileOffsets;
+    std::vector<char> m_ownedFileNames;
+    std::shared_ptr<const void> m_backing;
+    std::span<const Row> m_rows;
+    std::span<const uint32_t> m_fileOffsets;
+    std::span<const char> m_fileNames;
+
+    /**
+     * @brief Decodes a single line number program unit and appends its rows.
+     * @param unit The bytes of the unit, starting at its unit_length field.
+     * @param lineStr The .debug_line_str section contents, may be empty.
+     * @param str The .debug_str section contents, may be empty.
+     * @param fileIds Maps full paths to file indexes while building.
+     * @return The number of bytes consumed, 0 if the unit is malformed.
+     */
+    size_t decodeUnit(
+        std::span<const std::byte> unit,
+        std::span<const std::byte> lineStr,
+        std::span<const std::byte> str,
+        std::unordered_map<std::string, uint32_t>& fileIds);
+};
@@ -0,0 +1,123 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+/// @brief DwarfReader is a bounds-checked cursor over little-endian DWARF encoded data. \class DwarfReader
+class DwarfReader
+{
+public:
+
+    /**
+     * @brief Constructs a reader over the given bytes.
+     * @param data The bytes to read from.
+     */
+    explicit DwarfReader(std::span<const std::byte> data) noexcept;
+
+    /**
+     * @brief Checks whether a previous read ran past the end of the data.
+     * @return A boolean indicating whether the reader is still in a valid state.
+     */
+    [[nodiscard]] bool ok() const noexcept
+    {
+        return !m_failed;
+    }
+
+    /**
+     * @brief Checks whether all data has been consumed.
+     * @return A boolean indicating whether the cursor is at the end.
+     */
+    [[nodiscard]] bool atEnd() const noexcept
+    {
+        return m_offset >= m_data.size();
+    }
+
+    /**
+     * @brief Gets the current cursor position.
+     * @return The offset from the start of the data.
+     */
+    [[nodiscard]] size_t offset() const noexcept
+    {
+        return m_offset;
+    }
+
+    /**
+     * @brief Gets the number of bytes left after the cursor.
+     * @return The remaining byte count.
+     */
+    [[nodiscard]] size_t remaining() const noexcept
+    {
+        return m_offset < m_data.size() ? m_data.size() - m_offset : 0;
+    }
+
+    /**
+     * @brief Moves the cursor to an absolute offset.
+     * @param offset The new offset, marks the reader as failed if out of bounds.
+     */
+    void seek(size_t offset) noexcept;
+
+    /**
+     * @brief Advances the cursor by the given number of bytes.
+     * @param count The number of bytes to skip.
+     */
+    void skip(size_t count) noexcept;
+
+    /**
+     * @brief Reads a fixed-width little-endian unsigned value.
+     * @return The decoded value, 0 if the data is exhausted.
+     */
+    [[nodiscard]] uint8_t u8() noexcept;
+    [[nodiscard]] uint16_t u16() noexcept;
+    [[nodiscard]] uint32_t u32() noexcept;
+    [[nodiscard]] uint64_t u64() noexcept;
+
+    /**
+     * @brief Reads an unsigned LEB128 value.
+     * @return The decoded value.
+     */
+    [[nodiscard]] uint64_t uleb128() noexcept;
+
+    /**
+     * @brief Skips over a LEB128 value of either signedness.
+     */
+    void skipLeb128() noexcept;
+
+    /**
+     * @brief Reads a signed LEB128 value.
+     * @return The decoded value.
+     */
+    [[nodiscard]] int64_t sleb128() noexcept;
+
+    /**
+     * @brief Reads an unsigned value of the given byte width (1, 2, 4 or 8).
+     * @param size The width in bytes.
+     * @return The decoded value.
+     */
+    [[nodiscard]] uint64_t unsignedOfSize(size_t size) noexcept;
+
+    /**
+     * @brief Reads a NUL-terminated string.
+     * @return A string_view into the underlying data, without the terminator.
+     */
+    [[nodiscard]] std::string_view cstring() noexcept;
+
+    /**
+     * @brief Reads a DWARF initial length field.
+     * @param offsetSize Receives 4 for 32-bit DWARF or 8 for 64-bit DWARF.
+     * @return The unit length following the field.
+     */
+    [[nodiscard]] uint64_t initialLength(size_t& offsetSize) noexcept;
+
+    /**
+     * @brief Reads a sub-range of the data and advances past it.
+     * @param count The number of bytes to take.
+     * @return A span over the bytes, empty and failed if out of bounds.
+     */
+    [[nodiscard]] std::span<const std::byte> bytes(size_t count) noexcept;
+
+private:
+    std::span<const std::byte> m_data;
+    size_t m_offset{0};
+    bool m_failed{false};
+};
@@ -0,0 +1,124 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <link.h>
+
+/// @brief ElfFile is a read-only, memory-mapped view of an ELF image of the native class. \class ElfFile
+class ElfFile
+{
+public:
+
+    /// @brief Section describes a single section header together with its mapped contents. \struct Section
+    struct Section
+    {
+        std::string_view name;
+        uint32_t type{0};
+        uint64_t flags{0};
+        uint64_t address{0};
+        uint64_t offset{0};
+        uint32_t link{0};
+        uint64_t entrySize{0};
+        std::span<const std::byte> data;
+    };
+
+    /**
+     * @brief Maps the ELF file at the given path and validates its headers.
+     * @param path The path to the ELF file.
+     * @return A std::expected containing the mapped ElfFile on success, or an error message on failure.
+     */
+    [[nodiscard]] static std::expected<ElfFile, std::string> open(std::string_view path) noexcept;
+
+    /**
+     * @brief Move constructor, takes over the mapping of another ElfFile.
+     * @param other The ElfFile to move from.
+     */
+    ElfFile(ElfFile&& other) noexcept;
+
+    /**
+     * @brief Move assignment, releases the current mapping and takes over the other one.
+     * @param other The ElfFile to move from.
+     * @return A reference to this ElfFile.
+     */
+    ElfFile& operator=(ElfFile&& other) noexcept;
+
+    ElfFile(const ElfFile&) = delete;
+    ElfFile& operator=(const ElfFile&) = delete;
+
+    /**
+     * @brief Destructor, unmaps the file.
+     */
+    ~ElfFile();
+
+    /**
+     * @brief Gets the ELF object type (ET_EXEC, ET_DYN, ...).
+     * @return The e_type field of the ELF header.
+     */
+    [[nodiscard]] uint16_t type() const noexcept;
+
+    /**
+     * @brief Reads the GNU build-id note of the file.
+     * @return The build-id as a lowercase hex string, or std::nullopt if the file has no NT_GNU_BUILD_ID note.
+     */
+    [[nodiscard]] std::optional<std::string> buildId() const;
+
+    /**
+     * @brief Gets the raw bytes of the whole mapped file.
+     * @return A span over the mapped file.
+     */
+    [[nodiscard]] std::span<const std::byte> bytes() const noexcept;
+
+    /**
+     * @brief Gets the program headers of the file.
+     * @return A span over the program header table, empty if there is none.
+     */
+    [[nodiscard]] std::span<const ElfW(Phdr)> programHeaders() const noexcept;
+
+    /**
+     * @brief Gets the number of section headers.
+     * @return The number of entries in the section header table.
+     */
+    [[nodiscard]] size_t sectionCount() const noexcept;
+
+    /**
+     * @brief Gets the section at the given index of the section header table.
+     * @param index The section index.
+     * @return The section, or std::nullopt if the index or its contents are out of bounds.
+     */
+    [[nodiscard]] std::optional<Section> sectionAt(size_t index) const noexcept;
+
+    /**
+     * @brief Finds the first section with the given name.
+     * @param name The section name, e.g. ".symtab".
+     * @return The section, or std::nullopt if no such section exists.
+     */
+    [[nodiscard]] std::optional<Section> findSection(std::string_view name) const noexcept;
+
+private:
+    const std::byte* m_base{nullptr};
+    size_t m_size{0};
+
+    /**
+     * @brief Ctor taking ownership of an existing mapping.
+     * @param base The base address of the mapping.
+     * @param size The size of the mapping in bytes.
+     */
+    ElfFile(const std::byte* base, size_t size) noexcept;
+
+    /**
+     * @brief Gets the ELF header at the start of the mapping.
+     * @return A reference to the ELF header.
+     */
+    [[nodiscard]] const ElfW(Ehdr)& header() const noexcept;
+
+    /**
+     * @brief Reads the name of a section from the section header string table.
+     * @param nameOffset The sh_name offset of the section.
+     * @return A string_view of the name, empty if it cannot be read.
+     */
+    [[nodiscard]] std::string_view sectionName(uint32_t nameOffset) const noexcept;
+};
@@ -0,0 +1,118 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+#include "ElfFile.h"
+
+/// @brief ElfSymbolTable is a sorted address-range index over the function symbols of an ELF file. \class ElfSymbolTable
+class ElfSymbolTable
+{
+public:
+
+    /// @brief Entry is the fixed-size index record for one function symbol. \struct Entry
+    struct Entry
+    {
+        uint64_t start{0};
+        uint64_t size{0};
+        uint32_t nameOffset{0};
+        uint32_t reserved{0};
+    };
+
+    /// @brief Symbol is the result of a successful lookup. \struct Symbol
+    struct Symbol
+    {
+        std::string_view name;
+        uint64_t start{0};
+        uint64_t size{0};
+    };
+
+    /**
+     * @brief Builds the index from the .symtab and .dynsym sections of an ELF file.
+     * @param elf The mapped ELF file.
+     * @return The symbol table, empty if the file carries no function symbols.
+     */
+    [[nodiscard]] static ElfSymbolTable build(const ElfFile& elf);
+
+    /**
+     * @brief Creates a table that looks up directly in externally owned storage, e.g. a mapped cache file.
+     * @param entries The sorted index records.
+     * @param names The NUL-separated name blob the records point into.
+     * @param backing Keeps the storage alive for the lifetime of the table.
+     * @return The symbol table.
+     */
+    [[nodiscard]] static ElfSymbolTable fromStorage(
+        std::span<const Entry> entries,
+        std::span<const char> names,
+        std::shared_ptr<const void> backing) noexcept;
+
+    /**
+     * @brief Default Ctor, creates an empty table.
+     */
+    ElfSymbolTable() noexcept = default;
+
+    ElfSymbolTable(ElfSymbolTable&&) noexcept = default;
+    ElfSymbolTable& operator=(ElfSymbolTable&&) noexcept = default;
+    ElfSymbolTable(const ElfSymbolTable&) = delete;
+    ElfSymbolTable& operator=(const ElfSymbolTable&) = delete;
+
+    /**
+     * @brief Checks whether the table contains any symbols.
+     * @return A boolean indicating whether the table is empty.
+     */
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return m_entries.empty();
+    }
+
+    /**
+     * @brief Gets the number of indexed symbols.
+     * @return The number of entries.
+     */
+    [[nodiscard]] size_t size() const noexcept
+    {
+        return m_entries.size();
+    }
+
+    /**
+     * @brief Finds the function symbol whose range contains the given file address.
+     * @param address The address relative to the file's link-time layout.
+     * @return The (mangled) symbol, or std::nullopt if no symbol covers the address.
+     */
+    [[nodiscard]] std::optional<Symbol> lookup(uint64_t address) const noexcept;
+
+    /**
+     * @brief Gets the sorted index records, e.g. for serialization.
+     * @return A span over the entries.
+     */
+    [[nodiscard]] std::span<const Entry> entries() const noexcept
+    {
+        return m_entries;
+    }
+
+    /**
+     * @brief Gets the NUL-separated name blob the entries point into.
+     * @return A span over the names.
+     */
+    [[nodiscard]] std::span<const char> names() const noexcept
+    {
+        return m_names;
+    }
+
+private:
+    std::vector<Entry> m_ownedEntries;
+    std::vector<char> m_ownedNames;
+    std::shared_ptr<const void> m_backing;
+    std::span<const Entry> m_entries;
+    std::span<const char> m_names;
+
+    /**
+     * @brief Appends the function symbols of one symbol table section to the index.
+     * @param elf The mapped ELF file.
+     * @param symtab The SHT_SYMTAB or SHT_DYNSYM section to read.
+     */
+    void addSymbols(const ElfFile& elf, const ElfFile::Section& symtab);
+};
@@ -0,0 +1,9 @@
+#pragma once
+
+/// @brief MEXTRACE_API marks the classes libmexTrace.so exports; the library is built with hidden visibility,
+///        so everything else stays internal to it.
+#if defined(__GNUC__)
+#define MEXTRACE_API __attribute__((visibility("default")))
+#else
+#define MEXTRACE_API
+#endif
@@ -0,0 +1,98 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/types.h>
+#include "Export.h"
+#include "StackFrame.h"
+#include "StackSnapshot.h"
+#include "StackTrace.h"
+#include "TraceSession.h"
+
+class ThreadPool;
+
+/// @brief HangDetector samples all threads of a process over a window and reports the threads whose stacks
+///        never moved, the futexes they block on, and the lock cycles and convoys those waits form. \class HangDetector
+class MEXTRACE_API HangDetector
+{
+public:
+
+    using Error = StackTrace::Error;
+
+    /// @brief The number of samples taken over the window unless the caller asks for more.
+    static constexpr size_t defaultSamples = 5;
+
+    /// @brief StuckThread is a thread whose stack was identical in every sample. \struct StuckThread
+    struct StuckThread
+    {
+        pid_t tid{0};
+        std::string name;
+        std::optional<StackSnapshot::Syscall> syscall;
+        uintptr_t futexAddress{0};
+        pid_t owner{0};
+        std::vector<StackFrame> frames;
+    };
+
+    /// @brief Convoy is a lock with a known owner that several stuck threads wait on. \struct Convoy
+    struct Convoy
+    {
+        uintptr_t futexAddress{0};
+        pid_t owner{0};
+        std::vector<pid_t> waiters;
+    };
+
+    /// @brief Report is the result of one detection window. \struct Report
+    struct Report
+    {
+        std::chrono::nanoseconds window{0};
+        size_t samples{0};
+        size_t threadCount{0};
+        std::chrono::nanoseconds maxStop{0};
+        std::vector<StuckThread> stuck;
+        std::vector<Convoy> convoys;
+
+        /// @brief Each cycle lists the threads in wait order, starting at the lowest TID; every thread waits for the next.
+        std::vector<std::vector<pid_t>> cycles;
+
+        /**
+         * @brief Checks whether the window found a lock cycle or a convoy.
+         * @return A boolean indicating whether the process likely hangs.
+         */
+        [[nodiscard]] bool hangSuspected() const noexcept
+        {
+            return !cycles.empty() || !convoys.empty();
+        }
+    };
+
+    /**
+     * @brief Samples all threads of a process over a window. Stacks are compared raw; only the stuck
+     *        threads are symbolized, so a detection costs little more than the captures themselves.
+     * @param pid The process ID.
+     * @param options The capture options.
+     * @param window The time between the first and the last sample.
+     * @param samples The number of samples, at least two.
+     * @param pool The pool to symbolize the stuck threads on, or nullptr to resolve on the calling thread.
+     * @return A std::expected containing the report on success, or an Error code on failure.
+     */
+    [[nodiscard]] static std::expected<Report, Error> detect(
+        pid_t pid,
+        const TraceSession::Options& options,
+        std::chrono::nanoseconds window,
+        size_t samples = defaultSamples,
+        ThreadPool* pool = nullptr);
+
+    /**
+     * @brief Gets the name of a system call commonly seen in blocked threads.
+     * @param number The syscall number.
+     * @return The name, or an empty string_view if the syscall is not in the table.
+     */
+    [[nodiscard]] static std::string_view syscallName(int64_t number) noexcept;
+
+private:
+    ~HangDetector() = delete;
+};
@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+#include <expected>
+#include <limits>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/types.h>
+#include "Export.h"
+
+/// @brief ModuleMap is an interval index over the memory mappings of a process, as listed in /proc/pid/maps. \class ModuleMap
+class MEXTRACE_API ModuleMap
+{
+public:
+
+    static constexpr uint32_t noModule = std::numeric_limits<uint32_t>::max();
+
+    /// @brief Mapping is one line of /proc/pid/maps. \struct Mapping
+    struct Mapping
+    {
+        uintptr_t start{0};
+        uintptr_t end{0};
+        uint64_t offset{0};
+        bool readable{false};
+        bool writable{false};
+        bool executable{false};
+        uint32_t moduleId{noModule};
+        std::string name;
+    };
+
+    /**
+     * @brief Reads and indexes the mappings of a process.
+     * @param pid The process ID whose /proc/pid/maps to read.
+     * @return A std::expected containing the ModuleMap on success, or an error message on failure.
+     */
+    [[nodiscard]] static std::expected<ModuleMap, std::string> read(pid_t pid) noexcept;
+
+    /**
+     * @brief Indexes mappings from text in the /proc/pid/maps format.
+     * @param text The maps text.
+     * @return The ModuleMap, containing every line that could be parsed.
+     */
+    [[nodiscard]] static ModuleMap parse(std::string_view text);
+
+    /**
+     * @brief Finds the mapping containing an address.
+     * @param address The runtime address.
+     * @return A pointer to the mapping, or nullptr if the address is not mapped.
+     */
+    [[nodiscard]] const Mapping* find(uintptr_t address) const noexcept;
+
+    /**
+     * @brief Finds the first mapping with the given name, e.g. "[stack]".
+     * @param name The pathname or pseudo-name of the mapping.
+     * @return A pointer to the mapping, or nullptr if there is none.
+     */
+    [[nodiscard]] const Mapping* findByName(std::string_view name) const noexcept;
+
+    /**
+     * @brief Converts a runtime address to an offset into the file that backs its mapping.
+     * @param mapping The mapping containing the address.
+     * @param address The runtime address.
+     * @return The file offset.
+     */
+    [[nodiscard]] static uint64_t fileOffset(const Mapping& mapping, uintptr_t address) noexcept
+    {
+        return address - mapping.start + mapping.offset;
+    }
+
+    /**
+     * @brief Gets all mappings, sorted by start address.
+     * @return A span over the mappings.
+     */
+    [[nodiscard]] std::span<const Mapping> mappings() const noexcept
+    {
+        return m_mappings;
+    }
+
+    /**
+     * @brief Gets the paths of all file-backed modules, indexed by Mapping::moduleId.
+     * @return A span over the module paths.
+     */
+    [[nodiscard]] std::span<const std::string> modules() const noexcept
+    {
+        return m_modules;
+    }
+
+private:
+    std::vector<Mapping> m_mappings;
+    std::vector<std::string> m_modules;
+};
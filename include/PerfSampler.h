@@ -0,0 +1,149 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include "StackSnapshot.h"
+
+/// @brief PerfSampler samples the user stacks of a process with perf_event_open instead of stopping it. \class PerfSampler
+class PerfSampler
+{
+public:
+
+    /// @brief Sample is one decoded PERF_RECORD_SAMPLE, valid only during the drain callback. \struct Sample
+    struct Sample
+    {
+        pid_t tid{0};
+        std::span<const uintptr_t> callchain;
+        const StackSnapshot* snapshot{nullptr};
+    };
+
+    static constexpr size_t defaultStackBytes = 16 * 1024;
+    static constexpr size_t maxStackBytes = 65528;
+
+    /**
+     * @brief Opens one sampling event per thread of a process. The hardware cycle counter is used where
+     *        available, otherwise the software cpu-clock, so sampling also works in VMs without a PMU.
+     *        Per-thread events cannot be inherited and mmapped at once, so threads started later are not sampled.
+     *        The ring buffers are sized to fit the locked-memory budget of unprivileged users and shrunk further
+     *        when the kernel refuses a mapping; threads that still get none are counted by unsampledThreads().
+     * @param pid The process ID.
+     * @param frequency The number of samples per second and thread.
+     * @param stackBytes Bytes of user stack the kernel copies with every sample for DWARF unwinding,
+     *        or 0 to record only the kernel's frame-pointer callchain.
+     * @param maxFrames The maximum callchain depth.
+     * @return The sampler, disabled, or a description of why no event could be opened.
+     */
+    [[nodiscard]] static std::expected<PerfSampler, std::string> open(
+        pid_t pid,
+        uint32_t frequency,
+        size_t stackBytes,
+        size_t maxFrames);
+
+    /**
+     * @brief Move Ctor.
+     * @param other The sampler to take the events from.
+     */
+    PerfSampler(PerfSampler&& other) noexcept;
+
+    /**
+     * @brief Move assignment.
+     * @param other The sampler to take the events from.
+     * @return This sampler.
+     */
+    PerfSampler& operator=(PerfSampler&& other) noexcept;
+
+    PerfSampler(const PerfSampler&) = delete;
+    PerfSampler& operator=(const PerfSampler&) = delete;
+
+    /**
+     * @brief Destructor, unmaps the ring buffers and closes the events.
+     */
+    ~PerfSampler();
+
+    /**
+     * @brief Starts or stops counting on every event.
+     * @param enabled Whether samples should be taken.
+     */
+    void setEnabled(bool enabled) const noexcept;
+
+    /**
+     * @brief Waits until a ring buffer passes its wakeup watermark.
+     * @param timeout The longest time to wait.
+     */
+    void wait(std::chrono::milliseconds timeout) const noexcept;
+
+    /**
+     * @brief Decodes every pending record of every ring buffer and hands the samples to a callback.
+     * @param onSample Called once per sample.
+     */
+    void drain(const std::function<void(const Sample&)>& onSample);
+
+    /**
+     * @brief Checks whether the software clock fallback is in use.
+     * @return True if no hardware cycle counter was available.
+     */
+    [[nodiscard]] bool usesSoftwareClock() const noexcept
+    {
+        return m_softwareClock;
+    }
+
+    /**
+     * @brief Gets the number of samples the kernel dropped because a ring buffer was full.
+     * @return The lost sample count.
+     */
+    [[nodiscard]] uint64_t lostSamples() const noexcept
+    {
+        return m_lostSamples;
+    }
+
+    /**
+     * @brief Gets the number of threads that could not be sampled because no event or ring buffer could be set up for them.
+     * @return The unsampled thread count.
+     */
+    [[nodiscard]] size_t unsampledThreads() const noexcept
+    {
+        return m_unsampledThreads;
+    }
+
+private:
+
+    /// @brief Event is one perf event file descriptor and its mapped ring buffer. \struct Event
+    struct Event
+    {
+        int fd{-1};
+        void* ring{nullptr};
+        size_t ringBytes{0};
+    };
+
+    std::vector<Event> m_events;
+    bool m_softwareClock{false};
+    bool m_userStack{false};
+    uint64_t m_lostSamples{0};
+    size_t m_unsampledThreads{0};
+    std::vector<std::byte> m_record;
+    std::vector<uintptr_t> m_callchain;
+    StackSnapshot m_snapshot;
+
+    /**
+     * @brief Private Ctor, use open().
+     */
+    PerfSampler() = default;
+
+    /**
+     * @brief Unmaps the ring buffers and closes the events.
+     */
+    void closeEvents() noexcept;
+
+    /**
+     * @brief Decodes one record.
+     * @param record The complete record including its header.
+     * @param onSample Called if the record is a sample.
+     */
+    void handleRecord(std::span<const std::byte> record, const std::function<void(const Sample&)>& onSample);
+};
@@ -1,17 +1,32 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <cstddef>
 #include <cstdint>
 #include <expected>
 #include <optional>
+#include <span>
+#include <string_view>
 #include <sys/types.h>
+#include "ModuleMap.h"
 #include "StackFrame.h"
+#include "StackSnapshot.h"
+#include "Unwinder.h"
+
+class ThreadPool;
 
 /// @brief PlatformUtils is a utility class providing platform-specific functions for process management and symbol resolution. \class PlatformUtils
 class PlatformUtils
 {
 public:
 
+    /// @brief StoppedThread is a thread held in a ptrace stop, with a signal to re-inject when it is released. \struct StoppedThread
+    struct StoppedThread
+    {
+        pid_t tid{0};
+        int pendingSignal{0};
+    };
+
     /**
      * @brief Checks if a process with the given PID is currently running.
      * @param pid The process ID to check.
@@ -45,6 +60,68 @@ public:
      */
     static void detachFromProcess(pid_t pid) noexcept;
 
+    /**
+     * @brief Lists the threads of a process from /proc/pid/task.
+     * @param pid The process ID.
+     * @return The thread IDs, empty if the process does not exist.
+     */
+    [[nodiscard]] static std::vector<pid_t> listThreads(pid_t pid) noexcept;
+
+    /**
+     * @brief Retrieves the name of a thread.
+     * @param pid The process ID the thread belongs to.
+     * @param tid The thread ID.
+     * @return An optional string containing the thread name, or std::nullopt if not found.
+     */
+    [[nodiscard]] static std::optional<std::string> getThreadName(pid_t pid, pid_t tid) noexcept;
+
+    /**
+     * @brief Reads the system call a thread is blocked in from /proc/pid/task/tid/syscall.
+     * @param pid The process ID the thread belongs to.
+     * @param tid The thread ID.
+     * @return The syscall and its arguments, number StackSnapshot::notInSyscall if the thread runs user code,
+     *         or std::nullopt if the file cannot be read.
+     */
+    [[nodiscard]] static std::optional<StackSnapshot::Syscall> readThreadSyscall(pid_t pid, pid_t tid) noexcept;
+
+    /**
+     * @brief Parses the contents of /proc/pid/task/tid/syscall.
+     * @param text The file contents.
+     * @return The syscall and its arguments, number StackSnapshot::notInSyscall if the thread runs user code,
+     *         or std::nullopt if the text is malformed.
+     */
+    [[nodiscard]] static std::optional<StackSnapshot::Syscall> parseSyscall(std::string_view text) noexcept;
+
+    /**
+     * @brief Stops a single thread with PTRACE_SEIZE and PTRACE_INTERRUPT. Unlike attachToProcess,
+     *        no SIGSTOP is sent, so the other threads of the process keep running.
+     * @param tid The thread ID.
+     * @return The stopped thread, or std::nullopt if it cannot be seized; release it with releaseThreads.
+     */
+    [[nodiscard]] static std::optional<StoppedThread> stopThread(pid_t tid) noexcept;
+
+    /**
+     * @brief Stops every thread of a process with PTRACE_SEIZE and PTRACE_INTERRUPT.
+     *        All threads are interrupted before waiting on any of them, so they stop concurrently;
+     *        /proc/pid/task is rescanned to pick up threads created meanwhile.
+     * @param pid The process ID.
+     * @return The stopped threads, empty if none could be seized.
+     */
+    [[nodiscard]] static std::vector<StoppedThread> stopAllThreads(pid_t pid) noexcept;
+
+    /**
+     * @brief Stops every thread of a process like stopAllThreads(pid), reusing the caller's list.
+     * @param pid The process ID.
+     * @param stopped Cleared, then receives the stopped threads; empty if none could be seized.
+     */
+    static void stopAllThreads(pid_t pid, std::vector<StoppedThread>& stopped) noexcept;
+
+    /**
+     * @brief Detaches from threads stopped by stopAllThreads, letting them run again.
+     * @param threads The stopped threads.
+     */
+    static void releaseThreads(std::span<const StoppedThread> threads) noexcept;
+
     /**
      * @brief Gets the executable path of a process by its PID.
      * @param pid The process ID for which to retrieve the executable path.
@@ -52,12 +129,148 @@ public:
      */
     [[nodiscard]] static std::optional<std::string> getExecutablePath(pid_t pid) noexcept;
 
+    static constexpr size_t defaultStackSnapshotBytes = 256 * 1024;
+    static constexpr size_t defaultMaxFrames = 64;
+
+    /// @brief The function name given to frames whose module could not be symbolized, e.g. because indexing it ran out of memory.
+    static constexpr std::string_view symbolizationFailed = "<symbolization failed>";
+
     /**
      * @brief Read the process stack.
      * @param pid The process ID for which to retrieve the Stack
+     * @param maxStackBytes The maximum number of stack bytes to copy from the stack pointer upwards.
+     * @param method The unwinding method.
      * @return A vector of stackframes
      */
-    [[nodiscard]] static std::vector<StackFrame> readProcessStack(pid_t pid) noexcept;
+    [[nodiscard]] static std::vector<StackFrame> readProcessStack(
+        pid_t pid,
+        size_t maxStackBytes = defaultStackSnapshotBytes,
+        Unwinder::Method method = Unwinder::Method::Dwarf) noexcept;
+
+    /**
+     * @brief Captures the raw return addresses of a ptrace-stopped thread without symbolizing them.
+     * @param pid The stopped process (or thread) ID.
+     * @param modules The mappings of the process.
+     * @param maxStackBytes The maximum number of stack bytes to copy from the stack pointer upwards.
+     * @param method The unwinding method.
+     * @param maxFrames The maximum number of addresses to return.
+     * @return The program counter followed by the return addresses, empty if the registers cannot be read.
+     */
+    [[nodiscard]] static std::vector<uintptr_t> readProcessAddresses(
+        pid_t pid,
+        const ModuleMap& modules,
+        size_t maxStackBytes = defaultStackSnapshotBytes,
+        Unwinder::Method method = Unwinder::Method::Dwarf,
+        size_t maxFrames = defaultMaxFrames) noexcept;
+
+    /**
+     * @brief Reads memory of another process with process_vm_readv, falling back to /proc/pid/mem.
+     * @param pid The process (or thread) ID to read from.
+     * @param address The start address in the target.
+     * @param buffer The local buffer to fill.
+     * @return The number of bytes read, which stops short at the first unreadable page.
+     */
+    [[nodiscard]] static size_t readMemory(pid_t pid, uintptr_t address, std::span<std::byte> buffer) noexcept;
+
+    /**
+     * @brief Copies the registers and the top of the stack of a ptrace-stopped thread.
+     * @param tid The stopped thread ID.
+     * @param maxStackBytes The maximum number of bytes to copy from the stack pointer upwards.
+     * @param modules The mappings of the process used to clamp the copy to the stack mapping, may be nullptr.
+     * @return The snapshot, or std::nullopt if the registers cannot be read.
+     */
+    [[nodiscard]] static std::optional<StackSnapshot> captureStackSnapshot(
+        pid_t tid,
+        size_t maxStackBytes = defaultStackSnapshotBytes,
+        const ModuleMap* modules = nullptr) noexcept;
+
+    /**
+     * @brief Copies the registers and the top of the stack of a ptrace-stopped thread into an existing snapshot,
+     *        reusing its stack buffer so repeated captures do not allocate.
+     * @param tid The stopped thread ID.
+     * @param maxStackBytes The maximum number of bytes to copy from the stack pointer upwards.
+     * @param modules The mappings of the process used to clamp the copy to the stack mapping, may be nullptr.
+     * @param snapshot The snapshot to overwrite.
+     * @return A boolean indicating whether the registers could be read.
+     */
+    [[nodiscard]] static bool captureStackSnapshot(
+        pid_t tid,
+        size_t maxStackBytes,
+        const ModuleMap* modules,
+        StackSnapshot& snapshot) noexcept;
+
+    /**
+     * @brief Copies the registers and the top of the stack of many ptrace-stopped threads. ptrace only answers the
+     *        tracing thread, so the registers are read here one thread after another; the stack copies, which take
+     *        most of the stop, do not need ptrace and are split across the pool.
+     * @param threads The stopped threads.
+     * @param maxStackBytes The maximum number of bytes to copy per thread from the stack pointer upwards.
+     * @param modules The mappings of the process used to clamp the copies to the stack mappings, may be nullptr.
+     * @param snapshots The snapshots to overwrite, one per thread, reusing their stack buffers.
+     * @param captured Receives for each thread whether its registers could be read.
+     * @param pool The pool to copy the stacks on, or nullptr to copy them on the calling thread.
+     */
+    static void captureStackSnapshots(
+        std::span<const StoppedThread> threads,
+        size_t maxStackBytes,
+        const ModuleMap* modules,
+        std::span<StackSnapshot> snapshots,
+        std::span<uint8_t> captured,
+        ThreadPool* pool = nullptr) noexcept;
+
+    /**
+     * @brief Walks the frame-pointer chain of a snapshot; the walk ends at the first frame outside the copy.
+     * @param snapshot The register and stack snapshot.
+     * @param maxFrames The maximum number of addresses to return.
+     * @return The program counter followed by the return addresses.
+     */
+    [[nodiscard]] static std::vector<uintptr_t> walkFramePointers(const StackSnapshot& snapshot, size_t maxFrames = defaultMaxFrames) noexcept;
+
+    /**
+     * @brief Symbolizes runtime addresses of a process, resolving each against the module mapped at it.
+     *        Addresses are grouped per module and translated by the module's load bias before lookup.
+     * @param pid The process ID the addresses belong to.
+     * @param addresses The program counter followed by the return addresses of a stack.
+     * @return One StackFrame per address, carrying the original runtime address.
+     */
+    [[nodiscard]] static std::vector<StackFrame> resolveProcessAddresses(pid_t pid, std::span<const uintptr_t> addresses) noexcept;
+
+    /**
+     * @brief Symbolizes runtime addresses against an already read module map.
+     * @param modules The mappings of the process the addresses belong to.
+     * @param addresses The program counter followed by the return addresses of a stack.
+     * @param pool The pool to shard the lookups across, or nullptr to resolve on the calling thread.
+     * @return One StackFrame per address, carrying the original runtime address.
+     */
+    [[nodiscard]] static std::vector<StackFrame> resolveProcessAddresses(
+        const ModuleMap& modules,
+        std::span<const uintptr_t> addresses,
+        ThreadPool* pool = nullptr) noexcept;
+
+    /**
+     * @brief Symbolizes exact runtime addresses against a module map, without the return-address adjustment.
+     * @param modules The mappings of the process the addresses belong to.
+     *        Large batches are split into per-module shards that are resolved concurrently on the pool.
+     * @param addresses The addresses to look up, e.g. produced by callSiteAddress.
+     * @param pool The pool to shard the lookups across, or nullptr to resolve on the calling thread.
+     * @return One StackFrame per address. Frames of a module that failed to load or index are named symbolizationFailed.
+     */
+    [[nodiscard]] static std::vector<StackFrame> resolveModuleAddresses(
+        const ModuleMap& modules,
+        std::span<const uintptr_t> addresses,
+        ThreadPool* pool = nullptr) noexcept;
+
+    /**
+     * @brief Gets the address to symbolize for a stack entry: the program counter itself,
+     *        or one byte before a return address so the lookup lands on the call instruction.
+     * @param stack The program counter followed by the return addresses.
+     * @param index The index of the entry.
+     * @return The lookup address.
+     */
+    [[nodiscard]] static uintptr_t callSiteAddress(const std::span<const uintptr_t> stack, const size_t index) noexcept
+    {
+        return index == 0 ? stack[index] : stack[index] - 1;
+    }
 
     /**
      * @brief Resolves a symbolic link to its target path.
@@ -73,7 +286,8 @@ public:
     [[nodiscard]] static bool isAddr2lineAvailable() noexcept;
 
     /**
-     * @brief Resolves a memory address to a StackFrame using 'addr2line'.
+     * @brief Resolves a memory address to a StackFrame using the in-process ELF symbolizer,
+     *        falling back to 'addr2line' when the binary carries no symbol tables.
      * @param execPath The path to the executable.
      * @param address The memory address to resolve.
      * @return A StackFrame object containing the resolved information.
@@ -82,6 +296,21 @@ public:
 
 private:
 
+    /**
+     * @brief Waits for a seized thread to report its ptrace stop.
+     * @param tid The thread ID.
+     * @return The stopped thread, or std::nullopt if it exited instead.
+     */
+    [[nodiscard]] static std::optional<StoppedThread> waitForStop(pid_t tid) noexcept;
+
+    /**
+     * @brief Resolves a memory address to a StackFrame by spawning 'addr2line'.
+     * @param execPath The path to the executable.
+     * @param address The memory address to resolve.
+     * @return A StackFrame object containing the resolved information.
+     */
+    [[nodiscard]] static StackFrame resolveWithAddr2line(std::string_view execPath, uintptr_t address) noexcept;
+
     /**
      * @brief Private destructor to prevent deletion of this utility class.
      */
@@ -0,0 +1,133 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/types.h>
+#include "Export.h"
+#include "StackSnapshot.h"
+
+class ThreadPool;
+
+/// @brief ProcessScanner enumerates /proc with raw openat/read calls into reused buffers. \class ProcessScanner
+class MEXTRACE_API ProcessScanner
+{
+public:
+
+    /// @brief ProcessInfo is one row of the process table. \struct ProcessInfo
+    struct ProcessInfo
+    {
+        pid_t pid{0};
+        pid_t parentPid{0};
+        uid_t uid{0};
+        char state{'?'};
+        uint32_t threads{0};
+        uint64_t rssBytes{0};
+        uint64_t cpuTicks{0};
+        std::string name;
+
+        /**
+         * @brief Gets the user plus system CPU time consumed so far.
+         * @return The CPU time in seconds.
+         */
+        [[nodiscard]] double cpuSeconds() const noexcept;
+    };
+
+    /// @brief ThreadInfo is the scheduler state of one thread: what it is doing and how much it ran and waited. \struct ThreadInfo
+    struct ThreadInfo
+    {
+        pid_t tid{0};
+        char state{'?'};
+        std::string wchan;
+        std::optional<StackSnapshot::Syscall> syscall;
+        uint64_t voluntarySwitches{0};
+        uint64_t involuntarySwitches{0};
+        std::chrono::nanoseconds runTime{0};
+        std::chrono::nanoseconds runQueueTime{0};
+    };
+
+    /// @brief Enum selecting the column the table is sorted by. \enum SortKey
+    enum class SortKey : uint8_t
+    {
+        Pid,
+        Parent,
+        Name,
+        State,
+        Threads,
+        Rss,
+        Cpu
+    };
+
+    /**
+     * @brief Ctor, opens /proc once for the lifetime of the scanner.
+     */
+    ProcessScanner() noexcept;
+
+    /**
+     * @brief Destructor, closes /proc.
+     */
+    ~ProcessScanner();
+
+    ProcessScanner(const ProcessScanner&) = delete;
+    ProcessScanner& operator=(const ProcessScanner&) = delete;
+
+    /**
+     * @brief Reads stat and status of every process. Processes that exit during the scan are skipped.
+     * @param pool The pool to spread large scans across, or nullptr to scan on the calling thread.
+     * @return The process table ordered by PID, empty if /proc cannot be opened.
+     */
+    [[nodiscard]] std::vector<ProcessInfo> scan(ThreadPool* pool = nullptr) const;
+
+    /**
+     * @brief Reads stat and status of one process.
+     * @param pid The process ID.
+     * @return The row, or std::nullopt if the process does not exist.
+     */
+    [[nodiscard]] std::optional<ProcessInfo> read(pid_t pid) const;
+
+    /**
+     * @brief Reads stat, wchan, syscall, status and schedstat of threads of one process in one batch;
+     *        /proc/pid/task is opened once and every file is read relative to it.
+     * @param pid The process ID.
+     * @param tids The thread IDs.
+     * @return One entry per thread that still exists, in the order of tids.
+     */
+    [[nodiscard]] std::vector<ThreadInfo> readThreads(pid_t pid, std::span<const pid_t> tids) const;
+
+    /**
+     * @brief Sorts a process table.
+     * @param processes The table to sort.
+     * @param key The column to sort by.
+     * @param descending Whether to put the largest values first.
+     */
+    static void sort(std::span<ProcessInfo> processes, SortKey key, bool descending) noexcept;
+
+    /**
+     * @brief Parses a sort column name.
+     * @param name One of pid, ppid, name, state, threads, rss or cpu.
+     * @return The sort key, or std::nullopt if the name is unknown.
+     */
+    [[nodiscard]] static std::optional<SortKey> parseSortKey(std::string_view name) noexcept;
+
+private:
+    int m_procFd{-1};
+
+    /**
+     * @brief Lists the numeric entries of /proc with getdents64.
+     * @return The PIDs in directory order.
+     */
+    [[nodiscard]] std::vector<pid_t> listPids() const;
+
+    /**
+     * @brief Reads a file below a process directory into a caller buffer.
+     * @param pid The process ID.
+     * @param file The file name, e.g. "stat".
+     * @param buffer The buffer to fill.
+     * @return The bytes read, empty on failure.
+     */
+    [[nodiscard]] std::string_view readProcFile(pid_t pid, std::string_view file, std::span<char> buffer) const noexcept;
+};
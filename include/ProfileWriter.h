@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include "Export.h"
+#include "StackProfile.h"
+
+/// @brief ProfileWriter serializes an aggregated StackProfile for external flame graph and pprof tooling. \class ProfileWriter
+class MEXTRACE_API ProfileWriter
+{
+public:
+
+    /**
+     * @brief Writes the profile as folded stacks ("root;caller;leaf count" per line), as consumed by flamegraph.pl.
+     * @param os The output stream.
+     * @param profile The aggregated, symbolized profile.
+     */
+    static void writeFolded(std::ostream& os, const StackProfile& profile);
+
+    /**
+     * @brief Writes the profile as an uncompressed pprof protobuf message with deduplicated
+     *        string, function and location tables.
+     * @param os The output stream, opened in binary mode.
+     * @param profile The aggregated, symbolized profile.
+     * @param frequency The sampling rate in Hz, used for the cpu sample value and period.
+     */
+    static void writePprof(std::ostream& os, const StackProfile& profile, uint32_t frequency);
+
+private:
+
+    /**
+     * @brief Private destructor to prevent deletion of this utility class.
+     */
+    ~ProfileWriter() = delete;
+};
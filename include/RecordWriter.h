@@ -0,0 +1,184 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <sys/types.h>
+#include "Export.h"
+#include "ProcessScanner.h"
+#include "StackFrame.h"
+
+/// @brief RecordWriter streams captured stacks as JSON Lines or length-prefixed binary records, one record per stack. \class RecordWriter
+class MEXTRACE_API RecordWriter
+{
+public:
+
+    /// @brief Enum selecting the encoding of the records. \enum Format
+    enum class Format : uint8_t
+    {
+        JsonLines,
+        Binary
+    };
+
+    /// @brief Record is one captured stack of one thread. \struct Record
+    struct Record
+    {
+        pid_t pid{0};
+        pid_t tid{0};
+        std::chrono::system_clock::time_point timestamp;
+        std::span<const StackFrame> frames;
+        const ProcessScanner::ThreadInfo* state{nullptr};
+    };
+
+    /// @brief Enum identifying the binary records. \enum RecordType
+    enum class RecordType : uint16_t
+    {
+        FileHeader = 1,
+        String = 2,
+        Stack = 3,
+        ThreadState = 4
+    };
+
+    /// @brief BinaryHeader starts every binary record. The length includes this header and the padding
+    ///        that keeps the next record 8-byte aligned, so a mapped file can be walked by length alone. \struct BinaryHeader
+    struct BinaryHeader
+    {
+        uint32_t length{0};
+        RecordType type{RecordType::FileHeader};
+        uint16_t reserved{0};
+    };
+
+    /// @brief BinaryFileHeader is the payload of the first record of a binary stream. \struct BinaryFileHeader
+    struct BinaryFileHeader
+    {
+        std::array<char, 8> magic{};
+        uint32_t version{0};
+        uint32_t reserved{0};
+    };
+
+    /// @brief BinaryString defines a string id before its first use; the characters follow it. \struct BinaryString
+    struct BinaryString
+    {
+        uint32_t id{0};
+        uint32_t size{0};
+    };
+
+    /// @brief BinaryStack is the payload of a stack record; frameCount BinaryFrames follow it. \struct BinaryStack
+    struct BinaryStack
+    {
+        int32_t pid{0};
+        int32_t tid{0};
+        uint64_t timestampNs{0};
+        uint32_t frameCount{0};
+        uint32_t reserved{0};
+    };
+
+    /// @brief BinaryFrame is one frame of a stack record; the ids refer to earlier string records, noString if unknown. \struct BinaryFrame
+    struct BinaryFrame
+    {
+        uint64_t address{0};
+        uint32_t moduleId{0};
+        uint32_t functionId{0};
+        uint32_t fileId{0};
+        uint32_t line{0};
+    };
+
+    /// @brief BinaryThreadState precedes the stack record of a thread whose scheduler state was captured. \struct BinaryThreadState
+    struct BinaryThreadState
+    {
+        int32_t tid{0};
+        char state{'?'};
+        std::array<uint8_t, 3> reserved{};
+        uint32_t wchanId{0};
+        uint32_t reserved2{0};
+        int64_t syscall{0};
+        std::array<uint64_t, 6> syscallArgs{};
+        uint64_t voluntarySwitches{0};
+        uint64_t involuntarySwitches{0};
+        uint64_t runNs{0};
+        uint64_t runQueueNs{0};
+    };
+
+    /// @brief The syscall of a BinaryThreadState whose syscall could not be read.
+    static constexpr int64_t unknownSyscall = -2;
+
+    /// @brief The magic and format version of the binary stream.
+    static constexpr std::array<char, 8> binaryMagic{'m', 'e', 'x', 'S', 't', 'a', 'c', 'k'};
+    static constexpr uint32_t binaryVersion = 1;
+
+    /// @brief The string id of an unknown module, function or file.
+    static constexpr uint32_t noString = 0;
+
+    /**
+     * @brief Ctor, writes the file header of the binary format.
+     * @param os The output stream, opened in binary mode for the binary format.
+     * @param format The encoding.
+     */
+    RecordWriter(std::ostream& os, Format format);
+
+    /**
+     * @brief Writes one stack and flushes it, preceded by the module and string definitions it needs that were not written yet,
+     *        and by the thread state if the record carries one.
+     * @param record The stack.
+     */
+    void write(const Record& record);
+
+    /**
+     * @brief Parses a record format name.
+     * @param name Either "jsonl" or "binary".
+     * @return The format, or std::nullopt if the name is not a record format.
+     */
+    [[nodiscard]] static std::optional<Format> parseFormat(std::string_view name) noexcept;
+
+private:
+    std::ostream& m_outputStream;
+    Format m_format;
+    std::unordered_map<uint32_t, uint32_t> m_stringIds;
+    uint32_t m_nextStringId{1};
+    std::string m_buffer;
+
+    /**
+     * @brief Maps an interned string to its id in this stream, defining it on first use: as a string record
+     *        in the binary format, as a module record in JSON Lines, where only module paths are referred to by id.
+     * @param internedId The StringInterner id.
+     * @return The stream id, noString for the empty string.
+     */
+    uint32_t streamId(uint32_t internedId);
+
+    /**
+     * @brief Appends a string as a quoted, escaped JSON string.
+     * @param text The string.
+     */
+    void appendJsonString(std::string_view text);
+
+    /**
+     * @brief Appends the "state" member of a JSON stack record.
+     * @param state The scheduler state of the thread.
+     */
+    void appendJsonState(const ProcessScanner::ThreadInfo& state);
+
+    /**
+     * @brief Appends a thread state record of the binary format.
+     * @param state The scheduler state of the thread.
+     */
+    void appendBinaryState(const ProcessScanner::ThreadInfo& state);
+
+    /**
+     * @brief Appends a binary record header and payload, padded to 8 bytes.
+     * @param type The record type.
+     * @param payload The fixed part of the payload.
+     * @param tail The variable part following it.
+     */
+    void appendBinary(RecordType type, std::span<const std::byte> payload, std::span<const std::byte> tail = {});
+
+    /**
+     * @brief Writes the buffered records to the stream and flushes it.
+     */
+    void flush();
+};
@@ -0,0 +1,143 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+#include "Export.h"
+#include "ModuleMap.h"
+#include "StackFrame.h"
+
+class ThreadPool;
+
+/// @brief SelfTrace records raw stacks of the calling process into preallocated slots and symbolizes them later.
+///        Capturing is async-signal-safe only on glibc 2.35 and later, where the unwinder finds .eh_frame through
+///        _dl_find_object; older glibc walks the loaded objects under the loader lock, which a signal may interrupt. \class SelfTrace
+class MEXTRACE_API SelfTrace
+{
+public:
+
+    /// @brief Handle identifies one recorded stack; it is invalidated once its slot is reused. \struct Handle
+    struct Handle
+    {
+        uint64_t ticket{0};
+
+        [[nodiscard]] bool valid() const noexcept
+        {
+            return ticket != 0;
+        }
+    };
+
+    /**
+     * @brief Writes the return addresses of the calling thread into a caller-provided buffer.
+     *        Async-signal-safe once prepare() has run and on glibc 2.35 or later: it neither allocates nor takes locks.
+     * @param addresses Receives the program counter of the caller followed by the return addresses; its size is the frame limit.
+     * @param skip The number of innermost callers to leave out, e.g. wrappers around this call.
+     * @return The number of addresses written.
+     */
+    [[nodiscard]] static size_t captureInto(std::span<uintptr_t> addresses, size_t skip = 0) noexcept;
+
+    /**
+     * @brief Loads and initializes the unwinder. Must run outside of signal handlers before the first
+     *        captureInto() from one; the ctor calls it.
+     */
+    static void prepare() noexcept;
+
+    /**
+     * @brief Ctor, allocates all slots up front.
+     * @param slots The number of stacks kept before the oldest is overwritten.
+     * @param maxFrames The frame limit per stack.
+     */
+    explicit SelfTrace(size_t slots = 64, size_t maxFrames = 64);
+
+    /**
+     * @brief Destructor.
+     */
+    ~SelfTrace() = default;
+
+    SelfTrace(const SelfTrace&) = delete;
+    SelfTrace& operator=(const SelfTrace&) = delete;
+
+    /**
+     * @brief Records the stack of the calling thread into the next slot. Lock-free, and async-signal-safe on glibc 2.35
+     *        or later, so it may run on hot paths and inside signal handlers, concurrently from several threads.
+     *        The slot is claimed with a compare-and-swap on its ticket; if another capture is still writing it, or a newer
+     *        one has already filled it, the stack is dropped rather than waited for.
+     * @param skip The number of innermost callers to leave out.
+     * @return A handle to the recorded stack, invalid if the stack was dropped.
+     */
+    [[nodiscard]] Handle capture(size_t skip = 0) noexcept;
+
+    /**
+     * @brief Copies the raw addresses of a recorded stack out of its slot. The ticket is checked again after the copy,
+     *        so a stack overwritten meanwhile is never returned torn.
+     * @param handle A handle returned by capture().
+     * @return The program counter followed by the return addresses, empty if the slot has been reused since.
+     */
+    [[nodiscard]] std::vector<uintptr_t> addresses(Handle handle) const;
+
+    /**
+     * @brief Symbolizes a recorded stack. Every call site is resolved at most once per instance.
+     * @param handle A handle returned by capture().
+     * @param pool The pool to resolve unseen call sites on, or nullptr to resolve on the calling thread.
+     * @return One StackFrame per address, empty if the slot has been reused since.
+     */
+    [[nodiscard]] std::vector<StackFrame> symbolize(Handle handle, ThreadPool* pool = nullptr);
+
+    /**
+     * @brief Symbolizes many recorded stacks in one batch, resolving their distinct call sites together.
+     * @param handles Handles returned by capture().
+     * @param pool The pool to resolve unseen call sites on, or nullptr to resolve on the calling thread.
+     * @return One frame list per handle, empty for handles whose slot has been reused since.
+     */
+    [[nodiscard]] std::vector<std::vector<StackFrame>> symbolize(std::span<const Handle> handles, ThreadPool* pool = nullptr);
+
+    /**
+     * @brief Symbolizes a raw stack of this process, e.g. one written by captureInto().
+     * @param stack The program counter followed by the return addresses.
+     * @param pool The pool to resolve unseen call sites on, or nullptr to resolve on the calling thread.
+     * @return One StackFrame per address carrying the raw address.
+     */
+    [[nodiscard]] std::vector<StackFrame> symbolize(std::span<const uintptr_t> stack, ThreadPool* pool = nullptr);
+
+private:
+
+    /// @brief Slot is the bookkeeping of one preallocated stack. The ticket doubles as the sequence of a seqlock:
+    ///        it carries writingBit while a capture fills the slot. \struct Slot
+    struct Slot
+    {
+        std::atomic<uint64_t> ticket{0};
+        std::atomic<uint32_t> count{0};
+    };
+
+    /// @brief Set in a slot's ticket while a capture writes it.
+    static constexpr uint64_t writingBit = uint64_t{1} << 63;
+
+    size_t m_slotCount;
+    size_t m_maxFrames;
+    std::unique_ptr<Slot[]> m_slots;
+    std::unique_ptr<uintptr_t[]> m_addresses;
+    std::atomic<uint64_t> m_nextTicket{1};
+
+    std::mutex m_mutex;
+    std::optional<ModuleMap> m_modules;
+    std::unordered_map<uintptr_t, StackFrame> m_frames;
+
+    /**
+     * @brief Resolves the call sites of the given stacks that have not been seen yet. Must be called with the mutex held.
+     * @param stacks The raw stacks.
+     * @param pool The pool to resolve on, or nullptr.
+     */
+    void resolvePending(std::span<const std::span<const uintptr_t>> stacks, ThreadPool* pool);
+
+    /**
+     * @brief Builds the frames of a stack from the memoized call sites. Must be called with the mutex held.
+     * @param stack The raw stack.
+     * @return One StackFrame per address carrying the raw address.
+     */
+    [[nodiscard]] std::vector<StackFrame> framesOf(std::span<const uintptr_t> stack) const;
+};
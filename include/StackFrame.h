@@ -1,11 +1,14 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
-#include <string>
 #include <string_view>
 #include <compare>
+#include "Export.h"
+#include "StringInterner.h"
 
-/// @brief StackFrame represents a single frame in a stack trace, containing information about the function, source file, and line number. \class StackFrame
-class StackFrame
+/// @brief StackFrame represents a single frame in a stack trace, containing information about the function, source file, and line number.
+///        Names are interned, so a frame is a small fixed-size record of ids. \class StackFrame
+class MEXTRACE_API StackFrame
 {
 public:
 
@@ -18,9 +21,9 @@ public:
      */
     explicit StackFrame(
         uintptr_t addr,
-        std::string  func = {},
-        std::string  file = {},
-        size_t line = 0) noexcept;
+        std::string_view func = {},
+        std::string_view file = {},
+        size_t line = 0);
 
     /**
      * @brief Default constructor.
@@ -42,7 +45,7 @@ public:
      */
     [[nodiscard]] std::string_view getFunctionName() const noexcept
     {
-        return m_functionName;
+        return StringInterner::instance().view(m_functionId);
     }
 
     /**
@@ -51,7 +54,43 @@ public:
      */
     [[nodiscard]] std::string_view getSourceFile() const noexcept
     {
-        return m_sourceFile;
+        return StringInterner::instance().view(m_fileId);
+    }
+
+    /**
+     * @brief Gets the path of the module the address belongs to.
+     * @return A string_view representing the module path, empty if unknown.
+     */
+    [[nodiscard]] std::string_view getModule() const noexcept
+    {
+        return StringInterner::instance().view(m_moduleId);
+    }
+
+    /**
+     * @brief Gets the interned id of the module path, equal for equal paths.
+     * @return The StringInterner id.
+     */
+    [[nodiscard]] constexpr uint32_t getModuleId() const noexcept
+    {
+        return m_moduleId;
+    }
+
+    /**
+     * @brief Gets the interned id of the function name, equal for equal names.
+     * @return The StringInterner id.
+     */
+    [[nodiscard]] constexpr uint32_t getFunctionId() const noexcept
+    {
+        return m_functionId;
+    }
+
+    /**
+     * @brief Gets the interned id of the source file, equal for equal paths.
+     * @return The StringInterner id.
+     */
+    [[nodiscard]] constexpr uint32_t getSourceFileId() const noexcept
+    {
+        return m_fileId;
     }
 
     /**
@@ -67,22 +106,34 @@ public:
      * @brief Checks if this StackFrame has valid symbol information (function name).
      * @return A boolean indicating whether the StackFrame has symbol information.
      */
-    [[nodiscard]] bool hasSymbolInfo() const noexcept
+    [[nodiscard]] constexpr bool hasSymbolInfo() const noexcept
     {
-        return !m_functionName.empty();
+        return m_functionId != StringInterner::emptyId;
     }
 
+    /**
+     * @brief Sets the memory address of this StackFrame.
+     * @param addr The address to set.
+     */
+    void setAddress(uintptr_t addr) noexcept;
+
     /**
      * @brief Sets the function name for this StackFrame.
      * @param name The function name to set.
      */
-    void setFunctionName(std::string name) noexcept;
+    void setFunctionName(std::string_view name);
 
     /**
      * @brief Sets the source file for this StackFrame.
      * @param file The source file to set.
      */
-    void setSourceFile(std::string file) noexcept;
+    void setSourceFile(std::string_view file);
+
+    /**
+     * @brief Sets the module path for this StackFrame.
+     * @param path The module path to set.
+     */
+    void setModule(std::string_view path);
 
     /**
      * @brief Sets the line number for this StackFrame.
@@ -99,7 +150,10 @@ public:
 
 private:
     uintptr_t m_address{0};
-    std::string m_functionName;
-    std::string m_sourceFile;
-    size_t m_lineNumber{0};
-};
\ No newline at end of file
+    uint32_t m_moduleId{StringInterner::emptyId};
+    uint32_t m_functionId{StringInterner::emptyId};
+    uint32_t m_fileId{StringInterner::emptyId};
+    uint32_t m_lineNumber{0};
+};
+
+static_assert(sizeof(StackFrame) <= 24, "StackFrame should stay a compact record of interned ids");
\ No newline at end of file
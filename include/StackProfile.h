@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+#include "Export.h"
+#include "ModuleMap.h"
+#include "StackFrame.h"
+
+class ThreadPool;
+
+/// @brief StackProfile aggregates sampled raw stacks by their address sequence and symbolizes each address once. \class StackProfile
+class MEXTRACE_API StackProfile
+{
+public:
+
+    /// @brief AddressHash hashes a raw address sequence. \struct AddressHash
+    struct AddressHash
+    {
+        [[nodiscard]] size_t operator()(std::span<const uintptr_t> stack) const noexcept;
+    };
+
+    using StackCounts = std::unordered_map<std::vector<uintptr_t>, uint64_t, AddressHash>;
+
+    /**
+     * @brief Counts one occurrence of a raw stack.
+     * @param stack The program counter followed by the return addresses.
+     * @param count The number of samples to add.
+     * @return The stored copy of the stack, which stays at the same address until the profile is destroyed.
+     */
+    const std::vector<uintptr_t>& add(std::span<const uintptr_t> stack, uint64_t count = 1);
+
+    /**
+     * @brief Gets the number of samples added.
+     * @return The total sample count.
+     */
+    [[nodiscard]] uint64_t totalSamples() const noexcept
+    {
+        return m_totalSamples;
+    }
+
+    /**
+     * @brief Gets the distinct stacks with their sample counts.
+     * @return The aggregated stacks.
+     */
+    [[nodiscard]] const StackCounts& stacks() const noexcept
+    {
+        return m_stacks;
+    }
+
+    /**
+     * @brief Gets the distinct stacks ordered by descending sample count.
+     * @return Pointers into stacks(), valid until the next add().
+     */
+    [[nodiscard]] std::vector<const StackCounts::value_type*> sortedByCount() const;
+
+    /**
+     * @brief Symbolizes every distinct call site of the aggregated stacks once.
+     * @param modules The mappings of the sampled process.
+     * @param pool The pool to resolve the call sites on, or nullptr to resolve on the calling thread.
+     */
+    void symbolize(const ModuleMap& modules, ThreadPool* pool = nullptr);
+
+    /**
+     * @brief Gets the symbolized frames of an aggregated stack.
+     * @param stack One of the stacks returned by stacks().
+     * @return One StackFrame per address carrying the raw address, unresolved if symbolize() was not called.
+     */
+    [[nodiscard]] std::vector<StackFrame> frames(std::span<const uintptr_t> stack) const;
+
+    /**
+     * @brief Gets the symbolized frame of one entry of an aggregated stack.
+     * @param stack One of the stacks returned by stacks().
+     * @param index The index of the entry.
+     * @return A pointer to the frame resolved for the entry's call site, or nullptr if it was not symbolized.
+     */
+    [[nodiscard]] const StackFrame* frameAt(std::span<const uintptr_t> stack, size_t index) const;
+
+private:
+    StackCounts m_stacks;
+    uint64_t m_totalSamples{0};
+    std::unordered_map<uintptr_t, StackFrame> m_frames;
+};
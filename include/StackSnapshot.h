@@ -0,0 +1,121 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <vector>
+#include <sys/types.h>
+#include <sys/user.h>
+
+/// @brief StackSnapshot is a local copy of a stopped thread's registers and the top of its stack. \struct StackSnapshot
+struct StackSnapshot
+{
+    /// @brief Syscall is the system call a thread was in when it stopped. \struct Syscall
+    struct Syscall
+    {
+        /// @brief The syscall number, or notInSyscall if the thread was running user code.
+        int64_t number{notInSyscall};
+        std::array<uint64_t, 6> args{};
+    };
+
+    static constexpr int64_t notInSyscall = -1;
+
+    pid_t tid{0};
+    user_regs_struct regs{};
+    uintptr_t stackStart{0};
+    std::vector<std::byte> stack;
+
+    /**
+     * @brief Gets the program counter from the captured registers.
+     * @return The instruction pointer of the thread.
+     */
+    [[nodiscard]] uintptr_t programCounter() const noexcept
+    {
+#if defined(__x86_64__)
+        return regs.rip;
+#elif defined(__i386__)
+        return static_cast<uintptr_t>(regs.eip);
+#elif defined(__aarch64__)
+        return regs.pc;
+#else
+        return 0;
+#endif
+    }
+
+    /**
+     * @brief Gets the stack pointer from the captured registers.
+     * @return The stack pointer of the thread.
+     */
+    [[nodiscard]] uintptr_t stackPointer() const noexcept
+    {
+#if defined(__x86_64__)
+        return regs.rsp;
+#elif defined(__i386__)
+        return static_cast<uintptr_t>(regs.esp);
+#elif defined(__aarch64__)
+        return regs.sp;
+#else
+        return 0;
+#endif
+    }
+
+    /**
+     * @brief Gets the frame pointer from the captured registers.
+     * @return The frame pointer of the thread.
+     */
+    [[nodiscard]] uintptr_t framePointer() const noexcept
+    {
+#if defined(__x86_64__)
+        return regs.rbp;
+#elif defined(__i386__)
+        return static_cast<uintptr_t>(regs.ebp);
+#elif defined(__aarch64__)
+        return regs.regs[29];
+#else
+        return 0;
+#endif
+    }
+
+    /**
+     * @brief Gets the system call the thread was interrupted in from the captured registers.
+     * @return The syscall and its arguments, or std::nullopt where the registers do not record it.
+     */
+    [[nodiscard]] std::optional<Syscall> syscall() const noexcept
+    {
+#if defined(__x86_64__)
+        // A thread stopped inside a syscall keeps its number in orig_rax so the kernel can restart it.
+        return Syscall{static_cast<int64_t>(regs.orig_rax), {regs.rdi, regs.rsi, regs.rdx, regs.r10, regs.r8, regs.r9}};
+#else
+        return std::nullopt;
+#endif
+    }
+
+    /**
+     * @brief Checks whether a range of target addresses lies inside the copied stack.
+     * @param address The target address.
+     * @param size The number of bytes.
+     * @return A boolean indicating whether the range can be read from the snapshot.
+     */
+    [[nodiscard]] bool contains(const uintptr_t address, const size_t size) const noexcept
+    {
+        return address >= stackStart && size <= stack.size() && address - stackStart <= stack.size() - size;
+    }
+
+    /**
+     * @brief Reads a pointer-sized word of the target's stack from the local copy.
+     * @param address The target address.
+     * @return The word, or std::nullopt if the address lies outside the copy.
+     */
+    [[nodiscard]] std::optional<uintptr_t> readWord(const uintptr_t address) const noexcept
+    {
+        if (!contains(address, sizeof(uintptr_t)))
+        {
+            return std::nullopt;
+        }
+
+        uintptr_t value = 0;
+        std::memcpy(&value, stack.data() + (address - stackStart), sizeof(value));
+        return value;
+    }
+};
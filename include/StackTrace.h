@@ -1,11 +1,22 @@
 #pragma once
 #include <vector>
+#include <algorithm>
+#include <chrono>
 #include <cstddef>
-#include <stacktrace>
+#include <cstdint>
 #include <expected>
+#include <functional>
+#include <optional>
+#include <span>
 #include <string>
+#include <string_view>
 #include <sys/types.h>
+#include "ModuleMap.h"
+#include "ProcessScanner.h"
 #include "StackFrame.h"
+#include "StackProfile.h"
+#include "ThreadGroups.h"
+#include "Unwinder.h"
 
 /// @brief StackTrace is a utility class for capturing and resolving stack traces in a process or thread. \class StackTrace
 class StackTrace
@@ -18,7 +29,59 @@ public:
         ProcessNotRunning,
         AttachFailed,
         DetachFailed,
-        CaptureFailed
+        CaptureFailed,
+        PerfUnavailable
+    };
+
+    /// @brief Enum selecting how sampleProcess() takes its samples. \enum SamplingBackend
+    enum class SamplingBackend : uint8_t
+    {
+        Ptrace,
+        Perf
+    };
+
+    /// @brief The highest sampling rate sampleProcess() takes; higher rates are clamped to it. A ptrace sample stops
+    ///        the target for tens of microseconds, so faster rates would only keep it stopped or spin the sampler.
+    static constexpr uint32_t maxSampleFrequency = 10'000;
+
+    /// @brief CaptureStats accumulates how long targets were kept stopped. \struct CaptureStats
+    struct CaptureStats
+    {
+        size_t stops{0};
+        std::chrono::nanoseconds totalStop{0};
+        std::chrono::nanoseconds maxStop{0};
+        uint64_t lostSamples{0};
+        size_t unsampledThreads{0};
+
+        /**
+         * @brief Records one stop.
+         * @param duration The time from stopping the target until it was released.
+         */
+        void record(const std::chrono::nanoseconds duration) noexcept
+        {
+            ++stops;
+            totalStop += duration;
+            maxStop = std::max(maxStop, duration);
+        }
+    };
+
+    /// @brief RawCapture is an unsymbolized stack together with how long the target was stopped for it. \struct RawCapture
+    struct RawCapture
+    {
+        std::vector<uintptr_t> addresses;
+        std::chrono::nanoseconds stopDuration{0};
+    };
+
+    /// @brief SampleCallback receives every raw sample as it is taken: the thread and its program counter followed by the return addresses.
+    using SampleCallback = std::function<void(pid_t tid, std::span<const uintptr_t> stack)>;
+
+    /// @brief ThreadStack is the captured stack of one thread of a process together with its scheduler state. \struct ThreadStack
+    struct ThreadStack
+    {
+        pid_t tid{0};
+        std::string name;
+        std::vector<StackFrame> frames;
+        ProcessScanner::ThreadInfo state;
     };
 
     /**
@@ -39,17 +102,92 @@ public:
     void setMaxDepth(size_t depth) noexcept;
 
     /**
-     * @brief Captures the current thread's stack trace.
+     * @brief Sets how many bytes of a target's stack are copied in one read when capturing a process.
+     * @param bytes The snapshot size, clamped to the target's stack mapping.
+     */
+    void setStackSnapshotSize(size_t bytes) noexcept;
+
+    /**
+     * @brief Sets how caller frames are recovered when capturing a process.
+     * @param method The unwinding method.
+     */
+    void setUnwindMethod(Unwinder::Method method) noexcept;
+
+    /**
+     * @brief Sets how sampleProcess() takes its samples.
+     * @param backend Ptrace stops the target for every sample; Perf lets the kernel record the stacks with perf_event_open.
+     */
+    void setSamplingBackend(SamplingBackend backend) noexcept;
+
+    /**
+     * @brief Captures the current thread's stack trace. Use SelfTrace to defer symbolization or to capture from a signal handler.
      * @return A vector of StackFrame objects.
      */
     [[nodiscard]] std::vector<StackFrame> captureCurrentThread() const;
 
     /**
      * @brief Captures the stack trace of a specific thread by its thread ID (TID).
+     *        The thread is stopped only while its registers and stack are copied; unwinding and symbolization run afterwards.
      * @param pid The thread ID of the thread to capture the stack trace from.
+     * @param stats Receives the stop duration, may be nullptr.
      * @return A std::expected containing a vector of StackFrame objects on success, or an Error code on failure.
      */
-    [[nodiscard]] std::expected<std::vector<StackFrame>, Error> captureProcess(pid_t pid) const;
+    [[nodiscard]] std::expected<std::vector<StackFrame>, Error> captureProcess(pid_t pid, CaptureStats* stats = nullptr) const;
+
+    /**
+     * @brief Captures the raw return addresses of a process without symbolizing them. The thread is seized,
+     *        its registers and stack bytes are copied and it is released before the copy is unwound.
+     * @param pid The process ID.
+     * @param modules The mappings of the process, read once by the caller.
+     * @return A std::expected containing the program counter followed by the return addresses and the measured
+     *         stop duration on success, or an Error code on failure.
+     */
+    [[nodiscard]] std::expected<RawCapture, Error> captureRaw(pid_t pid, const ModuleMap& modules) const;
+
+    /**
+     * @brief Samples the stack of a process at a fixed rate and aggregates identical stacks.
+     *        Only raw addresses are captured while sampling; each distinct call site is symbolized once at the end.
+     *        With the Perf backend every thread is sampled on CPU without being stopped; the DWARF method unwinds
+     *        a copy of the user stack taken by the kernel, the frame-pointer method uses the kernel's callchain.
+     * @param pid The process ID.
+     * @param frequency The number of samples per second, at most maxSampleFrequency.
+     * @param duration How long to sample.
+     * @param stats Receives the stop duration of every sample, or the lost sample count with Perf, may be nullptr.
+     * @param onSample Receives every sample as soon as it is taken, on the sampling thread, so it should only queue it.
+     *        When set, the caller consumes the samples itself and the returned profile stays empty.
+     * @return A std::expected containing the profile on success, or an Error code if not a single sample was taken.
+     */
+    [[nodiscard]] std::expected<StackProfile, Error> sampleProcess(
+        pid_t pid,
+        uint32_t frequency,
+        std::chrono::milliseconds duration,
+        CaptureStats* stats = nullptr,
+        const SampleCallback& onSample = {}) const;
+
+    /**
+     * @brief Captures the stacks of all threads of a process. Every thread is stopped, snapshotted and released
+     *        before any unwinding starts; the snapshots are then unwound in parallel and symbolized per distinct stack.
+     * @param pid The process ID.
+     * @param stats Receives the time the threads were stopped, may be nullptr.
+     * @return A std::expected containing one ThreadStack per thread ordered by TID on success, or an Error code on failure.
+     */
+    [[nodiscard]] std::expected<std::vector<ThreadStack>, Error> captureAllThreads(pid_t pid, CaptureStats* stats = nullptr) const;
+
+    /**
+     * @brief Captures the stacks of all threads of a process grouped by identical raw address sequence.
+     *        Each distinct call site is symbolized once, after grouping.
+     * @param pid The process ID.
+     * @param stats Receives the time the threads were stopped, may be nullptr.
+     * @return A std::expected containing the groups on success, or an Error code on failure.
+     */
+    [[nodiscard]] std::expected<ThreadGroups, Error> captureThreadGroups(pid_t pid, CaptureStats* stats = nullptr) const;
+
+    /**
+     * @brief Parses a sampling backend name.
+     * @param name Either "ptrace" or "perf".
+     * @return The backend, or std::nullopt if the name is unknown.
+     */
+    [[nodiscard]] static std::optional<SamplingBackend> parseSamplingBackend(std::string_view name) noexcept;
 
     /**
      * @brief Converts an Error code to a human-readable string.
@@ -59,12 +197,48 @@ public:
     [[nodiscard]] static std::string errorToString(Error error) noexcept;
 
 private:
+
+    /// @brief RawThreadStack is the unsymbolized stack of one thread. \struct RawThreadStack
+    struct RawThreadStack
+    {
+        pid_t tid{0};
+        std::vector<uintptr_t> addresses;
+        std::optional<StackSnapshot::Syscall> syscall;
+    };
+
     size_t m_maxDepth;
+    size_t m_stackSnapshotBytes;
+    Unwinder::Method m_unwindMethod;
+    SamplingBackend m_samplingBackend;
+    size_t m_perfStackBytes;
 
     /**
-     * @brief Converts a std::stacktrace to a vector of StackFrame objects.
-     * @param st The std::stacktrace to convert.
-     * @return A vector of StackFrame objects.
+     * @brief Samples a process through perf_event_open without stopping it.
+     * @param pid The process ID.
+     * @param modules The mappings of the process.
+     * @param frequency The number of samples per second and thread.
+     * @param duration How long to sample.
+     * @param stats Receives the lost sample count, may be nullptr.
+     * @param onSample Receives every sample as it is drained instead of the profile, may be empty.
+     * @return A std::expected containing the unsymbolized profile on success, or an Error code on failure.
+     */
+    [[nodiscard]] std::expected<StackProfile, Error> samplePerf(
+        pid_t pid,
+        const ModuleMap& modules,
+        uint32_t frequency,
+        std::chrono::milliseconds duration,
+        CaptureStats* stats,
+        const SampleCallback& onSample) const;
+
+    /**
+     * @brief Stops all threads of a process, snapshots and releases them, then unwinds the snapshots in parallel.
+     * @param pid The process ID.
+     * @param modules The mappings of the process.
+     * @param stats Receives the time the threads were stopped, may be nullptr.
+     * @return A std::expected containing the raw stacks ordered by TID on success, or an Error code on failure.
      */
-    [[nodiscard]] std::vector<StackFrame> convertStackTrace(const std::stacktrace& st) const;
+    [[nodiscard]] std::expected<std::vector<RawThreadStack>, Error> captureThreadAddresses(
+        pid_t pid,
+        const ModuleMap& modules,
+        CaptureStats* stats) const;
 };
\ No newline at end of file
@@ -0,0 +1,98 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <unordered_map>
+#include <vector>
+#include <sys/types.h>
+#include "PlatformUtils.h"
+#include "StackFrame.h"
+#include "TraceSession.h"
+
+class ThreadPool;
+
+/// @brief StackWatcher re-captures all threads of a process and reports only the stacks that changed since the
+///        previous poll. Unchanged threads are recognized by their address hash and cost no symbolization. \class StackWatcher
+class StackWatcher
+{
+public:
+
+    using Error = TraceSession::Error;
+
+    /// @brief Enum describing how the stack of a thread changed. \enum ChangeKind
+    enum class ChangeKind : uint8_t
+    {
+        Started,
+        Changed,
+        Exited
+    };
+
+    /// @brief Change is the new stack of one thread. \struct Change
+    struct Change
+    {
+        pid_t tid{0};
+        ChangeKind kind{ChangeKind::Started};
+        const std::vector<StackFrame>* frames{nullptr};
+        size_t changedFrames{0};
+    };
+
+    /**
+     * @brief Opens a watcher on a process.
+     * @param pid The process ID.
+     * @param options The capture options.
+     * @param maxFrames The frame limit per thread.
+     * @return A std::expected containing the watcher on success, or an Error code on failure.
+     */
+    [[nodiscard]] static std::expected<StackWatcher, Error> open(
+        pid_t pid,
+        const TraceSession::Options& options,
+        size_t maxFrames = PlatformUtils::defaultMaxFrames);
+
+    /**
+     * @brief Captures all threads and compares each stack with the one of the previous poll.
+     *        On the first poll every thread is reported as started.
+     * @param pool The pool to resolve unseen call sites on, or nullptr to resolve on the calling thread.
+     * @param stopDuration Receives how long the threads were stopped, may be nullptr.
+     * @return A std::expected containing the changes ordered by TID, valid until the next poll, or an Error code on failure.
+     *         Exited threads carry no frames; changedFrames counts the innermost frames that differ.
+     */
+    [[nodiscard]] std::expected<std::vector<Change>, Error> poll(ThreadPool* pool = nullptr, std::chrono::nanoseconds* stopDuration = nullptr);
+
+    /**
+     * @brief Gets the number of threads seen by the last poll.
+     * @return The thread count.
+     */
+    [[nodiscard]] size_t threadCount() const noexcept
+    {
+        return m_threads.size();
+    }
+
+private:
+    /// @brief ThreadState is the last stack seen of one thread. \struct ThreadState
+    struct ThreadState
+    {
+        size_t hash{0};
+        std::vector<uintptr_t> addresses;
+        std::vector<StackFrame> frames;
+    };
+
+    TraceSession m_session;
+    size_t m_maxFrames;
+    std::vector<uintptr_t> m_addresses;
+    std::vector<TraceSession::ThreadRange> m_ranges;
+    std::unordered_map<pid_t, ThreadState> m_threads;
+
+    /**
+     * @brief Private Ctor, use open().
+     * @param session The session capturing the process.
+     * @param maxFrames The frame limit per thread.
+     */
+    StackWatcher(TraceSession session, size_t maxFrames) noexcept;
+
+    /**
+     * @brief Grows the capture buffers to hold a number of threads and some headroom.
+     * @param threads The number of threads the process has.
+     */
+    void reserveThreads(size_t threads);
+};
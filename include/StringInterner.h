@@ -0,0 +1,117 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Export.h"
+
+/// @brief StringInterner stores every distinct string once and hands out dense 32-bit ids for it.
+///        It holds up to maxStrings strings; once full, every new string maps to overflowId. \class StringInterner
+class MEXTRACE_API StringInterner
+{
+public:
+
+    /// @brief The id of the empty string, which every interner knows without storing it.
+    static constexpr uint32_t emptyId = 0;
+
+    /// @brief The id every string gets once the interner is full; it views as overflowText.
+    static constexpr uint32_t overflowId = (1u << 24) - 1;
+
+    /// @brief The number of distinct non-empty strings an interner stores, about 16.7 million.
+    static constexpr size_t maxStrings = overflowId - 1;
+
+    /// @brief The text shown for strings that no longer fit.
+    static constexpr std::string_view overflowText = "<interner full>";
+
+    /**
+     * @brief Gets the process-wide interner shared by all stack frames.
+     * @return A reference to the interner.
+     */
+    [[nodiscard]] static StringInterner& instance() noexcept;
+
+    /**
+     * @brief Ctor.
+     */
+    StringInterner() noexcept = default;
+
+    /**
+     * @brief Destructor, frees the string storage.
+     */
+    ~StringInterner();
+
+    StringInterner(const StringInterner&) = delete;
+    StringInterner& operator=(const StringInterner&) = delete;
+
+    /**
+     * @brief Returns the id of a string, storing it on first use. Safe to call from several threads.
+     * @param text The string.
+     * @return The id, emptyId for an empty string, or overflowId if the string is new and maxStrings are stored.
+     */
+    [[nodiscard]] uint32_t intern(std::string_view text);
+
+    /**
+     * @brief Gets the string of an id. Lock-free; the view stays valid for the lifetime of the interner.
+     * @param id An id returned by intern().
+     * @return The string, empty for emptyId.
+     */
+    [[nodiscard]] std::string_view view(const uint32_t id) const noexcept
+    {
+        if (id == emptyId)
+        {
+            return {};
+        }
+
+        const auto* block = m_blocks[id >> blockBits].load(std::memory_order_acquire);
+        return block[id & (blockSize - 1)];
+    }
+
+    /**
+     * @brief Gets the number of distinct non-empty strings stored.
+     * @return The string count.
+     */
+    [[nodiscard]] size_t size() const noexcept;
+
+    /**
+     * @brief Gets the bytes used by the stored characters.
+     * @return The size of the character arena.
+     */
+    [[nodiscard]] size_t storageBytes() const noexcept;
+
+private:
+    static constexpr uint32_t blockBits = 12;
+    static constexpr uint32_t blockSize = 1u << blockBits;
+    static constexpr size_t maxBlocks = 4096;
+    static constexpr size_t chunkBytes = 64 * 1024;
+
+    /// @brief ViewHash lets the index be searched by string_view. \struct ViewHash
+    struct ViewHash
+    {
+        [[nodiscard]] size_t operator()(const std::string_view text) const noexcept
+        {
+            return std::hash<std::string_view>{}(text);
+        }
+    };
+
+    mutable std::shared_mutex m_mutex;
+    std::unordered_map<std::string_view, uint32_t, ViewHash> m_index;
+    std::array<std::atomic<std::string_view*>, maxBlocks> m_blocks{};
+    std::vector<std::unique_ptr<char[]>> m_chunks;
+    char* m_chunk{nullptr};
+    size_t m_chunkUsed{0};
+    size_t m_storageBytes{0};
+    uint32_t m_nextId{1};
+
+    /**
+     * @brief Copies a string into the arena. Must be called with the mutex held exclusively.
+     * @param text The string.
+     * @return A view of the stored copy.
+     */
+    [[nodiscard]] std::string_view store(std::string_view text);
+
+    static_assert(overflowId == maxBlocks * blockSize - 1, "The overflow id is the last slot of the last block");
+};
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include "DwarfLineTable.h"
+#include "ElfSymbolTable.h"
+
+/// @brief SymbolCache persists per-module symbol and line indexes on disk, keyed by the module's GNU build-id. \class SymbolCache
+class SymbolCache
+{
+public:
+
+    /// @brief Index is a cached module index whose tables look up directly in the mapped cache file.
+    ///        The line table is missing if the index was stored before it had been decoded. \struct Index
+    struct Index
+    {
+        ElfSymbolTable symbols;
+        std::optional<DwarfLineTable> lines;
+    };
+
+    /**
+     * @brief Ctor for SymbolCache.
+     * @param directory The cache directory, created on first store.
+     * @param maxBytes The total size cap of all index files, oldest files are evicted beyond it.
+     */
+    explicit SymbolCache(std::string directory, uint64_t maxBytes = defaultMaxBytes) noexcept;
+
+    /**
+     * @brief Gets the default cache directory: $MEXTRACE_CACHE_DIR, $XDG_CACHE_HOME/mexTrace or ~/.cache/mexTrace.
+     * @return The directory path, or std::nullopt if none of the variables is set.
+     */
+    [[nodiscard]] static std::optional<std::string> defaultDirectory();
+
+    /**
+     * @brief Maps the cached index for a build-id.
+     * @param buildId The hex build-id of the module.
+     * @return The index, or std::nullopt if it is missing or fails validation.
+     */
+    [[nodiscard]] std::optional<Index> load(std::string_view buildId) const;
+
+    /**
+     * @brief Writes the index for a build-id atomically and enforces the size cap.
+     * @param buildId The hex build-id of the module.
+     * @param symbols The symbol table to store.
+     * @param lines The line table to store, or nullptr to store the symbols alone and the lines later.
+     * @return A boolean indicating whether the index was written.
+     */
+    bool store(std::string_view buildId, const ElfSymbolTable& symbols, const DwarfLineTable* lines) const;
+
+    /**
+     * @brief Removes the least recently used index files until the cache fits its size cap.
+     */
+    void evict() const;
+
+    static constexpr uint64_t defaultMaxBytes = 256ull * 1024 * 1024;
+
+private:
+    std::string m_directory;
+    uint64_t m_maxBytes;
+
+    /**
+     * @brief Builds the path of the index file for a build-id.
+     * @param buildId The hex build-id of the module.
+     * @return The file path.
+     */
+    [[nodiscard]] std::string indexPath(std::string_view buildId) const;
+};
@@ -0,0 +1,136 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "CfiTable.h"
+#include "DwarfLineTable.h"
+#include "ElfFile.h"
+#include "ElfSymbolTable.h"
+#include "StackFrame.h"
+#include "SymbolCache.h"
+
+/// @brief Symbolizer resolves addresses in-process against cached, per-module ELF symbol indexes. \class Symbolizer
+class Symbolizer
+{
+public:
+
+    /**
+     * @brief Gets the process-wide symbolizer shared by all captures.
+     * @return A reference to the shared Symbolizer.
+     */
+    [[nodiscard]] static Symbolizer& instance() noexcept;
+
+    /**
+     * @brief Resolves an address of the given module to a StackFrame.
+     * @param modulePath The path to the ELF file containing the address.
+     * @param address The address relative to the module's link-time layout.
+     * @return A StackFrame with function name and, when .debug_line is present, source file and line
+     *         (possibly without symbol info if no symbol covers the address),
+     *         or std::nullopt if the module cannot be read or carries no symbols at all.
+     */
+    [[nodiscard]] std::optional<StackFrame> resolve(std::string_view modulePath, uintptr_t address);
+
+    /**
+     * @brief Converts an offset into a module file to the module's link-time address using its PT_LOAD segments.
+     * @param modulePath The path to the ELF file.
+     * @param fileOffset The offset into the file, e.g. derived from a /proc/pid/maps entry.
+     * @return The link-time address, or std::nullopt if the module cannot be read or no segment covers the offset.
+     */
+    [[nodiscard]] std::optional<uint64_t> linkAddress(std::string_view modulePath, uint64_t fileOffset);
+
+    /**
+     * @brief Gets the call frame information of a module, indexing it on first use.
+     * @param modulePath The path to the ELF file.
+     * @return A pointer to the table, or nullptr if the module cannot be read. The table lives until clear().
+     */
+    [[nodiscard]] const CfiTable* cfiTable(std::string_view modulePath);
+
+    /**
+     * @brief Drops all cached module indexes.
+     */
+    void clear() noexcept;
+
+    /**
+     * @brief Enables the persistent on-disk index cache for modules loaded from now on.
+     *        Must be called before modules are resolved concurrently.
+     * @param cache The cache to use, or nullptr to disable caching.
+     */
+    void setCache(std::unique_ptr<SymbolCache> cache) noexcept;
+
+    /**
+     * @brief Demangles a C++ symbol name.
+     * @param name The mangled name.
+     * @return The demangled name, or the input unchanged if it is not a mangled C++ name.
+     */
+    [[nodiscard]] static std::string demangle(std::string_view name);
+
+private:
+
+    /// @brief Module holds the mapped file and the indexes built for it; line and CFI tables are decoded on first use. \struct Module
+    struct Module
+    {
+        ElfFile elf;
+        ElfSymbolTable symbols;
+        std::once_flag linesOnce;
+        DwarfLineTable lines;
+        /// @brief The build-id whose cached index still lacks the line table, empty if there is nothing to store.
+        std::string pendingLinesBuildId;
+        std::once_flag cfiOnce;
+        CfiTable cfi;
+    };
+
+    /// @brief PathHash lets the module map be searched by string_view without allocating a key. \struct PathHash
+    struct PathHash
+    {
+        using is_transparent = void;
+
+        [[nodiscard]] size_t operator()(const std::string_view path) const noexcept
+        {
+            return std::hash<std::string_view>{}(path);
+        }
+    };
+
+    /// @brief ModuleSlot is the per-path entry that is filled exactly once, possibly with a module shared by build-id. \struct ModuleSlot
+    struct ModuleSlot
+    {
+        std::once_flag loaded;
+        std::shared_ptr<Module> module;
+    };
+
+    std::mutex m_mutex;
+    std::unordered_map<std::string, std::shared_ptr<ModuleSlot>, PathHash, std::equal_to<>> m_modules;
+    std::unordered_map<std::string, std::shared_ptr<Module>> m_modulesByBuildId;
+    std::unique_ptr<SymbolCache> m_cache;
+
+    /**
+     * @brief Default Ctor.
+     */
+    Symbolizer() noexcept = default;
+
+    /**
+     * @brief Gets the cached module for a path, loading and indexing it on first use.
+     * @param modulePath The path to the ELF file.
+     * @return A pointer to the module, or nullptr if the file cannot be mapped as ELF.
+     */
+    [[nodiscard]] Module* loadModule(std::string_view modulePath);
+
+    /**
+     * @brief Maps and indexes a module, reusing an already loaded module with the same build-id,
+     *        e.g. the same binary reached through another path by a different process.
+     * @param modulePath The path to the ELF file.
+     * @return The module, or nullptr if the file cannot be mapped as ELF.
+     */
+    [[nodiscard]] std::shared_ptr<Module> buildModule(std::string_view modulePath);
+
+    /**
+     * @brief Gets the line table of a module, decoding it on first use and completing its cached index.
+     * @param module The module.
+     * @return A reference to the module's line table.
+     */
+    [[nodiscard]] const DwarfLineTable& lineTable(Module& module);
+};
@@ -0,0 +1,99 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+#include <sys/types.h>
+#include "Export.h"
+#include "ModuleMap.h"
+#include "StackFrame.h"
+#include "StackProfile.h"
+
+class ThreadPool;
+
+/// @brief ThreadGroups groups the raw stacks of many threads so each distinct stack is symbolized and printed once. \class ThreadGroups
+class MEXTRACE_API ThreadGroups
+{
+public:
+
+    /// @brief Group is one distinct stack together with the threads parked in it. \struct Group
+    struct Group
+    {
+        const std::vector<uintptr_t>* addresses{nullptr};
+        const std::vector<pid_t>* tids{nullptr};
+    };
+
+    /// @brief TrieNode is one call site of the root-first prefix tree of all stacks. \struct TrieNode
+    struct TrieNode
+    {
+        uintptr_t address{0};
+        const StackFrame* frame{nullptr};
+        size_t threadCount{0};
+        std::vector<pid_t> tids;
+        std::vector<TrieNode> children;
+    };
+
+    /**
+     * @brief Ctor.
+     */
+    ThreadGroups() = default;
+
+    // The thread lists point into the profile, which a move carries along but a copy would not.
+    ThreadGroups(const ThreadGroups&) = delete;
+    ThreadGroups& operator=(const ThreadGroups&) = delete;
+    ThreadGroups(ThreadGroups&&) noexcept = default;
+    ThreadGroups& operator=(ThreadGroups&&) noexcept = default;
+
+    /**
+     * @brief Adds the raw stack of a thread, joining the group of an identical stack if there is one.
+     * @param tid The thread ID.
+     * @param stack The program counter followed by the return addresses.
+     */
+    void add(pid_t tid, std::span<const uintptr_t> stack);
+
+    /**
+     * @brief Symbolizes every distinct call site of the grouped stacks once.
+     * @param modules The mappings of the process.
+     * @param pool The pool to resolve the call sites on, or nullptr to resolve on the calling thread.
+     */
+    void symbolize(const ModuleMap& modules, ThreadPool* pool = nullptr);
+
+    /**
+     * @brief Gets the number of threads added.
+     * @return The thread count.
+     */
+    [[nodiscard]] size_t threadCount() const noexcept
+    {
+        return static_cast<size_t>(m_profile.totalSamples());
+    }
+
+    /**
+     * @brief Gets the distinct stacks ordered by descending thread count.
+     * @return The groups, valid until the next add().
+     */
+    [[nodiscard]] std::vector<Group> groups() const;
+
+    /**
+     * @brief Gets the symbolized frames of a grouped stack.
+     * @param addresses The addresses of a group.
+     * @return One StackFrame per address carrying the raw address.
+     */
+    [[nodiscard]] std::vector<StackFrame> frames(std::span<const uintptr_t> addresses) const
+    {
+        return m_profile.frames(addresses);
+    }
+
+    /**
+     * @brief Builds the prefix tree of all stacks from the outermost frame inwards, showing where stacks diverge.
+     *        Children are ordered by descending thread count.
+     * @return The root node, whose children are the outermost frames.
+     */
+    [[nodiscard]] TrieNode buildTrie() const;
+
+private:
+    StackProfile m_profile;
+
+    /// @brief The threads of each distinct stack, keyed by the profile's own copy of it so every stack is stored once.
+    std::unordered_map<const std::vector<uintptr_t>*, std::vector<pid_t>> m_tids;
+};
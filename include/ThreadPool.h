@@ -0,0 +1,77 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "Export.h"
+
+/// @brief ThreadPool runs submitted tasks on a fixed set of worker threads. \class ThreadPool
+class MEXTRACE_API ThreadPool
+{
+public:
+
+    /**
+     * @brief Ctor, starts the workers.
+     * @param threadCount The number of workers, 0 selects the number of hardware threads.
+     */
+    explicit ThreadPool(size_t threadCount = 0);
+
+    /**
+     * @brief Destructor, finishes the queued tasks and joins the workers.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Gets the process-wide pool used for unwinding and symbolization, started on first use.
+     *        Tasks running on it must not block on other tasks of the same pool.
+     * @return A reference to the shared pool with one worker per hardware thread.
+     */
+    [[nodiscard]] static ThreadPool& shared();
+
+    /**
+     * @brief Queues a task.
+     * @param task The callable to run on a worker.
+     * @return A future receiving the task's result or exception.
+     */
+    template <typename F>
+    [[nodiscard]] std::future<std::invoke_result_t<F>> submit(F&& task)
+    {
+        std::packaged_task<std::invoke_result_t<F>()> packaged(std::forward<F>(task));
+        auto future = packaged.get_future();
+        {
+            const std::scoped_lock lock(m_mutex);
+            m_tasks.emplace_back(std::move(packaged));
+        }
+        m_condition.notify_one();
+        return future;
+    }
+
+    /**
+     * @brief Gets the number of workers.
+     * @return The worker count.
+     */
+    [[nodiscard]] size_t size() const noexcept
+    {
+        return m_workers.size();
+    }
+
+private:
+    std::vector<std::thread> m_workers;
+    std::deque<std::move_only_function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stopping{false};
+
+    /**
+     * @brief Runs queued tasks until the pool is stopped and the queue is drained.
+     */
+    void workerLoop();
+};
@@ -0,0 +1,254 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <regex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/types.h>
+#include "Export.h"
+#include "HangDetector.h"
+#include "RecordWriter.h"
+#include "StackFrame.h"
+#include "StackProfile.h"
+#include "StackTrace.h"
+#include "StackWatcher.h"
+#include "ThreadGroups.h"
+#include "TraceSession.h"
+
+class ThreadPool;
+
+/// @brief TraceRunner carries out one capture request against one or many processes: it attaches, captures, samples,
+///        streams or watches, and hands each result to a Handler, which only decides how to present it. \class TraceRunner
+class MEXTRACE_API TraceRunner
+{
+public:
+
+    using CaptureStats = StackTrace::CaptureStats;
+    using SamplingBackend = StackTrace::SamplingBackend;
+    using ThreadStack = StackTrace::ThreadStack;
+
+    /// @brief The highest sampling rate a request may ask for.
+    static constexpr uint32_t maxSampleFrequency = StackTrace::maxSampleFrequency;
+
+    /// @brief Enum selecting what a request captures. \enum Mode
+    enum class Mode : uint8_t
+    {
+        Process,
+        AllThreads,
+        ThreadGroups,
+        Sample,
+        Watch,
+        DetectHang
+    };
+
+    /// @brief Options describes one request. \struct Options
+    struct Options
+    {
+        Mode mode{Mode::Process};
+        TraceSession::Options session;
+        SamplingBackend backend{SamplingBackend::Ptrace};
+        uint32_t sampleHz{0};
+        std::chrono::nanoseconds duration{std::chrono::seconds(5)};
+        std::chrono::nanoseconds watchInterval{std::chrono::seconds(1)};
+
+        /// @brief Streams every stack to Handler::recordSink() as it is taken instead of handing back results.
+        ///        Applies to Process, AllThreads, ThreadGroups and Sample; thread groups are streamed thread by thread.
+        bool records{false};
+    };
+
+    /// @brief RecordSink serializes the records of targets captured concurrently into one writer. \class RecordSink
+    class RecordSink
+    {
+    public:
+
+        /**
+         * @brief Ctor.
+         * @param os The output stream.
+         * @param format The encoding.
+         */
+        RecordSink(std::ostream& os, RecordWriter::Format format);
+
+        /**
+         * @brief Writes one record while no other target writes.
+         * @param record The stack.
+         */
+        void write(const RecordWriter::Record& record);
+
+    private:
+        RecordWriter m_writer;
+        std::mutex m_mutex;
+    };
+
+    /// @brief Handler receives what a request captured from one target. Every callback runs on the thread that
+    ///        captures the target, except finish(), which runs on the caller of run() in target order. \class Handler
+    class Handler
+    {
+    public:
+
+        /**
+         * @brief Destructor.
+         */
+        virtual ~Handler() = default;
+
+        /**
+         * @brief Called once the target was found running, before it is captured.
+         * @param name The process name, if it could be read.
+         * @param path The executable path, if it could be read.
+         */
+        virtual void onAttach(const std::optional<std::string>& name, const std::optional<std::string>& path);
+
+        /**
+         * @brief Called when the target cannot be captured; no result follows.
+         * @param message The reason.
+         */
+        virtual void onError(std::string_view message);
+
+        /**
+         * @brief Receives the stack of the main thread in Mode::Process.
+         * @param frames The symbolized stack.
+         */
+        virtual void onStack(const std::vector<StackFrame>& frames);
+
+        /**
+         * @brief Receives the stacks of all threads in Mode::AllThreads.
+         * @param threads The threads, ordered by TID.
+         */
+        virtual void onThreads(std::span<const ThreadStack> threads);
+
+        /**
+         * @brief Receives the distinct stacks of all threads in Mode::ThreadGroups.
+         * @param groups The symbolized groups.
+         */
+        virtual void onThreadGroups(const ThreadGroups& groups);
+
+        /**
+         * @brief Receives the aggregated samples in Mode::Sample.
+         * @param profile The symbolized profile.
+         */
+        virtual void onProfile(const StackProfile& profile);
+
+        /**
+         * @brief Receives the result of every poll in Mode::Watch, including polls where nothing changed.
+         * @param poll The number of the poll, starting at 1.
+         * @param changes The threads whose stacks changed.
+         * @param threadCount The number of threads alive at the poll.
+         */
+        virtual void onChanges(size_t poll, std::span<const StackWatcher::Change> changes, size_t threadCount);
+
+        /**
+         * @brief Asked between polls in Mode::Watch, at least every 100 ms.
+         * @return A boolean indicating whether to poll again; the default watches until the target exits.
+         */
+        virtual bool keepWatching();
+
+        /**
+         * @brief Called when the target exits while it is watched.
+         */
+        virtual void onExit();
+
+        /**
+         * @brief Called when Mode::Watch ends, before onStats().
+         * @param polls The number of polls taken.
+         */
+        virtual void onWatchEnd(size_t polls);
+
+        /**
+         * @brief Receives the report of Mode::DetectHang.
+         * @param report The report.
+         */
+        virtual void onHangReport(const HangDetector::Report& report);
+
+        /**
+         * @brief Receives how long the target was kept stopped, after every successful capture other than Mode::DetectHang.
+         * @param stats The stop statistics.
+         */
+        virtual void onStats(const CaptureStats& stats);
+
+        /**
+         * @brief Asked once per target when Options::records is set.
+         * @return The sink to stream into, which may be shared between targets, or nullptr to skip the target.
+         */
+        virtual RecordSink* recordSink();
+
+        /**
+         * @brief Called on the caller of run() once the target is done, in the order the targets were given.
+         */
+        virtual void finish();
+    };
+
+    /// @brief HandlerFactory creates the handler of one target.
+    using HandlerFactory = std::function<std::unique_ptr<Handler>(pid_t pid)>;
+
+    /**
+     * @brief Ctor.
+     * @param options The request.
+     */
+    explicit TraceRunner(const Options& options) noexcept;
+
+    /**
+     * @brief Runs the request against one process on the calling thread and then calls Handler::finish().
+     * @param pid The process ID.
+     * @param handler Receives the results.
+     */
+    void run(pid_t pid, Handler& handler) const;
+
+    /**
+     * @brief Runs the request against many processes concurrently. A single target is run on the calling thread.
+     * @param targets The process IDs.
+     * @param jobs The most targets captured at once, or 0 for one per CPU.
+     * @param makeHandler Creates the handler of each target, on the calling thread and in target order.
+     */
+    void run(std::span<const pid_t> targets, size_t jobs, const HandlerFactory& makeHandler) const;
+
+    /**
+     * @brief Finds the processes to capture, leaving out the calling process.
+     * @param pattern Keeps only the processes whose name matches, or std::nullopt to keep all.
+     * @param pool The pool to read /proc on, or nullptr to read it on the calling thread.
+     * @return A std::expected containing the process IDs in ascending order on success, or an error message on failure.
+     */
+    [[nodiscard]] static std::expected<std::vector<pid_t>, std::string> findProcesses(
+        const std::optional<std::regex>& pattern,
+        ThreadPool* pool = nullptr);
+
+    /**
+     * @brief Parses a sampling backend name.
+     * @param name Either "ptrace" or "perf".
+     * @return The backend, or std::nullopt if the name is unknown.
+     */
+    [[nodiscard]] static std::optional<SamplingBackend> parseSamplingBackend(std::string_view name) noexcept;
+
+private:
+    Options m_options;
+
+    /**
+     * @brief Captures the stacks selected by the request.
+     * @param pid The process ID.
+     * @param handler Receives the results.
+     */
+    void capture(pid_t pid, Handler& handler) const;
+
+    /**
+     * @brief Streams the stacks selected by the request as records.
+     * @param tracer The configured tracer.
+     * @param pid The process ID.
+     * @param sink The sink to write to.
+     * @param handler Receives errors and stop statistics.
+     */
+    void streamRecords(const StackTrace& tracer, pid_t pid, RecordSink& sink, Handler& handler) const;
+
+    /**
+     * @brief Polls the process until it exits or the handler stops the watch.
+     * @param pid The process ID.
+     * @param handler Receives every poll.
+     */
+    void watch(pid_t pid, Handler& handler) const;
+};
@@ -0,0 +1,194 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/types.h>
+#include "Export.h"
+#include "StackFrame.h"
+
+class ThreadPool;
+
+/// @brief TraceSession is the embedding API of libmexTrace: raw captures into caller buffers, symbolized on request. \class TraceSession
+class MEXTRACE_API TraceSession
+{
+public:
+
+    /// @brief Incremented whenever a signature of this class changes; matches the shared library's SOVERSION.
+    static constexpr uint32_t apiVersion = 1;
+
+    /// @brief Enum representing the error codes of a session. \enum Error
+    enum class Error : uint8_t
+    {
+        ProcessNotRunning,
+        AttachFailed,
+        CaptureFailed
+    };
+
+    /// @brief Enum selecting how caller frames are recovered. \enum UnwindMethod
+    enum class UnwindMethod : uint8_t
+    {
+        FramePointer,
+        Dwarf
+    };
+
+    /// @brief The number of stack bytes copied per thread unless the options ask for another amount.
+    static constexpr size_t defaultStackBytes = 256 * 1024;
+
+    /// @brief Options fixes how a session captures. \struct Options
+    struct Options
+    {
+        size_t stackBytes{defaultStackBytes};
+        UnwindMethod unwindMethod{UnwindMethod::Dwarf};
+    };
+
+    /// @brief ThreadRange locates the stack of one thread inside the address buffer of captureAllThreads(). \struct ThreadRange
+    struct ThreadRange
+    {
+        pid_t tid{0};
+        uint32_t offset{0};
+        uint32_t count{0};
+    };
+
+    /**
+     * @brief Opens a session on a process. Only the module map is read; the process is not stopped.
+     * @param pid The process ID.
+     * @param options The capture options.
+     * @return A std::expected containing the session on success, or an Error code on failure.
+     */
+    [[nodiscard]] static std::expected<TraceSession, Error> open(pid_t pid, const Options& options);
+
+    /**
+     * @brief Opens a session on a process with the default options.
+     * @param pid The process ID.
+     * @return A std::expected containing the session on success, or an Error code on failure.
+     */
+    [[nodiscard]] static std::expected<TraceSession, Error> open(const pid_t pid)
+    {
+        return open(pid, Options{});
+    }
+
+    /**
+     * @brief Move Ctor.
+     * @param other The session to take over.
+     */
+    TraceSession(TraceSession&& other) noexcept;
+
+    /**
+     * @brief Move assignment.
+     * @param other The session to take over.
+     * @return This session.
+     */
+    TraceSession& operator=(TraceSession&& other) noexcept;
+
+    TraceSession(const TraceSession&) = delete;
+    TraceSession& operator=(const TraceSession&) = delete;
+
+    /**
+     * @brief Destructor.
+     */
+    ~TraceSession();
+
+    /**
+     * @brief Gets the process the session is bound to.
+     * @return The process ID.
+     */
+    [[nodiscard]] pid_t pid() const noexcept;
+
+    /**
+     * @brief Checks whether an address lies in a mapping the session knows of.
+     * @param address The address in the target.
+     * @return A boolean indicating whether the mappings read by open() or the last refreshModules() cover the address.
+     */
+    [[nodiscard]] bool isMapped(uintptr_t address) const noexcept;
+
+    /**
+     * @brief Re-reads the module map, e.g. after the target loaded a library, and drops memoized frames.
+     * @return A boolean indicating whether the map could be read.
+     */
+    [[nodiscard]] bool refreshModules();
+
+    /**
+     * @brief Captures the raw stack of one thread. After the first call the stack buffer is reused,
+     *        so steady-state captures do not allocate.
+     * @param tid The thread ID, which may be the process ID for the main thread.
+     * @param addresses Receives the program counter followed by the return addresses; its size is the frame limit.
+     * @param stopDuration Receives how long the thread was stopped, may be nullptr.
+     * @return A std::expected containing the number of addresses written on success, or an Error code on failure.
+     */
+    [[nodiscard]] std::expected<size_t, Error> capture(
+        pid_t tid,
+        std::span<uintptr_t> addresses,
+        std::chrono::nanoseconds* stopDuration = nullptr);
+
+    /**
+     * @brief Captures the raw stacks of all threads. Every thread is stopped and snapshotted before any is
+     *        released; the stacks are then unwound back to back into one buffer. Snapshots and stop lists are
+     *        kept in the session, but listing the threads of the process still allocates.
+     * @param addresses Receives the stacks of all threads.
+     * @param threads Receives one range per thread, ordered by TID.
+     * @param maxFrames The frame limit per thread.
+     * @param stopDuration Receives how long the threads were stopped, may be nullptr.
+     * @param pool The pool to copy the stacks on while the threads are stopped, or nullptr to copy them one by one.
+     * @return A std::expected containing the number of ranges written on success, or an Error code on failure.
+     *         Threads that do not fit into either buffer are left out; compare with stoppedThreads() to detect that.
+     */
+    [[nodiscard]] std::expected<size_t, Error> captureAllThreads(
+        std::span<uintptr_t> addresses,
+        std::span<ThreadRange> threads,
+        size_t maxFrames,
+        std::chrono::nanoseconds* stopDuration = nullptr,
+        ThreadPool* pool = nullptr);
+
+    /**
+     * @brief Gets the number of threads the last captureAllThreads() stopped, including those left out of its buffers.
+     * @return The thread count, or 0 before the first capture.
+     */
+    [[nodiscard]] size_t stoppedThreads() const noexcept;
+
+    /**
+     * @brief Symbolizes a raw stack. Every call site is resolved at most once per session.
+     * @param stack The program counter followed by the return addresses.
+     * @param pool The pool to resolve unseen call sites on, or nullptr to resolve on the calling thread.
+     * @return One StackFrame per address carrying the raw address.
+     */
+    [[nodiscard]] std::vector<StackFrame> symbolize(std::span<const uintptr_t> stack, ThreadPool* pool = nullptr);
+
+    /**
+     * @brief Parses an unwinding method name.
+     * @param name Either "fp" or "dwarf".
+     * @return The method, or std::nullopt if the name is unknown.
+     */
+    [[nodiscard]] static std::optional<UnwindMethod> parseUnwindMethod(std::string_view name) noexcept;
+
+    /**
+     * @brief Keeps the symbol indexes of the binaries every session and capture of this process reads in a
+     *        persistent cache, so later runs skip parsing them.
+     * @param directory The cache directory, or an empty string for $MEXTRACE_CACHE_DIR, $XDG_CACHE_HOME/mexTrace or ~/.cache/mexTrace.
+     * @return A boolean indicating whether a directory was set; false if no default directory could be determined.
+     */
+    static bool enableSymbolCache(std::string directory = {});
+
+    /**
+     * @brief Converts an error code to a human-readable string.
+     * @param error The error code.
+     * @return A string describing the error.
+     */
+    [[nodiscard]] static std::string errorToString(Error error) noexcept;
+
+private:
+    struct State;
+    std::unique_ptr<State> m_state;
+
+    /**
+     * @brief Private Ctor, use open().
+     * @param state The session state.
+     */
+    explicit TraceSession(std::unique_ptr<State> state) noexcept;
+};
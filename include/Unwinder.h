@@ -0,0 +1,89 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+#include "ModuleMap.h"
+#include "StackSnapshot.h"
+#include "TraceSession.h"
+
+/// @brief Unwinder turns a stack snapshot into a list of return addresses. \class Unwinder
+class Unwinder
+{
+public:
+
+    /// @brief Enum selecting how caller frames are recovered. \enum Method
+    enum class Method : uint8_t
+    {
+        FramePointer,
+        Dwarf
+    };
+
+#if defined(__x86_64__)
+    static constexpr uint16_t stackPointerRegister = 7;
+    static constexpr uint16_t framePointerRegister = 6;
+#elif defined(__aarch64__)
+    static constexpr uint16_t stackPointerRegister = 31;
+    static constexpr uint16_t framePointerRegister = 29;
+    static constexpr uint16_t linkRegister = 30;
+#else
+    static constexpr uint16_t stackPointerRegister = 0xffff;
+    static constexpr uint16_t framePointerRegister = 0xffff;
+#endif
+
+    /**
+     * @brief Unwinds a snapshot. The DWARF method evaluates .eh_frame per frame and steps through
+     *        the frame-pointer chain where a module has no CFI for the address. Only the copied stack
+     *        is read, so the thread may already run again; a stack deeper than the copy ends at its bound.
+     * @param snapshot The register and stack snapshot of a stopped thread.
+     * @param modules The mappings of the process the snapshot belongs to.
+     * @param method The unwinding method.
+     * @param maxFrames The maximum number of addresses to return.
+     * @return The program counter followed by the return addresses.
+     */
+    [[nodiscard]] static std::vector<uintptr_t> unwind(
+        const StackSnapshot& snapshot,
+        const ModuleMap& modules,
+        Method method,
+        size_t maxFrames) noexcept;
+
+    /**
+     * @brief Unwinds a snapshot into a caller-provided buffer without allocating.
+     * @param snapshot The register and stack snapshot of a stopped thread.
+     * @param modules The mappings of the process the snapshot belongs to.
+     * @param method The unwinding method.
+     * @param addresses Receives the program counter followed by the return addresses; its size is the frame limit.
+     * @return The number of addresses written.
+     */
+    [[nodiscard]] static size_t unwind(
+        const StackSnapshot& snapshot,
+        const ModuleMap& modules,
+        Method method,
+        std::span<uintptr_t> addresses) noexcept;
+
+    /**
+     * @brief Converts the unwinding method of the public session options.
+     * @param method The method chosen in TraceSession::Options.
+     * @return The matching method.
+     */
+    [[nodiscard]] static constexpr Method fromSession(const TraceSession::UnwindMethod method) noexcept
+    {
+        return method == TraceSession::UnwindMethod::FramePointer ? Method::FramePointer : Method::Dwarf;
+    }
+
+    /**
+     * @brief Parses an unwinding method name.
+     * @param name Either "fp" or "dwarf".
+     * @return The method, or std::nullopt if the name is unknown.
+     */
+    [[nodiscard]] static std::optional<Method> parseMethod(std::string_view name) noexcept;
+
+private:
+
+    /**
+     * @brief Private destructor to prevent deletion of this utility class.
+     */
+    ~Unwinder() = delete;
+};
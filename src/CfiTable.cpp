@@ -0,0 +1,581 @@
+#include "CfiTable.h"
+#include "DwarfReader.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <utility>
+
+/// @brief Anonymous namespace
+namespace
+{
+    constexpr size_t trackedColumns = 33;
+    constexpr uint8_t encodingOmit = 0xff;
+    constexpr uint8_t encodingDatarelSdata4 = 0x3b;
+
+    /// @brief Cie holds the parts of a common information entry needed to evaluate its FDEs. \struct Cie
+    struct Cie
+    {
+        uint64_t codeAlign{1};
+        int64_t dataAlign{1};
+        uint64_t returnAddressRegister{0};
+        uint8_t fdeEncoding{0};
+        bool hasAugmentationData{false};
+        size_t instructionsBegin{0};
+        size_t instructionsEnd{0};
+    };
+
+    /// @brief State is the register rule set while executing call frame instructions. \struct State
+    struct State
+    {
+        uint16_t cfaRegister{0};
+        int64_t cfaOffset{0};
+        bool cfaIsExpression{false};
+        std::array<CfiTable::RegisterRule, trackedColumns> registers{};
+    };
+
+    std::optional<uint64_t> readEncoded(
+        DwarfReader& reader,
+        const uint8_t encoding,
+        const uint64_t sectionAddress,
+        const uint64_t dataRelBase) noexcept
+    {
+        if (encoding == encodingOmit)
+        {
+            return std::nullopt;
+        }
+
+        const auto fieldAddress = sectionAddress + reader.offset();
+        uint64_t value = 0;
+
+        switch (encoding & 0x0f)
+        {
+            case 0x00: value = reader.unsignedOfSize(sizeof(uintptr_t)); break;
+            case 0x01: value = reader.uleb128(); break;
+            case 0x02: value = reader.u16(); break;
+            case 0x03: value = reader.u32(); break;
+            case 0x04: value = reader.u64(); break;
+            case 0x09: value = static_cast<uint64_t>(reader.sleb128()); break;
+            case 0x0a: value = static_cast<uint64_t>(static_cast<int64_t>(static_cast<int16_t>(reader.u16()))); break;
+            case 0x0b: value = static_cast<uint64_t>(static_cast<int64_t>(static_cast<int32_t>(reader.u32()))); break;
+            case 0x0c: value = reader.u64(); break;
+            default:   return std::nullopt;
+        }
+
+        switch (encoding & 0x70)
+        {
+            case 0x00: break;
+            case 0x10: value += fieldAddress; break;
+            case 0x30: value += dataRelBase; break;
+            default:   return std::nullopt;
+        }
+
+        if ((encoding & 0x80) != 0 || !reader.ok())
+        {
+            return std::nullopt;
+        }
+
+        return value;
+    }
+
+    std::optional<Cie> parseCie(const std::span<const std::byte> ehFrame, const uint64_t ehFrameAddress, const size_t offset) noexcept
+    {
+        DwarfReader reader(ehFrame);
+        reader.seek(offset);
+
+        size_t offsetSize = 4;
+        const auto length = reader.initialLength(offsetSize);
+        if (!reader.ok() || length == 0 || length > reader.remaining())
+        {
+            return std::nullopt;
+        }
+
+        const auto end = reader.offset() + static_cast<size_t>(length);
+        if (reader.unsignedOfSize(offsetSize) != 0)
+        {
+            return std::nullopt;
+        }
+
+        Cie cie;
+        const auto version = reader.u8();
+        const auto augmentation = reader.cstring();
+
+        if (augmentation.find("eh") != std::string_view::npos)
+        {
+            reader.skip(sizeof(uintptr_t));
+        }
+
+        cie.codeAlign = reader.uleb128();
+        cie.dataAlign = reader.sleb128();
+        cie.returnAddressRegister = version == 1 ? reader.u8() : reader.uleb128();
+
+        if (augmentation.starts_with('z'))
+        {
+            cie.hasAugmentationData = true;
+            const auto augLength = static_cast<size_t>(reader.uleb128());
+            const auto augEnd = reader.offset() + augLength;
+
+            for (const char c : augmentation.substr(1))
+            {
+                if (c == 'R')
+                {
+                    cie.fdeEncoding = reader.u8();
+                }
+                else if (c == 'P')
+                {
+                    const auto personalityEncoding = reader.u8();
+                    static_cast<void>(readEncoded(reader, personalityEncoding & 0x0f, ehFrameAddress, 0));
+                }
+                else if (c == 'L')
+                {
+                    reader.skip(1);
+                }
+                else if (c != 'S' && c != 'B')
+                {
+                    break;
+                }
+            }
+            reader.seek(augEnd);
+        }
+
+        if (!reader.ok() || reader.offset() > end)
+        {
+            return std::nullopt;
+        }
+
+        cie.instructionsBegin = reader.offset();
+        cie.instructionsEnd = end;
+        return cie;
+    }
+
+    CfiTable::RegisterRule makeRule(const CfiTable::RuleKind kind, const int64_t value) noexcept
+    {
+        return CfiTable::RegisterRule{kind, static_cast<int32_t>(std::clamp<int64_t>(value, INT32_MIN, INT32_MAX))};
+    }
+}
+
+CfiTable CfiTable::build(const ElfFile& elf, const uint16_t framePointerRegister)
+{
+    CfiTable table;
+    table.m_framePointerRegister = framePointerRegister;
+
+    const auto ehFrame = elf.findSection(".eh_frame");
+    if (!ehFrame || ehFrame->data.empty())
+    {
+        return table;
+    }
+
+    table.m_ehFrame = ehFrame->data;
+    table.m_ehFrameAddress = ehFrame->address;
+
+    if (const auto hdr = elf.findSection(".eh_frame_hdr"); hdr && hdr->data.size() >= 4)
+    {
+        DwarfReader reader(hdr->data);
+        const auto version = reader.u8();
+        const auto ehFramePtrEncoding = reader.u8();
+        const auto countEncoding = reader.u8();
+        const auto tableEncoding = reader.u8();
+
+        const auto ehFramePtr = readEncoded(reader, ehFramePtrEncoding, hdr->address, hdr->address);
+        const auto count = readEncoded(reader, countEncoding, hdr->address, hdr->address);
+
+        if (version == 1 && tableEncoding == encodingDatarelSdata4 && ehFramePtr == ehFrame->address && count
+            && *count <= reader.remaining() / 8)
+        {
+            table.m_hdrTable = reader.bytes(static_cast<size_t>(*count) * 8);
+            table.m_hdrAddress = hdr->address;
+            return table;
+        }
+    }
+
+    table.scanEhFrame();
+    return table;
+}
+
+CfiTable::CfiTable(CfiTable&& other) noexcept
+    : m_ehFrame(other.m_ehFrame)
+    , m_ehFrameAddress(other.m_ehFrameAddress)
+    , m_hdrTable(other.m_hdrTable)
+    , m_hdrAddress(other.m_hdrAddress)
+    , m_fdes(std::move(other.m_fdes))
+    , m_framePointerRegister(other.m_framePointerRegister)
+{
+    const std::scoped_lock lock(other.m_cacheMutex);
+    m_cache = std::move(other.m_cache);
+}
+
+CfiTable& CfiTable::operator=(CfiTable&& other) noexcept
+{
+    if (this != &other)
+    {
+        const std::scoped_lock lock(m_cacheMutex, other.m_cacheMutex);
+        m_ehFrame = other.m_ehFrame;
+        m_ehFrameAddress = other.m_ehFrameAddress;
+        m_hdrTable = other.m_hdrTable;
+        m_hdrAddress = other.m_hdrAddress;
+        m_fdes = std::move(other.m_fdes);
+        m_framePointerRegister = other.m_framePointerRegister;
+        m_cache = std::move(other.m_cache);
+    }
+    return *this;
+}
+
+std::optional<CfiTable::Row> CfiTable::find(const uint64_t address) const
+{
+    const auto fdeOffset = findFdeOffset(address);
+    if (!fdeOffset)
+    {
+        return std::nullopt;
+    }
+
+    const std::scoped_lock lock(m_cacheMutex);
+
+    auto it = m_cache.find(*fdeOffset);
+    if (it == m_cache.end())
+    {
+        it = m_cache.emplace(*fdeOffset, decodeFde(*fdeOffset).value_or(DecodedFde{})).first;
+    }
+
+    const auto& decoded = it->second;
+    if (address < decoded.pcBegin || address >= decoded.pcEnd || decoded.rows.empty())
+    {
+        return std::nullopt;
+    }
+
+    const auto row = std::ranges::upper_bound(decoded.rows, address, {}, &Row::location);
+    if (row == decoded.rows.begin())
+    {
+        return std::nullopt;
+    }
+    return *std::prev(row);
+}
+
+std::optional<uint64_t> CfiTable::findFdeOffset(const uint64_t address) const noexcept
+{
+    if (!m_hdrTable.empty())
+    {
+        const auto count = m_hdrTable.size() / 8;
+        auto entryAt = [this](const size_t index, const size_t field)
+        {
+            int32_t value = 0;
+            std::memcpy(&value, m_hdrTable.data() + index * 8 + field * 4, sizeof(value));
+            return m_hdrAddress + static_cast<uint64_t>(static_cast<int64_t>(value));
+        };
+
+        size_t low = 0;
+        size_t high = count;
+        while (low < high)
+        {
+            const auto mid = low + (high - low) / 2;
+            if (entryAt(mid, 0) <= address)
+            {
+                low = mid + 1;
+            }
+            else
+            {
+                high = mid;
+            }
+        }
+
+        if (low == 0)
+        {
+            return std::nullopt;
+        }
+
+        const auto fdeAddress = entryAt(low - 1, 1);
+        if (fdeAddress < m_ehFrameAddress)
+        {
+            return std::nullopt;
+        }
+        return fdeAddress - m_ehFrameAddress;
+    }
+
+    const auto it = std::ranges::upper_bound(m_fdes, address, {}, &Fde::pcBegin);
+    if (it == m_fdes.begin())
+    {
+        return std::nullopt;
+    }
+    return std::prev(it)->offset;
+}
+
+std::optional<CfiTable::DecodedFde> CfiTable::decodeFde(const uint64_t offset) const
+{
+    if (offset >= m_ehFrame.size())
+    {
+        return std::nullopt;
+    }
+
+    DwarfReader reader(m_ehFrame);
+    reader.seek(static_cast<size_t>(offset));
+
+    size_t offsetSize = 4;
+    const auto length = reader.initialLength(offsetSize);
+    if (!reader.ok() || length == 0 || length > reader.remaining())
+    {
+        return std::nullopt;
+    }
+
+    const auto end = reader.offset() + static_cast<size_t>(length);
+    const auto ciePointerPosition = reader.offset();
+    const auto ciePointer = reader.unsignedOfSize(offsetSize);
+    if (ciePointer == 0 || ciePointer > ciePointerPosition)
+    {
+        return std::nullopt;
+    }
+
+    const auto cie = parseCie(m_ehFrame, m_ehFrameAddress, ciePointerPosition - static_cast<size_t>(ciePointer));
+    if (!cie)
+    {
+        return std::nullopt;
+    }
+
+    const auto pcBegin = readEncoded(reader, cie->fdeEncoding, m_ehFrameAddress, m_hdrAddress);
+    const auto pcRange = readEncoded(reader, cie->fdeEncoding & 0x0f, m_ehFrameAddress, m_hdrAddress);
+    if (!pcBegin || !pcRange)
+    {
+        return std::nullopt;
+    }
+
+    if (cie->hasAugmentationData)
+    {
+        reader.skip(static_cast<size_t>(reader.uleb128()));
+    }
+
+    if (!reader.ok() || reader.offset() > end)
+    {
+        return std::nullopt;
+    }
+
+    DecodedFde decoded;
+    decoded.pcBegin = *pcBegin;
+    decoded.pcEnd = *pcBegin + *pcRange;
+
+    const auto raColumn = static_cast<size_t>(cie->returnAddressRegister);
+    const auto fpColumn = static_cast<size_t>(m_framePointerRegister);
+    if (raColumn >= trackedColumns || fpColumn >= trackedColumns)
+    {
+        return std::nullopt;
+    }
+
+    State state;
+    State initialState;
+    std::vector<State> stateStack;
+    uint64_t location = *pcBegin;
+
+    auto emitRow = [&]()
+    {
+        Row row;
+        row.location = location;
+        row.cfaRegister = state.cfaRegister;
+        row.cfaOffset = static_cast<int32_t>(std::clamp<int64_t>(state.cfaOffset, INT32_MIN, INT32_MAX));
+        row.cfaIsExpression = state.cfaIsExpression;
+        row.returnAddress = state.registers[raColumn];
+        row.framePointer = state.registers[fpColumn];
+
+        if (!decoded.rows.empty() && decoded.rows.back().location == location)
+        {
+            decoded.rows.back() = row;
+        }
+        else
+        {
+            decoded.rows.push_back(row);
+        }
+    };
+
+    auto setRule = [&state](const uint64_t column, const RegisterRule rule)
+    {
+        if (column < trackedColumns)
+        {
+            state.registers[static_cast<size_t>(column)] = rule;
+        }
+    };
+
+    auto restoreRule = [&state, &initialState](const uint64_t column)
+    {
+        if (column < trackedColumns)
+        {
+            state.registers[static_cast<size_t>(column)] = initialState.registers[static_cast<size_t>(column)];
+        }
+    };
+
+    auto execute = [&](const size_t begin, const size_t instructionsEnd, const bool stopAfterLocation, const uint64_t stopLocation)
+    {
+        DwarfReader insn(m_ehFrame.first(instructionsEnd));
+        insn.seek(begin);
+
+        while (insn.ok() && !insn.atEnd())
+        {
+            const auto opcode = insn.u8();
+            const auto high = opcode & 0xc0;
+            const auto low = static_cast<uint64_t>(opcode & 0x3f);
+
+            auto advance = [&](const uint64_t delta)
+            {
+                emitRow();
+                location += delta * cie->codeAlign;
+            };
+
+            if (high == 0x40)
+            {
+                advance(low);
+            }
+            else if (high == 0x80)
+            {
+                setRule(low, makeRule(RuleKind::Offset, static_cast<int64_t>(insn.uleb128()) * cie->dataAlign));
+            }
+            else if (high == 0xc0)
+            {
+                restoreRule(low);
+            }
+            else
+            {
+                switch (opcode)
+                {
+                    case 0x00:
+                        break;
+                    case 0x01:
+                        if (const auto target = readEncoded(insn, cie->fdeEncoding, m_ehFrameAddress, m_hdrAddress))
+                        {
+                            emitRow();
+                            location = *target;
+                        }
+                        break;
+                    case 0x02: advance(insn.u8()); break;
+                    case 0x03: advance(insn.u16()); break;
+                    case 0x04: advance(insn.u32()); break;
+                    case 0x05:
+                    {
+                        const auto reg = insn.uleb128();
+                        setRule(reg, makeRule(RuleKind::Offset, static_cast<int64_t>(insn.uleb128()) * cie->dataAlign));
+                        break;
+                    }
+                    case 0x06: restoreRule(insn.uleb128()); break;
+                    case 0x07: setRule(insn.uleb128(), makeRule(RuleKind::Undefined, 0)); break;
+                    case 0x08: setRule(insn.uleb128(), makeRule(RuleKind::SameValue, 0)); break;
+                    case 0x09:
+                    {
+                        const auto reg = insn.uleb128();
+                        setRule(reg, makeRule(RuleKind::Register, static_cast<int64_t>(insn.uleb128())));
+                        break;
+                    }
+                    case 0x0a: stateStack.push_back(state); break;
+                    case 0x0b:
+                        if (!stateStack.empty())
+                        {
+                            state = stateStack.back();
+                            stateStack.pop_back();
+                        }
+                        break;
+                    case 0x0c:
+                        state.cfaRegister = static_cast<uint16_t>(insn.uleb128());
+                        state.cfaOffset = static_cast<int64_t>(insn.uleb128());
+                        state.cfaIsExpression = false;
+                        break;
+                    case 0x0d:
+                        state.cfaRegister = static_cast<uint16_t>(insn.uleb128());
+                        state.cfaIsExpression = false;
+                        break;
+                    case 0x0e:
+                        state.cfaOffset = static_cast<int64_t>(insn.uleb128());
+                        break;
+                    case 0x0f:
+                        insn.skip(static_cast<size_t>(insn.uleb128()));
+                        state.cfaIsExpression = true;
+                        break;
+                    case 0x10:
+                    case 0x16:
+                    {
+                        const auto reg = insn.uleb128();
+                        insn.skip(static_cast<size_t>(insn.uleb128()));
+                        setRule(reg, makeRule(RuleKind::Expression, 0));
+                        break;
+                    }
+                    case 0x11:
+                    {
+                        const auto reg = insn.uleb128();
+                        setRule(reg, makeRule(RuleKind::Offset, insn.sleb128() * cie->dataAlign));
+                        break;
+                    }
+                    case 0x12:
+                        state.cfaRegister = static_cast<uint16_t>(insn.uleb128());
+                        state.cfaOffset = insn.sleb128() * cie->dataAlign;
+                        state.cfaIsExpression = false;
+                        break;
+                    case 0x13:
+                        state.cfaOffset = insn.sleb128() * cie->dataAlign;
+                        break;
+                    case 0x14:
+                    {
+                        const auto reg = insn.uleb128();
+                        setRule(reg, makeRule(RuleKind::ValOffset, static_cast<int64_t>(insn.uleb128()) * cie->dataAlign));
+                        break;
+                    }
+                    case 0x15:
+                    {
+                        const auto reg = insn.uleb128();
+                        setRule(reg, makeRule(RuleKind::ValOffset, insn.sleb128() * cie->dataAlign));
+                        break;
+                    }
+                    case 0x2e:
+                        insn.skipLeb128();
+                        break;
+                    case 0x2f:
+                    {
+                        const auto reg = insn.uleb128();
+                        setRule(reg, makeRule(RuleKind::Offset, -static_cast<int64_t>(insn.uleb128()) * cie->dataAlign));
+                        break;
+                    }
+                    default:
+                        return;
+                }
+            }
+
+            if (stopAfterLocation && location > stopLocation)
+            {
+                return;
+            }
+        }
+    };
+
+    execute(cie->instructionsBegin, cie->instructionsEnd, false, 0);
+    initialState = state;
+    execute(reader.offset(), end, true, decoded.pcEnd);
+    emitRow();
+
+    return decoded;
+}
+
+void CfiTable::scanEhFrame()
+{
+    DwarfReader reader(m_ehFrame);
+
+    while (!reader.atEnd())
+    {
+        const auto entryOffset = reader.offset();
+        size_t offsetSize = 4;
+        const auto length = reader.initialLength(offsetSize);
+        if (!reader.ok() || length == 0 || length > reader.remaining())
+        {
+            break;
+        }
+
+        const auto end = reader.offset() + static_cast<size_t>(length);
+        const auto ciePointerPosition = reader.offset();
+        const auto ciePointer = reader.unsignedOfSize(offsetSize);
+
+        if (ciePointer != 0 && ciePointer <= ciePointerPosition)
+        {
+            if (const auto cie = parseCie(m_ehFrame, m_ehFrameAddress, ciePointerPosition - static_cast<size_t>(ciePointer)))
+            {
+                const auto pcBegin = readEncoded(reader, cie->fdeEncoding, m_ehFrameAddress, 0);
+                if (pcBegin && *pcBegin != 0)
+                {
+                    m_fdes.push_back(Fde{*pcBegin, entryOffset});
+                }
+            }
+        }
+
+        reader.seek(end);
+    }
+
+    std::ranges::sort(m_fdes, {}, &Fde::pcBegin);
+}
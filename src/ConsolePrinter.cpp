@@ -1,11 +1,46 @@
 #include "ConsolePrinter.h"
-#include <format>
+#include <cerrno>
 #include <iostream>
-#include <print>
 #include <unistd.h>
 
+/// @brief Anonymous namespace
+namespace
+{
+    constexpr std::string_view resetCode = "\033[0m";
+
+    int descriptorOf(const std::ostream& os) noexcept
+    {
+        if (&os == &std::cout)
+        {
+            return STDOUT_FILENO;
+        }
+        if (&os == &std::cerr)
+        {
+            return STDERR_FILENO;
+        }
+        return -1;
+    }
+
+    std::string_view stateName(const char state) noexcept
+    {
+        switch (state)
+        {
+            case 'R': return "running";
+            case 'S': return "sleeping";
+            case 'D': return "in uninterruptible wait";
+            case 'T': return "stopped";
+            case 't': return "traced";
+            case 'Z': return "zombie";
+            case 'X': return "dead";
+            case 'I': return "idle";
+            default:  return "in an unknown state";
+        }
+    }
+}
+
 ConsolePrinter::ConsolePrinter(std::ostream& os) noexcept
     : m_outputStream(os)
+    , m_outputFd(descriptorOf(os))
     , m_useColors(&os == &std::cout && isatty(STDOUT_FILENO))
 {
 
@@ -13,6 +48,7 @@ ConsolePrinter::ConsolePrinter(std::ostream& os) noexcept
 
 ConsolePrinter::ConsolePrinter() noexcept
     : m_outputStream(std::cout)
+    , m_outputFd(STDOUT_FILENO)
     , m_useColors(isatty(STDOUT_FILENO))
 {
 
@@ -20,43 +56,203 @@ ConsolePrinter::ConsolePrinter() noexcept
 
 void ConsolePrinter::printStackTrace(const std::vector<StackFrame>& frames) const
 {
-    std::println(m_outputStream, "{}", colorize("\nStack Trace:", Color::Cyan, true));
+    appendStackTrace(frames);
+    flush();
+}
 
-    for (size_t i = 0; i < frames.size(); ++i)
+void ConsolePrinter::printThreadGroups(const ThreadGroups& groups) const
+{
+    for (const auto& group : groups.groups())
     {
-        printFrame(frames[i], i);
-    }
+        beginColor(Color::Blue, true);
+        m_buffer += "[INFO] ";
+        endColor();
+        append("{} thread(s): ", group.tids->size());
 
-    std::println(m_outputStream, "");
+        bool first = true;
+        for (const auto tid : *group.tids)
+        {
+            append("{}{}", first ? "" : ",", tid);
+            first = false;
+        }
+        m_buffer += '\n';
+
+        appendStackTrace(groups.frames(*group.addresses));
+        flushIfFull();
+    }
+    flush();
 }
 
-void ConsolePrinter::printError(std::string_view message) const
+void ConsolePrinter::printStackTrie(const ThreadGroups::TrieNode& root) const
 {
-    std::println(m_outputStream, "{}{}", colorize("[ERROR] ", Color::Red, true), message);
+    beginColor(Color::Cyan, true);
+    append("\nStack Tree ({} threads):", root.threadCount);
+    endColor();
+    m_buffer += '\n';
+
+    for (const auto& child : root.children)
+    {
+        appendTrieNode(child, root.children.size() > 1 ? 1 : 0);
+    }
+
+    m_buffer += '\n';
+    flush();
 }
 
-void ConsolePrinter::printSuccess(std::string_view message) const
+void ConsolePrinter::printStackChanges(const std::span<const StackWatcher::Change> changes) const
 {
-    std::println(m_outputStream, "{}{}", colorize("[SUCCESS] ", Color::Green, true), message);
+    using enum StackWatcher::ChangeKind;
+
+    for (const auto& change : changes)
+    {
+        beginColor(Color::Blue, true);
+        m_buffer += "[INFO] ";
+        endColor();
+
+        if (change.kind == Exited)
+        {
+            append("Thread {} exited\n", change.tid);
+            continue;
+        }
+
+        const auto& frames = *change.frames;
+        if (change.kind == Started)
+        {
+            append("Thread {} started\n", change.tid);
+        }
+        else
+        {
+            append("Thread {} changed, {} of {} frames differ\n", change.tid, change.changedFrames, frames.size());
+        }
+
+        for (size_t i = 0; i < frames.size(); ++i)
+        {
+            appendWatchedFrame(frames[i], i, change.kind == Changed && i < change.changedFrames);
+        }
+        m_buffer += '\n';
+        flushIfFull();
+    }
+    flush();
 }
 
-void ConsolePrinter::printInfo(std::string_view message) const
+void ConsolePrinter::printHangReport(const HangDetector::Report& report) const
 {
-    std::println(m_outputStream, "{}{}", colorize("[INFO] ", Color::Blue, true), message);
+    const auto seconds = std::chrono::duration<double>(report.window).count();
+
+    for (const auto& thread : report.stuck)
+    {
+        beginColor(Color::Yellow, true);
+        m_buffer += "[WARNING] ";
+        endColor();
+        append("Thread {} ({}) did not move in {} samples over {:.1f} s, in ", thread.tid, thread.name, report.samples, seconds);
+        appendSyscall(thread.syscall);
+        if (thread.owner != 0)
+        {
+            append(", held by thread {}", thread.owner);
+        }
+        m_buffer += '\n';
+        appendStackTrace(thread.frames);
+    }
+
+    for (const auto& cycle : report.cycles)
+    {
+        beginColor(Color::Red, true);
+        m_buffer += "[ERROR] ";
+        endColor();
+        m_buffer += "Lock cycle between threads ";
+        for (const auto tid : cycle)
+        {
+            append("{} -> ", tid);
+        }
+        append("{}\n", cycle.front());
+    }
+
+    for (const auto& convoy : report.convoys)
+    {
+        beginColor(Color::Yellow, true);
+        m_buffer += "[WARNING] ";
+        endColor();
+        append("Convoy: {} threads wait on futex 0x{:x}", convoy.waiters.size(), convoy.futexAddress);
+        if (convoy.owner != 0)
+        {
+            append(", held by thread {}", convoy.owner);
+        }
+        m_buffer += ':';
+        for (const auto tid : convoy.waiters)
+        {
+            append(" {}", tid);
+        }
+        m_buffer += '\n';
+    }
+    flush();
 }
 
-void ConsolePrinter::printWarning(std::string_view message) const
+void ConsolePrinter::printThreadHeader(const StackTrace::ThreadStack& thread) const
 {
-    std::println(m_outputStream, "{}{}", colorize("[WARNING] ", Color::Yellow, true), message);
+    const auto& state = thread.state;
+    const auto toMillis = [](const std::chrono::nanoseconds duration)
+    {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    };
+
+    beginColor(Color::Blue, true);
+    m_buffer += "[INFO] ";
+    endColor();
+    append("Thread {} ({}) {}, in ", thread.tid, thread.name, stateName(state.state));
+    appendSyscall(state.syscall);
+    if (!state.wchan.empty())
+    {
+        append(", wchan {}", state.wchan);
+    }
+    append(", {} voluntary / {} involuntary switches, {:.3f} ms on CPU, {:.3f} ms runnable\n",
+        state.voluntarySwitches, state.involuntarySwitches, toMillis(state.runTime), toMillis(state.runQueueTime));
+    flush();
 }
 
-std::string ConsolePrinter::colorize(const std::string_view text, const Color color, const bool bold) const
+void ConsolePrinter::printProcessTable(const std::span<const ProcessScanner::ProcessInfo> processes) const
 {
-    if (!m_useColors)
+    beginColor(Color::Cyan, true);
+    append("{:>8} {:>8} {:>6} {:1} {:>5} {:>10} {:>10}  {}", "PID", "PPID", "UID", "S", "THR", "RSS(MiB)", "CPU(s)", "NAME");
+    endColor();
+    m_buffer += '\n';
+
+    for (const auto& process : processes)
     {
-        return std::string(text);
+        const auto rssMiB = static_cast<double>(process.rssBytes) / (1024.0 * 1024.0);
+        const auto stateColor = process.state == 'R' ? Color::Green : process.state == 'D' || process.state == 'Z' ? Color::Red : Color::Default;
+
+        append("{:>8} {:>8} {:>6} ", process.pid, process.parentPid, process.uid);
+        beginColor(stateColor);
+        m_buffer += process.state;
+        endColor();
+        append(" {:>5} {:>10.1f} {:>10.2f}  {}\n", process.threads, rssMiB, process.cpuSeconds(), process.name);
+        flushIfFull();
     }
-    return std::format("{}{}\033[0m", getColorCode(color, bold), text);
+    flush();
+}
+
+void ConsolePrinter::printError(std::string_view message) const
+{
+    appendMessage("[ERROR] ", Color::Red, message);
+    flush();
+}
+
+void ConsolePrinter::printSuccess(std::string_view message) const
+{
+    appendMessage("[SUCCESS] ", Color::Green, message);
+    flush();
+}
+
+void ConsolePrinter::printInfo(std::string_view message) const
+{
+    appendMessage("[INFO] ", Color::Blue, message);
+    flush();
+}
+
+void ConsolePrinter::printWarning(std::string_view message) const
+{
+    appendMessage("[WARNING] ", Color::Yellow, message);
+    flush();
 }
 
 std::string_view ConsolePrinter::getColorCode(const Color color, const bool bold)noexcept
@@ -91,27 +287,185 @@ std::string_view ConsolePrinter::getColorCode(const Color color, const bool bold
     }
 }
 
-void ConsolePrinter::printFrame(const StackFrame& frame, const size_t index) const
+void ConsolePrinter::beginColor(const Color color, const bool bold) const
 {
-    std::string frameStr;
+    if (m_useColors)
+    {
+        m_buffer += getColorCode(color, bold);
+    }
+}
 
-    if (!frame.hasSymbolInfo())
+void ConsolePrinter::endColor() const
+{
+    if (m_useColors)
+    {
+        m_buffer += resetCode;
+    }
+}
+
+void ConsolePrinter::appendMessage(const std::string_view prefix, const Color color, const std::string_view message) const
+{
+    beginColor(color, true);
+    m_buffer += prefix;
+    endColor();
+    m_buffer += message;
+    m_buffer += '\n';
+}
+
+void ConsolePrinter::appendStackTrace(const std::vector<StackFrame>& frames) const
+{
+    beginColor(Color::Cyan, true);
+    m_buffer += "\nStack Trace:";
+    endColor();
+    m_buffer += '\n';
+
+    for (size_t i = 0; i < frames.size(); ++i)
+    {
+        appendFrame(frames[i], i);
+    }
+
+    m_buffer += '\n';
+    flushIfFull();
+}
+
+void ConsolePrinter::flush() const
+{
+    if (m_buffer.empty())
+    {
+        return;
+    }
+
+    if (m_outputFd == -1)
+    {
+        m_outputStream.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+        m_buffer.clear();
+        return;
+    }
+
+    // Anything written to the stream directly must come out first.
+    m_outputStream.flush();
+
+    const char* data = m_buffer.data();
+    size_t remaining = m_buffer.size();
+    while (remaining > 0)
+    {
+        const auto written = write(m_outputFd, data, remaining);
+        if (written == -1 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            break;
+        }
+        data += written;
+        remaining -= static_cast<size_t>(written);
+    }
+    m_buffer.clear();
+}
+
+void ConsolePrinter::appendFrame(const StackFrame& frame, const size_t index) const
+{
+    beginColor((index % 2) != 0 ? Color::Magenta : Color::Cyan);
+    append("{:2}# ", index);
+    appendFrameText(frame);
+    endColor();
+    m_buffer += '\n';
+}
+
+void ConsolePrinter::appendWatchedFrame(const StackFrame& frame, const size_t index, const bool changed) const
+{
+    if (changed)
+    {
+        beginColor(Color::Yellow, true);
+    }
+    append("{}{:2}# ", changed ? '*' : ' ', index);
+    appendFrameText(frame);
+    if (changed)
+    {
+        endColor();
+    }
+    m_buffer += '\n';
+}
+
+void ConsolePrinter::appendSyscall(const std::optional<StackSnapshot::Syscall>& syscall) const
+{
+    if (!syscall)
     {
-        frameStr = std::format("{:2}# 0x{:x}", index, frame.getAddress());
+        m_buffer += "an unknown state";
+        return;
+    }
+    if (syscall->number == StackSnapshot::notInSyscall)
+    {
+        m_buffer += "user code";
+        return;
+    }
+
+    const auto name = HangDetector::syscallName(syscall->number);
+    if (name.empty())
+    {
+        append("syscall {}", syscall->number);
     }
     else
     {
-        frameStr = std::format("{:2}# {}", index, frame.getFunctionName());
-        if (!frame.getSourceFile().empty())
+        m_buffer += name;
+    }
+    append("(0x{:x}, 0x{:x}, 0x{:x})", syscall->args[0], syscall->args[1], syscall->args[2]);
+}
+
+void ConsolePrinter::appendFrameText(const StackFrame& frame) const
+{
+    if (!frame.hasSymbolInfo())
+    {
+        const auto module = frame.getModule();
+        if (module.empty())
+        {
+            append("0x{:x}", frame.getAddress());
+            return;
+        }
+        append("0x{:x} in {}", frame.getAddress(), module.substr(module.rfind('/') + 1));
+        return;
+    }
+
+    m_buffer += frame.getFunctionName();
+    if (!frame.getSourceFile().empty())
+    {
+        m_buffer += " at ";
+        m_buffer += frame.getSourceFile();
+        if (frame.getLineNumber() != 0)
         {
-            frameStr += std::format(" at {}", frame.getSourceFile());
-            if (frame.getLineNumber() != 0)
-            {
-                frameStr += std::format(":{}", frame.getLineNumber());
-            }
+            append(":{}", frame.getLineNumber());
         }
     }
+}
+
+void ConsolePrinter::appendTrieNode(const ThreadGroups::TrieNode& node, const size_t depth) const
+{
+    beginColor((depth % 2) != 0 ? Color::Magenta : Color::Cyan);
+    append("{:>6}  ", node.threadCount);
+    m_buffer.append(depth * 2, ' ');
+    if (node.frame != nullptr)
+    {
+        appendFrameText(*node.frame);
+    }
+    else
+    {
+        append("0x{:x}", node.address);
+    }
+    endColor();
+    m_buffer += '\n';
+
+    if (!node.tids.empty() && !node.children.empty())
+    {
+        append("{:>6}  ", "");
+        m_buffer.append(depth * 2, ' ');
+        append("  <{} thread(s) stop here>\n", node.tids.size());
+    }
 
-    const auto frameColor = (index % 2) != 0 ? Color::Magenta : Color::Cyan;
-    std::println(m_outputStream, "{}", colorize(frameStr, frameColor));
-}
\ No newline at end of file
+    const auto childDepth = node.children.size() > 1 ? depth + 1 : depth;
+    for (const auto& child : node.children)
+    {
+        appendTrieNode(child, childDepth);
+    }
+    flushIfFull();
+}
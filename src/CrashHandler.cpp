@@ -0,0 +1,312 @@
+#include "CrashHandler.h"
+#include "PlatformUtils.h"
+#include "SelfTrace.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+/// @brief Anonymous namespace
+namespace
+{
+#if defined(__x86_64__)
+    constexpr std::array<std::string_view, NGREG> registerNames{
+        "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15", "rdi", "rsi", "rbp", "rbx",
+        "rdx", "rax", "rcx", "rsp", "rip", "eflags", "csgsfs", "err", "trapno", "oldmask", "cr2"
+    };
+#elif defined(__aarch64__)
+    constexpr std::array<std::string_view, 34> registerNames{
+        "x0", "x1", "x2", "x3", "x4", "x5", "x6", "x7", "x8", "x9", "x10", "x11", "x12", "x13", "x14", "x15", "x16",
+        "x17", "x18", "x19", "x20", "x21", "x22", "x23", "x24", "x25", "x26", "x27", "x28", "fp", "lr", "sp", "pc", "pstate"
+    };
+#else
+    constexpr std::array<std::string_view, 0> registerNames{};
+#endif
+
+    // Everything the handler touches is set up by install(); nothing is allocated once a signal arrives.
+    std::atomic<int> crashFd{-1};
+    char* mapsBuffer{nullptr};
+    std::atomic_flag handling;
+
+    size_t readRegisters(const void* context, std::span<uint64_t> registers, uintptr_t& programCounter) noexcept
+    {
+        const auto& machine = static_cast<const ucontext_t*>(context)->uc_mcontext;
+#if defined(__x86_64__)
+        for (size_t i = 0; i < registerNames.size(); ++i)
+        {
+            registers[i] = static_cast<uint64_t>(machine.gregs[i]);
+        }
+        programCounter = static_cast<uintptr_t>(machine.gregs[REG_RIP]);
+#elif defined(__aarch64__)
+        for (size_t i = 0; i < 31; ++i)
+        {
+            registers[i] = machine.regs[i];
+        }
+        registers[31] = machine.sp;
+        registers[32] = machine.pc;
+        registers[33] = machine.pstate;
+        programCounter = machine.pc;
+#else
+        static_cast<void>(machine);
+        static_cast<void>(registers);
+        programCounter = 0;
+#endif
+        return registerNames.size();
+    }
+
+    void writeAll(const int fd, const void* data, size_t size) noexcept
+    {
+        const auto* bytes = static_cast<const char*>(data);
+        while (size > 0)
+        {
+            const auto written = write(fd, bytes, size);
+            if (written == -1 && errno == EINTR)
+            {
+                continue;
+            }
+            if (written <= 0)
+            {
+                return;
+            }
+            bytes += written;
+            size -= static_cast<size_t>(written);
+        }
+    }
+
+    size_t readMaps() noexcept
+    {
+        const int fd = open("/proc/self/maps", O_RDONLY | O_CLOEXEC);
+        if (fd == -1)
+        {
+            return 0;
+        }
+
+        size_t used = 0;
+        while (used < CrashHandler::maxMapsBytes)
+        {
+            const auto bytesRead = read(fd, mapsBuffer + used, CrashHandler::maxMapsBytes - used);
+            if (bytesRead == -1 && errno == EINTR)
+            {
+                continue;
+            }
+            if (bytesRead <= 0)
+            {
+                break;
+            }
+            used += static_cast<size_t>(bytesRead);
+        }
+        close(fd);
+        return used;
+    }
+
+    void onCrash(const int signal, siginfo_t* info, void* context)
+    {
+        // A second thread crashing meanwhile waits; the first one re-raises and the process dies.
+        if (handling.test_and_set())
+        {
+            for (;;)
+            {
+                pause();
+            }
+        }
+
+        const int savedErrno = errno;
+
+        std::array<uint64_t, registerNames.size() + 1> registers{};
+        uintptr_t programCounter = 0;
+        const auto registerCount = readRegisters(context, registers, programCounter);
+
+        // The walk starts in this handler and crosses the signal frame; the faulting instruction is where the record starts.
+        std::array<uintptr_t, CrashHandler::maxFrames> frames{};
+        auto frameCount = SelfTrace::captureInto(frames);
+        const auto faultFrame = std::find(frames.begin(), frames.begin() + frameCount, programCounter);
+        if (faultFrame != frames.begin() + frameCount)
+        {
+            const auto skipped = static_cast<size_t>(faultFrame - frames.begin());
+            std::copy(faultFrame, frames.begin() + frameCount, frames.begin());
+            frameCount -= skipped;
+        }
+        else
+        {
+            frameCount = std::min(frameCount + 1, frames.size());
+            std::copy_backward(frames.begin(), frames.begin() + frameCount - 1, frames.begin() + frameCount);
+            frames[0] = programCounter;
+        }
+
+        const auto mapsBytes = readMaps();
+
+        timespec now{};
+        clock_gettime(CLOCK_REALTIME, &now);
+
+        CrashHandler::RecordHeader header;
+        header.magic = CrashHandler::recordMagic;
+        header.version = CrashHandler::recordVersion;
+        header.signal = signal;
+        header.code = info->si_code;
+        header.pid = getpid();
+        header.tid = gettid();
+        header.registerCount = static_cast<uint32_t>(registerCount);
+        header.frameCount = static_cast<uint32_t>(frameCount);
+        header.mapsBytes = static_cast<uint32_t>(mapsBytes);
+        header.faultAddress = reinterpret_cast<uintptr_t>(info->si_addr);
+        header.timestampNs = static_cast<uint64_t>(now.tv_sec) * 1'000'000'000 + static_cast<uint64_t>(now.tv_nsec);
+
+        const int fd = crashFd.load(std::memory_order_relaxed);
+        writeAll(fd, &header, sizeof(header));
+        writeAll(fd, registers.data(), registerCount * sizeof(uint64_t));
+        writeAll(fd, frames.data(), frameCount * sizeof(uintptr_t));
+        writeAll(fd, mapsBuffer, mapsBytes);
+
+        // SA_RESETHAND restored the default action, which runs once the handler returns.
+        errno = savedErrno;
+        raise(signal);
+    }
+}
+
+std::expected<void, std::string> CrashHandler::install(const int fd)
+{
+    if (fd < 0)
+    {
+        return std::unexpected(std::string("Invalid crash record file descriptor"));
+    }
+
+    if (mapsBuffer == nullptr)
+    {
+        void* buffer = mmap(nullptr, maxMapsBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (buffer == MAP_FAILED)
+        {
+            return std::unexpected(std::format("Failed to allocate the crash maps buffer: {}", std::strerror(errno)));
+        }
+        mapsBuffer = static_cast<char*>(buffer);
+    }
+
+    if (auto stack = installThreadStack(); !stack)
+    {
+        return stack;
+    }
+
+    // Loads the unwinder now; doing it inside the handler could allocate.
+    SelfTrace::prepare();
+    crashFd.store(fd, std::memory_order_relaxed);
+
+    struct sigaction action{};
+    action.sa_sigaction = onCrash;
+    action.sa_flags = SA_SIGINFO | SA_ONSTACK | SA_RESETHAND;
+    sigemptyset(&action.sa_mask);
+
+    for (const auto signal : signals)
+    {
+        if (sigaction(signal, &action, nullptr) == -1)
+        {
+            return std::unexpected(std::format("Failed to install the handler for signal {}: {}", signal, std::strerror(errno)));
+        }
+    }
+    return {};
+}
+
+std::expected<void, std::string> CrashHandler::installThreadStack()
+{
+    stack_t current{};
+    if (sigaltstack(nullptr, &current) == 0 && (current.ss_flags & SS_DISABLE) == 0 && current.ss_size >= alternateStackBytes)
+    {
+        return {};
+    }
+
+    // The stack is not freed when the thread exits; the signal state of a dead thread cannot be observed to release it.
+    void* memory = mmap(nullptr, alternateStackBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    if (memory == MAP_FAILED)
+    {
+        return std::unexpected(std::format("Failed to allocate the alternate signal stack: {}", std::strerror(errno)));
+    }
+
+    const stack_t stack{memory, 0, alternateStackBytes};
+    if (sigaltstack(&stack, nullptr) == -1)
+    {
+        const int error = errno;
+        munmap(memory, alternateStackBytes);
+        return std::unexpected(std::format("Failed to install the alternate signal stack: {}", std::strerror(error)));
+    }
+    return {};
+}
+
+std::expected<std::vector<CrashHandler::Report>, std::string> CrashHandler::parse(const std::span<const std::byte> data)
+{
+    std::vector<Report> reports;
+    size_t offset = 0;
+
+    while (offset < data.size())
+    {
+        if (data.size() - offset < sizeof(RecordHeader))
+        {
+            return std::unexpected(std::format("Truncated crash record header at offset {}", offset));
+        }
+
+        RecordHeader header;
+        std::memcpy(&header, data.data() + offset, sizeof(header));
+        if (header.magic != recordMagic || header.version != recordVersion)
+        {
+            return std::unexpected(std::format("No crash record of version {} at offset {}", recordVersion, offset));
+        }
+        offset += sizeof(header);
+
+        const size_t bodyBytes = header.registerCount * sizeof(uint64_t) + header.frameCount * sizeof(uintptr_t) + header.mapsBytes;
+        if (data.size() - offset < bodyBytes)
+        {
+            return std::unexpected(std::format("Truncated crash record of process {}", header.pid));
+        }
+
+        Report report;
+        report.signal = header.signal;
+        report.code = header.code;
+        report.pid = header.pid;
+        report.tid = header.tid;
+        report.faultAddress = static_cast<uintptr_t>(header.faultAddress);
+        report.timestamp = std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(header.timestampNs)));
+
+        report.registers.resize(header.registerCount);
+        std::memcpy(report.registers.data(), data.data() + offset, header.registerCount * sizeof(uint64_t));
+        offset += header.registerCount * sizeof(uint64_t);
+
+        report.addresses.resize(header.frameCount);
+        std::memcpy(report.addresses.data(), data.data() + offset, header.frameCount * sizeof(uintptr_t));
+        offset += header.frameCount * sizeof(uintptr_t);
+
+        report.modules = ModuleMap::parse(std::string_view(reinterpret_cast<const char*>(data.data() + offset), header.mapsBytes));
+        offset += header.mapsBytes;
+
+        reports.push_back(std::move(report));
+    }
+
+    return reports;
+}
+
+std::expected<std::vector<CrashHandler::Report>, std::string> CrashHandler::read(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return std::unexpected(std::format("Failed to open {}", path));
+    }
+
+    const std::string contents{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    return parse(std::as_bytes(std::span(contents)));
+}
+
+std::vector<StackFrame> CrashHandler::symbolize(const Report& report, ThreadPool* pool)
+{
+    return PlatformUtils::resolveProcessAddresses(report.modules, report.addresses, pool);
+}
+
+std::string_view CrashHandler::registerName(const size_t index) noexcept
+{
+    return index < registerNames.size() ? registerNames[index] : "?";
+}
@@ -0,0 +1,477 @@
+#include "DwarfLineTable.h"
+#include "DwarfReader.h"
+#include <elf.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+/// @brief Anonymous namespace
+namespace
+{
+    constexpr uint32_t invalidFile = std::numeric_limits<uint32_t>::max();
+
+    /// @brief DWARF 5 line header content type codes. \enum ContentType
+    enum ContentType : uint64_t
+    {
+        LnctPath = 0x1,
+        LnctDirectoryIndex = 0x2
+    };
+
+    /// @brief DWARF attribute form codes that may appear in line table headers. \enum Form
+    enum Form : uint64_t
+    {
+        FormBlock2 = 0x03,
+        FormBlock4 = 0x04,
+        FormData2 = 0x05,
+        FormData4 = 0x06,
+        FormData8 = 0x07,
+        FormString = 0x08,
+        FormBlock = 0x09,
+        FormBlock1 = 0x0a,
+        FormData1 = 0x0b,
+        FormStrp = 0x0e,
+        FormUdata = 0x0f,
+        FormData16 = 0x1e,
+        FormLineStrp = 0x1f
+    };
+
+    /// @brief EntryValue holds one decoded attribute of a directory or file entry. \struct EntryValue
+    struct EntryValue
+    {
+        std::string_view string;
+        uint64_t number{0};
+    };
+
+    /// @brief EntryFormat describes a single (content type, form) pair of a DWARF 5 entry format. \struct EntryFormat
+    struct EntryFormat
+    {
+        uint64_t type{0};
+        uint64_t form{0};
+    };
+
+    std::string_view stringAt(const std::span<const std::byte> section, const uint64_t offset) noexcept
+    {
+        if (offset >= section.size())
+        {
+            return {};
+        }
+
+        DwarfReader reader(section);
+        reader.seek(static_cast<size_t>(offset));
+        return reader.cstring();
+    }
+
+    bool readForm(
+        DwarfReader& reader,
+        const uint64_t form,
+        const size_t offsetSize,
+        const std::span<const std::byte> lineStr,
+        const std::span<const std::byte> str,
+        EntryValue& value) noexcept
+    {
+        switch (form)
+        {
+            case FormString:   value.string = reader.cstring(); break;
+            case FormLineStrp: value.string = stringAt(lineStr, reader.unsignedOfSize(offsetSize)); break;
+            case FormStrp:     value.string = stringAt(str, reader.unsignedOfSize(offsetSize)); break;
+            case FormUdata:    value.number = reader.uleb128(); break;
+            case FormData1:    value.number = reader.u8(); break;
+            case FormData2:    value.number = reader.u16(); break;
+            case FormData4:    value.number = reader.u32(); break;
+            case FormData8:    value.number = reader.u64(); break;
+            case FormData16:   reader.skip(16); break;
+            case FormBlock:    reader.skip(static_cast<size_t>(reader.uleb128())); break;
+            case FormBlock1:   reader.skip(reader.u8()); break;
+            case FormBlock2:   reader.skip(reader.u16()); break;
+            case FormBlock4:   reader.skip(reader.u32()); break;
+            default:           return false;
+        }
+        return reader.ok();
+    }
+
+    std::string joinPath(const std::string_view directory, const std::string_view name)
+    {
+        if (directory.empty() || name.starts_with('/'))
+        {
+            return std::string(name);
+        }
+
+        std::string path(directory);
+        if (!path.ends_with('/'))
+        {
+            path.push_back('/');
+        }
+        path.append(name);
+        return path;
+    }
+}
+
+DwarfLineTable DwarfLineTable::build(const ElfFile& elf)
+{
+    DwarfLineTable table;
+
+    const auto debugLine = elf.findSection(".debug_line");
+    if (!debugLine || debugLine->data.empty() || (debugLine->flags & SHF_COMPRESSED) != 0)
+    {
+        return table;
+    }
+
+    std::span<const std::byte> lineStr;
+    if (const auto section = elf.findSection(".debug_line_str"); section && (section->flags & SHF_COMPRESSED) == 0)
+    {
+        lineStr = section->data;
+    }
+
+    std::span<const std::byte> str;
+    if (const auto section = elf.findSection(".debug_str"); section && (section->flags & SHF_COMPRESSED) == 0)
+    {
+        str = section->data;
+    }
+
+    std::unordered_map<std::string, uint32_t> fileIds;
+    auto remaining = debugLine->data;
+
+    while (!remaining.empty())
+    {
+        const auto consumed = table.decodeUnit(remaining, lineStr, str, fileIds);
+        if (consumed == 0 || consumed > remaining.size())
+        {
+            break;
+        }
+        remaining = remaining.subspan(consumed);
+    }
+
+    auto& rows = table.m_ownedRows;
+    std::ranges::stable_sort(rows, [](const Row& lhs, const Row& rhs)
+    {
+        if (lhs.address != rhs.address)
+        {
+            return lhs.address < rhs.address;
+        }
+        return lhs.line == 0 && rhs.line != 0;
+    });
+
+    size_t out = 0;
+    for (size_t i = 0; i < rows.size(); ++i)
+    {
+        if (out > 0 && rows[out - 1].address == rows[i].address)
+        {
+            rows[out - 1] = rows[i];
+        }
+        else
+        {
+            rows[out++] = rows[i];
+        }
+    }
+    rows.resize(out);
+    rows.shrink_to_fit();
+
+    table.m_rows = rows;
+    table.m_fileOffsets = table.m_ownedFileOffsets;
+    table.m_fileNames = table.m_ownedFileNames;
+    return table;
+}
+
+DwarfLineTable DwarfLineTable::fromStorage(
+    const std::span<const Row> rows,
+    const std::span<const uint32_t> fileOffsets,
+    const std::span<const char> fileNames,
+    std::shared_ptr<const void> backing) noexcept
+{
+    DwarfLineTable table;
+    table.m_backing = std::move(backing);
+    table.m_rows = rows;
+    table.m_fileOffsets = fileOffsets;
+    table.m_fileNames = fileNames;
+    return table;
+}
+
+std::optional<DwarfLineTable::Location> DwarfLineTable::lookup(const uint64_t address) const noexcept
+{
+    const auto it = std::ranges::upper_bound(m_rows, address, {}, &Row::address);
+    if (it == m_rows.begin())
+    {
+        return std::nullopt;
+    }
+
+    const auto& row = *std::prev(it);
+    if (row.line == 0)
+    {
+        return std::nullopt;
+    }
+
+    Location location;
+    location.line = row.line;
+    if (row.fileIndex < m_fileOffsets.size() && m_fileOffsets[row.fileIndex] < m_fileNames.size())
+    {
+        const auto offset = m_fileOffsets[row.fileIndex];
+        const auto* name = m_fileNames.data() + offset;
+        location.file = std::string_view(name, strnlen(name, m_fileNames.size() - offset));
+    }
+    return location;
+}
+
+size_t DwarfLineTable::decodeUnit(
+    const std::span<const std::byte> unit,
+    const std::span<const std::byte> lineStr,
+    const std::span<const std::byte> str,
+    std::unordered_map<std::string, uint32_t>& fileIds)
+{
+    DwarfReader reader(unit);
+
+    size_t offsetSize = 4;
+    const auto length = reader.initialLength(offsetSize);
+    if (!reader.ok() || length > reader.remaining())
+    {
+        return 0;
+    }
+
+    const auto unitEnd = reader.offset() + static_cast<size_t>(length);
+    reader = DwarfReader(unit.first(unitEnd));
+    reader.seek(unitEnd - static_cast<size_t>(length));
+
+    const auto version = reader.u16();
+    if (version < 2 || version > 5)
+    {
+        return unitEnd;
+    }
+
+    size_t addressSize = sizeof(uintptr_t);
+    if (version >= 5)
+    {
+        addressSize = reader.u8();
+        reader.skip(1);
+    }
+
+    const auto headerLength = reader.unsignedOfSize(offsetSize);
+    const auto programStart = reader.offset() + static_cast<size_t>(headerLength);
+
+    const auto minInstLength = reader.u8();
+    if (version >= 4)
+    {
+        reader.skip(1);
+    }
+    reader.skip(1);
+    const auto lineBase = static_cast<int8_t>(reader.u8());
+    const auto lineRange = reader.u8();
+    const auto opcodeBase = reader.u8();
+
+    if (!reader.ok() || lineRange == 0 || opcodeBase == 0)
+    {
+        return unitEnd;
+    }
+
+    std::array<uint8_t, 256> standardLengths{};
+    for (size_t i = 1; i < opcodeBase; ++i)
+    {
+        standardLengths[i] = reader.u8();
+    }
+
+    auto intern = [&](std::string path)
+    {
+        const auto [it, inserted] = fileIds.try_emplace(std::move(path), static_cast<uint32_t>(m_ownedFileOffsets.size()));
+        if (inserted)
+        {
+            m_ownedFileOffsets.push_back(static_cast<uint32_t>(m_ownedFileNames.size()));
+            m_ownedFileNames.insert(m_ownedFileNames.end(), it->first.begin(), it->first.end());
+            m_ownedFileNames.push_back('\0');
+        }
+        return it->second;
+    };
+
+    std::vector<std::string_view> directories;
+    std::vector<uint32_t> files;
+
+    if (version < 5)
+    {
+        directories.emplace_back();
+        for (auto dir = reader.cstring(); reader.ok() && !dir.empty(); dir = reader.cstring())
+        {
+            directories.push_back(dir);
+        }
+
+        files.push_back(invalidFile);
+        for (auto name = reader.cstring(); reader.ok() && !name.empty(); name = reader.cstring())
+        {
+            const auto dirIndex = reader.uleb128();
+            reader.skipLeb128();
+            reader.skipLeb128();
+            const auto dir = dirIndex < directories.size() ? directories[dirIndex] : std::string_view{};
+            files.push_back(intern(joinPath(dir, name)));
+        }
+    }
+    else
+    {
+        auto readEntries = [&](auto&& onEntry)
+        {
+            const auto formatCount = reader.u8();
+            std::vector<EntryFormat> formats(formatCount);
+            for (auto& format : formats)
+            {
+                format.type = reader.uleb128();
+                format.form = reader.uleb128();
+            }
+
+            const auto count = reader.uleb128();
+            for (uint64_t i = 0; i < count && reader.ok(); ++i)
+            {
+                std::string_view path;
+                uint64_t dirIndex = 0;
+                for (const auto& format : formats)
+                {
+                    EntryValue value;
+                    if (!readForm(reader, format.form, offsetSize, lineStr, str, value))
+                    {
+                        return false;
+                    }
+                    if (format.type == LnctPath)
+                    {
+                        path = value.string;
+                    }
+                    else if (format.type == LnctDirectoryIndex)
+                    {
+                        dirIndex = value.number;
+                    }
+                }
+                onEntry(path, dirIndex);
+            }
+            return reader.ok();
+        };
+
+        const bool dirsOk = readEntries([&](const std::string_view path, uint64_t)
+        {
+            directories.push_back(path);
+        });
+
+        const bool filesOk = dirsOk && readEntries([&](const std::string_view path, const uint64_t dirIndex)
+        {
+            const auto dir = dirIndex < directories.size() ? directories[dirIndex] : std::string_view{};
+            files.push_back(intern(joinPath(dir, path)));
+        });
+
+        if (!filesOk)
+        {
+            return unitEnd;
+        }
+    }
+
+    reader.seek(programStart);
+
+    uint64_t address = 0;
+    uint64_t file = 1;
+    int64_t line = 1;
+    size_t sequenceStart = m_ownedRows.size();
+    bool sequenceStarted = false;
+    uint64_t sequenceAddress = 0;
+
+    auto fileIndex = [&](const uint64_t index)
+    {
+        return index < files.size() ? files[index] : invalidFile;
+    };
+
+    auto emitRow = [&]()
+    {
+        if (!sequenceStarted)
+        {
+            sequenceStarted = true;
+            sequenceAddress = address;
+        }
+        m_ownedRows.push_back(Row{address, fileIndex(file), static_cast<uint32_t>(std::max<int64_t>(line, 0))});
+    };
+
+    while (reader.ok() && !reader.atEnd())
+    {
+        const auto opcode = reader.u8();
+
+        if (opcode >= opcodeBase)
+        {
+            const auto adjusted = static_cast<uint8_t>(opcode - opcodeBase);
+            address += static_cast<uint64_t>(minInstLength) * (adjusted / lineRange);
+            line += lineBase + (adjusted % lineRange);
+            emitRow();
+            continue;
+        }
+
+        switch (opcode)
+        {
+            case 0:
+            {
+                const auto extLength = static_cast<size_t>(reader.uleb128());
+                const auto extEnd = reader.offset() + extLength;
+                if (extLength == 0)
+                {
+                    break;
+                }
+
+                const auto subOpcode = reader.u8();
+                if (subOpcode == 1)
+                {
+                    emitRow();
+                    m_ownedRows.back().line = 0;
+
+                    if (sequenceAddress == 0 || sequenceAddress == std::numeric_limits<uint64_t>::max())
+                    {
+                        m_ownedRows.resize(sequenceStart);
+                    }
+
+                    address = 0;
+                    file = 1;
+                    line = 1;
+                    sequenceStart = m_ownedRows.size();
+                    sequenceStarted = false;
+                }
+                else if (subOpcode == 2)
+                {
+                    address = reader.unsignedOfSize(std::min(extLength - 1, addressSize));
+                }
+                else if (subOpcode == 3 && version < 5)
+                {
+                    const auto name = reader.cstring();
+                    const auto dirIndex = reader.uleb128();
+                    const auto dir = dirIndex < directories.size() ? directories[dirIndex] : std::string_view{};
+                    files.push_back(intern(joinPath(dir, name)));
+                }
+                reader.seek(extEnd);
+                break;
+            }
+            case 1:
+                emitRow();
+                break;
+            case 2:
+                address += reader.uleb128() * minInstLength;
+                break;
+            case 3:
+                line += reader.sleb128();
+                break;
+            case 4:
+                file = reader.uleb128();
+                break;
+            case 8:
+                address += static_cast<uint64_t>(minInstLength) * ((255 - opcodeBase) / lineRange);
+                break;
+            case 9:
+                address += reader.u16();
+                break;
+            case 6:
+            case 7:
+            case 10:
+            case 11:
+                break;
+            default:
+                for (size_t i = 0; i < standardLengths[opcode]; ++i)
+                {
+                    reader.skipLeb128();
+                }
+                break;
+        }
+    }
+
+    if (sequenceStarted)
+    {
+        m_ownedRows.resize(sequenceStart);
+    }
+
+    return unitEnd;
+}
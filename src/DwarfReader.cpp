@@ -0,0 +1,177 @@
+#include "DwarfReader.h"
+#include <cstring>
+
+DwarfReader::DwarfReader(const std::span<const std::byte> data) noexcept
+    : m_data(data)
+{
+
+}
+
+void DwarfReader::seek(const size_t offset) noexcept
+{
+    if (offset > m_data.size())
+    {
+        m_failed = true;
+        m_offset = m_data.size();
+        return;
+    }
+    m_offset = offset;
+}
+
+void DwarfReader::skip(const size_t count) noexcept
+{
+    if (count > remaining())
+    {
+        m_failed = true;
+        m_offset = m_data.size();
+        return;
+    }
+    m_offset += count;
+}
+
+uint8_t DwarfReader::u8() noexcept
+{
+    return static_cast<uint8_t>(unsignedOfSize(1));
+}
+
+uint16_t DwarfReader::u16() noexcept
+{
+    return static_cast<uint16_t>(unsignedOfSize(2));
+}
+
+uint32_t DwarfReader::u32() noexcept
+{
+    return static_cast<uint32_t>(unsignedOfSize(4));
+}
+
+uint64_t DwarfReader::u64() noexcept
+{
+    return unsignedOfSize(8);
+}
+
+uint64_t DwarfReader::uleb128() noexcept
+{
+    uint64_t result = 0;
+    unsigned shift = 0;
+
+    while (m_offset < m_data.size())
+    {
+        const auto byte = static_cast<uint8_t>(m_data[m_offset++]);
+        if (shift < 64)
+        {
+            result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        }
+        shift += 7;
+
+        if ((byte & 0x80) == 0)
+        {
+            return result;
+        }
+    }
+
+    m_failed = true;
+    return result;
+}
+
+void DwarfReader::skipLeb128() noexcept
+{
+    while (m_offset < m_data.size())
+    {
+        if ((static_cast<uint8_t>(m_data[m_offset++]) & 0x80) == 0)
+        {
+            return;
+        }
+    }
+    m_failed = true;
+}
+
+int64_t DwarfReader::sleb128() noexcept
+{
+    int64_t result = 0;
+    unsigned shift = 0;
+
+    while (m_offset < m_data.size())
+    {
+        const auto byte = static_cast<uint8_t>(m_data[m_offset++]);
+        if (shift < 64)
+        {
+            result |= static_cast<int64_t>(static_cast<uint64_t>(byte & 0x7f) << shift);
+        }
+        shift += 7;
+
+        if ((byte & 0x80) == 0)
+        {
+            if (shift < 64 && (byte & 0x40) != 0)
+            {
+                result |= static_cast<int64_t>(~uint64_t{0} << shift);
+            }
+            return result;
+        }
+    }
+
+    m_failed = true;
+    return result;
+}
+
+uint64_t DwarfReader::unsignedOfSize(const size_t size) noexcept
+{
+    if (size > remaining() || size > sizeof(uint64_t))
+    {
+        m_failed = true;
+        m_offset = m_data.size();
+        return 0;
+    }
+
+    uint64_t result = 0;
+    for (size_t i = 0; i < size; ++i)
+    {
+        result |= static_cast<uint64_t>(static_cast<uint8_t>(m_data[m_offset + i])) << (8 * i);
+    }
+
+    m_offset += size;
+    return result;
+}
+
+std::string_view DwarfReader::cstring() noexcept
+{
+    const auto* begin = reinterpret_cast<const char*>(m_data.data() + m_offset);
+    const auto maxLen = remaining();
+    const auto len = strnlen(begin, maxLen);
+
+    if (len == maxLen)
+    {
+        m_failed = true;
+        m_offset = m_data.size();
+        return {};
+    }
+
+    m_offset += len + 1;
+    return {begin, len};
+}
+
+uint64_t DwarfReader::initialLength(size_t& offsetSize) noexcept
+{
+    const uint64_t length = u32();
+    if (length == 0xffffffff)
+    {
+        offsetSize = 8;
+        return u64();
+    }
+
+    offsetSize = 4;
+    return length;
+}
+
+std::span<const std::byte> DwarfReader::bytes(const size_t count) noexcept
+{
+    if (count > remaining())
+    {
+        m_failed = true;
+        m_offset = m_data.size();
+        return {};
+    }
+
+    const auto result = m_data.subspan(m_offset, count);
+    m_offset += count;
+    return result;
+}
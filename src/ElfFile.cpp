@@ -0,0 +1,239 @@
+#include "ElfFile.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <elf.h>
+#include <cstring>
+#include <format>
+#include <utility>
+
+std::expected<ElfFile, std::string> ElfFile::open(const std::string_view path) noexcept
+{
+    const int fd = ::open(std::string(path).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        return std::unexpected(std::format("Failed to open {}", path));
+    }
+
+    struct stat st{};
+    if (fstat(fd, &st) == -1 || static_cast<size_t>(st.st_size) < sizeof(ElfW(Ehdr)))
+    {
+        close(fd);
+        return std::unexpected(std::format("{} is too small to be an ELF file", path));
+    }
+
+    const auto size = static_cast<size_t>(st.st_size);
+    void* base = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (base == MAP_FAILED)
+    {
+        return std::unexpected(std::format("Failed to map {}", path));
+    }
+
+    ElfFile file(static_cast<const std::byte*>(base), size);
+    const auto& ehdr = file.header();
+
+    if (std::memcmp(ehdr.e_ident, ELFMAG, SELFMAG) != 0)
+    {
+        return std::unexpected(std::format("{} is not an ELF file", path));
+    }
+
+#if __WORDSIZE == 64
+    constexpr unsigned char nativeClass = ELFCLASS64;
+#else
+    constexpr unsigned char nativeClass = ELFCLASS32;
+#endif
+
+    if (ehdr.e_ident[EI_CLASS] != nativeClass)
+    {
+        return std::unexpected(std::format("{} has a foreign ELF class", path));
+    }
+
+    if (ehdr.e_shoff > size || ehdr.e_shentsize != sizeof(ElfW(Shdr))
+        || ehdr.e_shnum > (size - ehdr.e_shoff) / sizeof(ElfW(Shdr)))
+    {
+        return std::unexpected(std::format("{} has a malformed section header table", path));
+    }
+
+    return file;
+}
+
+ElfFile::ElfFile(const std::byte* base, const size_t size) noexcept
+    : m_base(base)
+    , m_size(size)
+{
+
+}
+
+ElfFile::ElfFile(ElfFile&& other) noexcept
+    : m_base(std::exchange(other.m_base, nullptr))
+    , m_size(std::exchange(other.m_size, 0))
+{
+
+}
+
+ElfFile& ElfFile::operator=(ElfFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        if (m_base != nullptr)
+        {
+            munmap(const_cast<std::byte*>(m_base), m_size);
+        }
+        m_base = std::exchange(other.m_base, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+    }
+    return *this;
+}
+
+ElfFile::~ElfFile()
+{
+    if (m_base != nullptr)
+    {
+        munmap(const_cast<std::byte*>(m_base), m_size);
+    }
+}
+
+uint16_t ElfFile::type() const noexcept
+{
+    return header().e_type;
+}
+
+std::optional<std::string> ElfFile::buildId() const
+{
+    for (size_t i = 0; i < sectionCount(); ++i)
+    {
+        const auto section = sectionAt(i);
+        if (!section || section->type != SHT_NOTE)
+        {
+            continue;
+        }
+
+        size_t offset = 0;
+        const auto& data = section->data;
+        while (offset + sizeof(ElfW(Nhdr)) <= data.size())
+        {
+            const auto* note = reinterpret_cast<const ElfW(Nhdr)*>(data.data() + offset);
+            const size_t nameSize = (note->n_namesz + 3u) & ~size_t{3};
+            const size_t descSize = (note->n_descsz + 3u) & ~size_t{3};
+            const size_t nameOffset = offset + sizeof(ElfW(Nhdr));
+            const size_t descOffset = nameOffset + nameSize;
+
+            if (descOffset + note->n_descsz > data.size())
+            {
+                break;
+            }
+
+            const std::string_view name(reinterpret_cast<const char*>(data.data() + nameOffset), note->n_namesz);
+            if (note->n_type == NT_GNU_BUILD_ID && name == std::string_view("GNU\0", 4))
+            {
+                std::string hex;
+                hex.reserve(note->n_descsz * 2);
+                for (size_t j = 0; j < note->n_descsz; ++j)
+                {
+                    hex += std::format("{:02x}", static_cast<unsigned>(data[descOffset + j]));
+                }
+                return hex;
+            }
+
+            offset = descOffset + descSize;
+        }
+    }
+
+    return std::nullopt;
+}
+
+std::span<const std::byte> ElfFile::bytes() const noexcept
+{
+    return {m_base, m_size};
+}
+
+std::span<const ElfW(Phdr)> ElfFile::programHeaders() const noexcept
+{
+    const auto& ehdr = header();
+    if (ehdr.e_phoff == 0 || ehdr.e_phoff > m_size || ehdr.e_phentsize != sizeof(ElfW(Phdr))
+        || ehdr.e_phnum > (m_size - ehdr.e_phoff) / sizeof(ElfW(Phdr)))
+    {
+        return {};
+    }
+
+    const auto* phdrs = reinterpret_cast<const ElfW(Phdr)*>(m_base + ehdr.e_phoff);
+    return {phdrs, ehdr.e_phnum};
+}
+
+size_t ElfFile::sectionCount() const noexcept
+{
+    return header().e_shnum;
+}
+
+std::optional<ElfFile::Section> ElfFile::sectionAt(const size_t index) const noexcept
+{
+    const auto& ehdr = header();
+    if (index >= ehdr.e_shnum)
+    {
+        return std::nullopt;
+    }
+
+    const auto* shdrs = reinterpret_cast<const ElfW(Shdr)*>(m_base + ehdr.e_shoff);
+    const auto& shdr = shdrs[index];
+
+    Section section;
+    section.name = sectionName(shdr.sh_name);
+    section.type = shdr.sh_type;
+    section.flags = shdr.sh_flags;
+    section.address = shdr.sh_addr;
+    section.offset = shdr.sh_offset;
+    section.link = shdr.sh_link;
+    section.entrySize = shdr.sh_entsize;
+
+    if (shdr.sh_type != SHT_NOBITS)
+    {
+        if (shdr.sh_offset > m_size || shdr.sh_size > m_size - shdr.sh_offset)
+        {
+            return std::nullopt;
+        }
+        section.data = {m_base + shdr.sh_offset, static_cast<size_t>(shdr.sh_size)};
+    }
+
+    return section;
+}
+
+std::optional<ElfFile::Section> ElfFile::findSection(const std::string_view name) const noexcept
+{
+    for (size_t i = 0; i < sectionCount(); ++i)
+    {
+        auto section = sectionAt(i);
+        if (section && section->name == name)
+        {
+            return section;
+        }
+    }
+    return std::nullopt;
+}
+
+const ElfW(Ehdr)& ElfFile::header() const noexcept
+{
+    return *reinterpret_cast<const ElfW(Ehdr)*>(m_base);
+}
+
+std::string_view ElfFile::sectionName(const uint32_t nameOffset) const noexcept
+{
+    const auto& ehdr = header();
+    if (ehdr.e_shstrndx == SHN_UNDEF || ehdr.e_shstrndx >= ehdr.e_shnum)
+    {
+        return {};
+    }
+
+    const auto* shdrs = reinterpret_cast<const ElfW(Shdr)*>(m_base + ehdr.e_shoff);
+    const auto& strtab = shdrs[ehdr.e_shstrndx];
+    if (strtab.sh_offset > m_size || strtab.sh_size > m_size - strtab.sh_offset || nameOffset >= strtab.sh_size)
+    {
+        return {};
+    }
+
+    const auto* begin = reinterpret_cast<const char*>(m_base + strtab.sh_offset);
+    const auto maxLen = static_cast<size_t>(strtab.sh_size - nameOffset);
+    return {begin + nameOffset, strnlen(begin + nameOffset, maxLen)};
+}
@@ -0,0 +1,118 @@
+#include "ElfSymbolTable.h"
+#include <elf.h>
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+ElfSymbolTable ElfSymbolTable::build(const ElfFile& elf)
+{
+    ElfSymbolTable table;
+
+    for (const auto name : {".symtab", ".dynsym"})
+    {
+        if (const auto section = elf.findSection(name))
+        {
+            table.addSymbols(elf, *section);
+        }
+    }
+
+    auto& entries = table.m_ownedEntries;
+    std::ranges::stable_sort(entries, [](const Entry& lhs, const Entry& rhs)
+    {
+        if (lhs.start != rhs.start)
+        {
+            return lhs.start < rhs.start;
+        }
+        return lhs.size > rhs.size;
+    });
+
+    const auto [first, last] = std::ranges::unique(entries, {}, &Entry::start);
+    entries.erase(first, last);
+
+    for (size_t i = 0; i + 1 < entries.size(); ++i)
+    {
+        if (entries[i].size == 0)
+        {
+            entries[i].size = entries[i + 1].start - entries[i].start;
+        }
+    }
+
+    entries.shrink_to_fit();
+    table.m_entries = entries;
+    table.m_names = table.m_ownedNames;
+    return table;
+}
+
+ElfSymbolTable ElfSymbolTable::fromStorage(
+    const std::span<const Entry> entries,
+    const std::span<const char> names,
+    std::shared_ptr<const void> backing) noexcept
+{
+    ElfSymbolTable table;
+    table.m_backing = std::move(backing);
+    table.m_entries = entries;
+    table.m_names = names;
+    return table;
+}
+
+std::optional<ElfSymbolTable::Symbol> ElfSymbolTable::lookup(const uint64_t address) const noexcept
+{
+    const auto it = std::ranges::upper_bound(m_entries, address, {}, &Entry::start);
+    if (it == m_entries.begin())
+    {
+        return std::nullopt;
+    }
+
+    const auto& entry = *std::prev(it);
+    if (address - entry.start >= entry.size || entry.nameOffset >= m_names.size())
+    {
+        return std::nullopt;
+    }
+
+    const auto* name = m_names.data() + entry.nameOffset;
+    return Symbol{
+        std::string_view(name, strnlen(name, m_names.size() - entry.nameOffset)),
+        entry.start,
+        entry.size
+    };
+}
+
+void ElfSymbolTable::addSymbols(const ElfFile& elf, const ElfFile::Section& symtab)
+{
+    if (symtab.type != SHT_SYMTAB && symtab.type != SHT_DYNSYM)
+    {
+        return;
+    }
+
+    const auto strtab = elf.sectionAt(symtab.link);
+    if (!strtab || strtab->data.empty())
+    {
+        return;
+    }
+
+    const auto* strings = reinterpret_cast<const char*>(strtab->data.data());
+    const auto stringsSize = strtab->data.size();
+    const auto* symbols = reinterpret_cast<const ElfW(Sym)*>(symtab.data.data());
+    const auto count = symtab.data.size() / sizeof(ElfW(Sym));
+
+    m_ownedEntries.reserve(m_ownedEntries.size() + count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto& sym = symbols[i];
+        const auto type = ELF64_ST_TYPE(sym.st_info);
+
+        if ((type != STT_FUNC && type != STT_GNU_IFUNC) || sym.st_shndx == SHN_UNDEF
+            || sym.st_value == 0 || sym.st_name == 0 || sym.st_name >= stringsSize)
+        {
+            continue;
+        }
+
+        const auto nameLen = strnlen(strings + sym.st_name, stringsSize - sym.st_name);
+        const auto offset = static_cast<uint32_t>(m_ownedNames.size());
+        m_ownedNames.insert(m_ownedNames.end(), strings + sym.st_name, strings + sym.st_name + nameLen);
+        m_ownedNames.push_back('\0');
+
+        m_ownedEntries.push_back(Entry{sym.st_value, sym.st_size, offset, 0});
+    }
+}
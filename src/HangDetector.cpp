@@ -0,0 +1,290 @@
+#include "HangDetector.h"
+#include "ModuleMap.h"
+#include "PlatformUtils.h"
+#include "StackProfile.h"
+#include "Unwinder.h"
+#include <algorithm>
+#include <array>
+#include <thread>
+#include <unordered_map>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+/// @brief Anonymous namespace
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    /// @brief Track is what the samples saw of one thread. \struct Track
+    struct Track
+    {
+        size_t hash{0};
+        std::vector<uintptr_t> addresses;
+        size_t seen{0};
+        bool moved{false};
+        std::optional<StackSnapshot::Syscall> syscall;
+    };
+
+    /// @brief MutexHead is the start of a glibc pthread_mutex_t: the futex word, the recursion count and the owner TID. \struct MutexHead
+    struct MutexHead
+    {
+        int32_t lock{0};
+        uint32_t count{0};
+        int32_t owner{0};
+    };
+
+    /// @brief The value of a glibc lock word that is held and has waiters.
+    constexpr uint64_t contendedLock = 2;
+
+    bool isPriorityInheritanceLock(const int op) noexcept
+    {
+#ifdef FUTEX_LOCK_PI2
+        return op == FUTEX_LOCK_PI || op == FUTEX_LOCK_PI2;
+#else
+        return op == FUTEX_LOCK_PI;
+#endif
+    }
+
+    std::optional<int> futexWaitOp(const StackSnapshot::Syscall& syscall) noexcept
+    {
+        if (syscall.number != SYS_futex)
+        {
+            return std::nullopt;
+        }
+
+        const auto op = static_cast<int>(syscall.args[1]) & FUTEX_CMD_MASK;
+        if (op == FUTEX_WAIT || op == FUTEX_WAIT_BITSET || op == FUTEX_WAIT_REQUEUE_PI || isPriorityInheritanceLock(op))
+        {
+            return op;
+        }
+        return std::nullopt;
+    }
+
+    pid_t futexOwner(const pid_t pid, const StackSnapshot::Syscall& syscall, const int op) noexcept
+    {
+        const auto address = static_cast<uintptr_t>(syscall.args[0]);
+
+        // A PI futex holds the owner TID itself.
+        if (isPriorityInheritanceLock(op))
+        {
+            uint32_t word = 0;
+            if (PlatformUtils::readMemory(pid, address, std::as_writable_bytes(std::span(&word, 1))) != sizeof(word))
+            {
+                return 0;
+            }
+            return static_cast<pid_t>(word & FUTEX_TID_MASK);
+        }
+
+        // glibc only blocks on a contended mutex with FUTEX_WAIT and the expected value 2; condition variables,
+        // joins and semaphores wait on words that carry no owner, so they are never read as a mutex.
+        if (op != FUTEX_WAIT || syscall.args[2] != contendedLock)
+        {
+            return 0;
+        }
+
+        MutexHead head;
+        if (PlatformUtils::readMemory(pid, address, std::as_writable_bytes(std::span(&head, 1))) != sizeof(head) || head.lock == 0)
+        {
+            return 0;
+        }
+        return head.owner;
+    }
+
+    std::vector<std::vector<pid_t>> findCycles(const std::unordered_map<pid_t, pid_t>& waitsFor)
+    {
+        std::vector<pid_t> starts;
+        starts.reserve(waitsFor.size());
+        for (const auto& [waiter, owner] : waitsFor)
+        {
+            starts.push_back(waiter);
+        }
+        std::ranges::sort(starts);
+
+        // Every thread waits for at most one other, so following the edges from each start finds every cycle once.
+        enum class Mark : uint8_t { OnPath, Done };
+        std::unordered_map<pid_t, Mark> marks;
+        std::vector<std::vector<pid_t>> cycles;
+
+        for (const auto start : starts)
+        {
+            std::vector<pid_t> path;
+            auto tid = start;
+            while (!marks.contains(tid))
+            {
+                const auto next = waitsFor.find(tid);
+                if (next == waitsFor.end())
+                {
+                    break;
+                }
+                marks.emplace(tid, Mark::OnPath);
+                path.push_back(tid);
+                tid = next->second;
+            }
+
+            if (const auto mark = marks.find(tid); mark != marks.end() && mark->second == Mark::OnPath)
+            {
+                std::vector<pid_t> cycle(std::ranges::find(path, tid), path.end());
+                std::ranges::rotate(cycle, std::ranges::min_element(cycle));
+                cycles.push_back(std::move(cycle));
+            }
+
+            for (const auto visited : path)
+            {
+                marks[visited] = Mark::Done;
+            }
+        }
+        return cycles;
+    }
+}
+
+std::expected<HangDetector::Report, HangDetector::Error> HangDetector::detect(
+    const pid_t pid,
+    const TraceSession::Options& options,
+    const std::chrono::nanoseconds window,
+    size_t samples,
+    ThreadPool* pool)
+{
+    auto modules = ModuleMap::read(pid);
+    if (!modules)
+    {
+        return std::unexpected(PlatformUtils::isProcessRunning(pid) ? Error::CaptureFailed : Error::ProcessNotRunning);
+    }
+
+    samples = std::max<size_t>(samples, 2);
+    Report report;
+    report.window = window;
+    report.samples = samples;
+
+    std::unordered_map<pid_t, Track> tracks;
+    std::vector<StackSnapshot> snapshots;
+    std::vector<uintptr_t> buffer(PlatformUtils::defaultMaxFrames);
+    const auto start = Clock::now();
+
+    for (size_t sample = 0; sample < samples; ++sample)
+    {
+        std::this_thread::sleep_until(start + std::chrono::duration_cast<Clock::duration>(window * sample / (samples - 1)));
+
+        const auto stopStart = Clock::now();
+        const auto stopped = PlatformUtils::stopAllThreads(pid);
+        if (stopped.empty())
+        {
+            return std::unexpected(PlatformUtils::isProcessRunning(pid) ? Error::AttachFailed : Error::ProcessNotRunning);
+        }
+
+        if (snapshots.size() < stopped.size())
+        {
+            snapshots.resize(stopped.size());
+        }
+
+        std::vector<uint8_t> captured(stopped.size());
+        PlatformUtils::captureStackSnapshots(stopped, options.stackBytes, &*modules, std::span(snapshots).first(stopped.size()), captured, pool);
+        PlatformUtils::releaseThreads(stopped);
+        report.maxStop = std::max(report.maxStop, std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - stopStart));
+
+        // Only raw stacks are compared while sampling; nothing is symbolized until the window is over.
+        for (size_t i = 0; i < stopped.size(); ++i)
+        {
+            if (!captured[i])
+            {
+                continue;
+            }
+
+            const auto count = Unwinder::unwind(snapshots[i], *modules, Unwinder::fromSession(options.unwindMethod), buffer);
+            const auto stack = std::span<const uintptr_t>(buffer).first(count);
+            const auto hash = StackProfile::AddressHash{}(stack);
+
+            auto& track = tracks[snapshots[i].tid];
+            if (track.seen == 0)
+            {
+                track.hash = hash;
+                track.addresses.assign(stack.begin(), stack.end());
+            }
+            else if (track.hash != hash || !std::ranges::equal(track.addresses, stack))
+            {
+                track.moved = true;
+            }
+            ++track.seen;
+            track.syscall = snapshots[i].syscall();
+        }
+    }
+    report.threadCount = tracks.size();
+
+    std::unordered_map<pid_t, pid_t> waitsFor;
+    std::unordered_map<uintptr_t, std::vector<pid_t>> waiters;
+
+    for (auto& [tid, track] : tracks)
+    {
+        // Threads that appeared or vanished during the window were not seen standing still.
+        if (track.moved || track.seen != samples)
+        {
+            continue;
+        }
+
+        StuckThread thread;
+        thread.tid = tid;
+        thread.name = PlatformUtils::getThreadName(pid, tid).value_or("");
+        thread.syscall = track.syscall ? track.syscall : PlatformUtils::readThreadSyscall(pid, tid);
+        thread.frames = PlatformUtils::resolveProcessAddresses(*modules, track.addresses, pool);
+
+        if (const auto op = thread.syscall ? futexWaitOp(*thread.syscall) : std::nullopt)
+        {
+            thread.futexAddress = static_cast<uintptr_t>(thread.syscall->args[0]);
+
+            // The owner word is only trusted if it names a thread of this process. Waits without a checkable
+            // owner, such as an idle pool parked on a condition variable, are shown but form no convoy.
+            const auto owner = futexOwner(pid, *thread.syscall, *op);
+            if (owner != tid && tracks.contains(owner))
+            {
+                thread.owner = owner;
+                waitsFor.emplace(tid, owner);
+                waiters[thread.futexAddress].push_back(tid);
+            }
+        }
+        report.stuck.push_back(std::move(thread));
+    }
+    std::ranges::sort(report.stuck, {}, &StuckThread::tid);
+
+    for (auto& [address, tids] : waiters)
+    {
+        if (tids.size() < 2)
+        {
+            continue;
+        }
+
+        std::ranges::sort(tids);
+        report.convoys.push_back(Convoy{address, waitsFor.at(tids.front()), std::move(tids)});
+    }
+    std::ranges::sort(report.convoys, [](const Convoy& a, const Convoy& b) { return a.waiters.size() > b.waiters.size(); });
+
+    report.cycles = findCycles(waitsFor);
+    return report;
+}
+
+std::string_view HangDetector::syscallName(const int64_t number) noexcept
+{
+    switch (number)
+    {
+        case SYS_read:            return "read";
+        case SYS_write:           return "write";
+        case SYS_futex:           return "futex";
+        case SYS_nanosleep:       return "nanosleep";
+        case SYS_clock_nanosleep: return "clock_nanosleep";
+        case SYS_ppoll:           return "ppoll";
+        case SYS_pselect6:        return "pselect6";
+        case SYS_epoll_pwait:     return "epoll_pwait";
+        case SYS_accept4:         return "accept4";
+        case SYS_recvfrom:        return "recvfrom";
+        case SYS_recvmsg:         return "recvmsg";
+        case SYS_wait4:           return "wait4";
+        case SYS_waitid:          return "waitid";
+        case SYS_restart_syscall: return "restart_syscall";
+#ifdef SYS_poll
+        case SYS_poll:            return "poll";
+        case SYS_select:          return "select";
+        case SYS_epoll_wait:      return "epoll_wait";
+        case SYS_accept:          return "accept";
+        case SYS_pause:           return "pause";
+#endif
+        default:                  return {};
+    }
+}
@@ -0,0 +1,142 @@
+#include "ModuleMap.h"
+#include <algorithm>
+#include <charconv>
+#include <format>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+/// @brief Anonymous namespace
+namespace
+{
+    template <typename T>
+    bool parseHex(std::string_view& text, T& value) noexcept
+    {
+        const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value, 16);
+        if (ec != std::errc())
+        {
+            return false;
+        }
+        text.remove_prefix(static_cast<size_t>(ptr - text.data()));
+        return true;
+    }
+
+    std::string_view nextField(std::string_view& text) noexcept
+    {
+        const auto begin = text.find_first_not_of(' ');
+        if (begin == std::string_view::npos)
+        {
+            text = {};
+            return {};
+        }
+        text.remove_prefix(begin);
+
+        const auto end = std::min(text.find(' '), text.size());
+        const auto field = text.substr(0, end);
+        text.remove_prefix(end);
+        return field;
+    }
+}
+
+std::expected<ModuleMap, std::string> ModuleMap::read(const pid_t pid) noexcept
+{
+    const auto path = std::format("/proc/{}/maps", pid);
+    std::ifstream mapsFile(path);
+
+    if (!mapsFile)
+    {
+        return std::unexpected(std::format("Failed to open {}", path));
+    }
+
+    std::stringstream contents;
+    contents << mapsFile.rdbuf();
+    return parse(contents.str());
+}
+
+ModuleMap ModuleMap::parse(const std::string_view text)
+{
+    ModuleMap map;
+    std::unordered_map<std::string_view, uint32_t> moduleIds;
+
+    size_t pos = 0;
+    while (pos < text.size())
+    {
+        const auto eol = std::min(text.find('\n', pos), text.size());
+        auto line = text.substr(pos, eol - pos);
+        pos = eol + 1;
+
+        Mapping mapping;
+        if (!parseHex(line, mapping.start) || !line.starts_with('-'))
+        {
+            continue;
+        }
+        line.remove_prefix(1);
+        if (!parseHex(line, mapping.end))
+        {
+            continue;
+        }
+
+        const auto perms = nextField(line);
+        if (perms.size() < 3)
+        {
+            continue;
+        }
+        mapping.readable = perms[0] == 'r';
+        mapping.writable = perms[1] == 'w';
+        mapping.executable = perms[2] == 'x';
+
+        auto offsetField = nextField(line);
+        if (!parseHex(offsetField, mapping.offset))
+        {
+            continue;
+        }
+
+        nextField(line);
+        nextField(line);
+
+        const auto nameBegin = line.find_first_not_of(' ');
+        if (nameBegin != std::string_view::npos)
+        {
+            mapping.name = std::string(line.substr(nameBegin));
+        }
+
+        map.m_mappings.push_back(std::move(mapping));
+    }
+
+    std::ranges::sort(map.m_mappings, {}, &Mapping::start);
+
+    for (auto& mapping : map.m_mappings)
+    {
+        if (!mapping.name.starts_with('/'))
+        {
+            continue;
+        }
+
+        const auto [it, inserted] = moduleIds.try_emplace(mapping.name, static_cast<uint32_t>(map.m_modules.size()));
+        if (inserted)
+        {
+            map.m_modules.push_back(mapping.name);
+        }
+        mapping.moduleId = it->second;
+    }
+
+    return map;
+}
+
+const ModuleMap::Mapping* ModuleMap::find(const uintptr_t address) const noexcept
+{
+    const auto it = std::ranges::upper_bound(m_mappings, address, {}, &Mapping::start);
+    if (it == m_mappings.begin())
+    {
+        return nullptr;
+    }
+
+    const auto& mapping = *std::prev(it);
+    return address < mapping.end ? &mapping : nullptr;
+}
+
+const ModuleMap::Mapping* ModuleMap::findByName(const std::string_view name) const noexcept
+{
+    const auto it = std::ranges::find(m_mappings, name, &Mapping::name);
+    return it != m_mappings.end() ? &*it : nullptr;
+}
@@ -0,0 +1,407 @@
+#include "PerfSampler.h"
+#include "PlatformUtils.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <utility>
+#include <linux/perf_event.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__aarch64__)
+#include <asm/perf_regs.h>
+#endif
+
+/// @brief Anonymous namespace
+namespace
+{
+#if defined(__x86_64__)
+    // Registers arrive in ascending bit order: bp, sp, ip.
+    constexpr uint64_t userRegisterMask = (1ULL << PERF_REG_X86_BP) | (1ULL << PERF_REG_X86_SP) | (1ULL << PERF_REG_X86_IP);
+#elif defined(__aarch64__)
+    // Registers arrive in ascending bit order: x29, lr, sp, pc.
+    constexpr uint64_t userRegisterMask = (1ULL << PERF_REG_ARM64_X29) | (1ULL << PERF_REG_ARM64_LR)
+        | (1ULL << PERF_REG_ARM64_SP) | (1ULL << PERF_REG_ARM64_PC);
+#else
+    constexpr uint64_t userRegisterMask = 0;
+#endif
+
+    constexpr size_t callchainRingPages = 8;
+    constexpr size_t userStackRingPages = 64;
+
+    /// @brief Room for the fixed fields of a sample record next to its stack copy.
+    constexpr size_t sampleOverheadBytes = 4096;
+
+    /// @brief Reader walks the fields of a sample record in the order fixed by its sample_type. \struct Reader
+    struct Reader
+    {
+        std::span<const std::byte> data;
+
+        template <typename T>
+        bool read(T& value) noexcept
+        {
+            if (data.size() < sizeof(T))
+            {
+                return false;
+            }
+            std::memcpy(&value, data.data(), sizeof(T));
+            data = data.subspan(sizeof(T));
+            return true;
+        }
+
+        std::span<const std::byte> take(const size_t bytes) noexcept
+        {
+            const auto count = std::min(bytes, data.size());
+            const auto taken = data.first(count);
+            data = data.subspan(count);
+            return taken;
+        }
+    };
+
+    size_t maxCallchainDepth() noexcept
+    {
+        // Asking for more than kernel.perf_event_max_stack fails the open with EOVERFLOW.
+        size_t depth = PERF_MAX_STACK_DEPTH;
+        std::ifstream sysctl("/proc/sys/kernel/perf_event_max_stack");
+        sysctl >> depth;
+        return depth;
+    }
+
+    size_t lockedPageBudget(const size_t pageSize) noexcept
+    {
+        // Unprivileged ring buffers are charged to perf_event_mlock_kb per online CPU first and to RLIMIT_MEMLOCK after that.
+        if (geteuid() == 0)
+        {
+            return SIZE_MAX;
+        }
+
+        size_t mlockKb = 516;
+        std::ifstream sysctl("/proc/sys/kernel/perf_event_mlock_kb");
+        sysctl >> mlockKb;
+        const auto cpus = static_cast<size_t>(std::max(sysconf(_SC_NPROCESSORS_ONLN), 1L));
+        auto budget = mlockKb * 1024 * cpus;
+
+        rlimit limit{};
+        if (getrlimit(RLIMIT_MEMLOCK, &limit) == 0)
+        {
+            if (limit.rlim_cur == RLIM_INFINITY)
+            {
+                return SIZE_MAX;
+            }
+            budget += limit.rlim_cur;
+        }
+        return budget / pageSize;
+    }
+
+    int openEvent(perf_event_attr& attr, const pid_t tid) noexcept
+    {
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, tid, -1, -1, PERF_FLAG_FD_CLOEXEC));
+    }
+
+    perf_event_attr makeAttributes(const uint32_t frequency, const size_t stackBytes, const size_t maxFrames) noexcept
+    {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        attr.freq = 1;
+        attr.sample_freq = frequency;
+        attr.sample_type = PERF_SAMPLE_TID | PERF_SAMPLE_CALLCHAIN;
+        attr.sample_max_stack = static_cast<uint16_t>(std::min(maxFrames, maxCallchainDepth()));
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.exclude_callchain_kernel = 1;
+        attr.watermark = 1;
+
+        if (stackBytes != 0 && userRegisterMask != 0)
+        {
+            attr.sample_type |= PERF_SAMPLE_REGS_USER | PERF_SAMPLE_STACK_USER;
+            attr.sample_regs_user = userRegisterMask;
+            attr.sample_stack_user = static_cast<uint32_t>(std::min(stackBytes, PerfSampler::maxStackBytes) & ~size_t{7});
+        }
+        return attr;
+    }
+}
+
+std::expected<PerfSampler, std::string> PerfSampler::open(
+    const pid_t pid,
+    const uint32_t frequency,
+    const size_t stackBytes,
+    const size_t maxFrames)
+{
+    const auto tids = PlatformUtils::listThreads(pid);
+    if (tids.empty())
+    {
+        return std::unexpected(std::format("Process {} has no threads", pid));
+    }
+
+    PerfSampler sampler;
+    auto attr = makeAttributes(frequency, stackBytes, maxFrames);
+    sampler.m_userStack = (attr.sample_type & PERF_SAMPLE_STACK_USER) != 0;
+
+    // Ring buffers must hold a power of two of data pages, at least two records each, and share one locked-memory budget.
+    const auto pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const auto minPages = sampler.m_userStack
+        ? std::bit_ceil((2 * (attr.sample_stack_user + sampleOverheadBytes) + pageSize - 1) / pageSize)
+        : size_t{1};
+    const auto perThread = lockedPageBudget(pageSize) / tids.size();
+    auto dataPages = std::bit_floor(std::clamp(perThread > 1 ? perThread - 1 : 0,
+        minPages, sampler.m_userStack ? userStackRingPages : callchainRingPages));
+
+    int lastError = 0;
+    for (const auto tid : tids)
+    {
+        for (;;)
+        {
+            const auto ringBytes = (1 + dataPages) * pageSize;
+            attr.wakeup_watermark = static_cast<uint32_t>(dataPages * pageSize / 4);
+
+            int fd = openEvent(attr, tid);
+            if (fd == -1 && sampler.m_events.empty() && attr.type == PERF_TYPE_HARDWARE
+                && (errno == ENOENT || errno == ENODEV || errno == EOPNOTSUPP || errno == EINVAL))
+            {
+                // No PMU, as in most VMs: fall back to the software clock for every thread.
+                attr.type = PERF_TYPE_SOFTWARE;
+                attr.config = PERF_COUNT_SW_CPU_CLOCK;
+                sampler.m_softwareClock = true;
+                fd = openEvent(attr, tid);
+            }
+
+            if (fd == -1)
+            {
+                // Threads that exit while the events are opened are simply not sampled.
+                lastError = errno;
+                if (errno != ESRCH)
+                {
+                    ++sampler.m_unsampledThreads;
+                }
+                break;
+            }
+
+            void* ring = mmap(nullptr, ringBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (ring != MAP_FAILED)
+            {
+                sampler.m_events.push_back(Event{fd, ring, ringBytes});
+                break;
+            }
+
+            // EPERM means the locked-memory budget is spent; later threads start from the smaller ring as well.
+            lastError = errno;
+            close(fd);
+            if ((lastError != EPERM && lastError != ENOMEM) || dataPages <= minPages)
+            {
+                ++sampler.m_unsampledThreads;
+                break;
+            }
+            dataPages /= 2;
+        }
+    }
+
+    if (sampler.m_events.empty())
+    {
+        return std::unexpected(std::format("perf_event_open failed for process {}: {}{}", pid, std::strerror(lastError),
+            lastError == EPERM ? " (check kernel.perf_event_paranoid and kernel.perf_event_mlock_kb)" : ""));
+    }
+    return sampler;
+}
+
+PerfSampler::PerfSampler(PerfSampler&& other) noexcept
+    : m_events(std::exchange(other.m_events, {}))
+    , m_softwareClock(other.m_softwareClock)
+    , m_userStack(other.m_userStack)
+    , m_lostSamples(other.m_lostSamples)
+    , m_unsampledThreads(other.m_unsampledThreads)
+    , m_record(std::move(other.m_record))
+    , m_callchain(std::move(other.m_callchain))
+    , m_snapshot(std::move(other.m_snapshot))
+{
+
+}
+
+PerfSampler& PerfSampler::operator=(PerfSampler&& other) noexcept
+{
+    if (this != &other)
+    {
+        closeEvents();
+        m_events = std::exchange(other.m_events, {});
+        m_softwareClock = other.m_softwareClock;
+        m_userStack = other.m_userStack;
+        m_lostSamples = other.m_lostSamples;
+        m_unsampledThreads = other.m_unsampledThreads;
+        m_record = std::move(other.m_record);
+        m_callchain = std::move(other.m_callchain);
+        m_snapshot = std::move(other.m_snapshot);
+    }
+    return *this;
+}
+
+PerfSampler::~PerfSampler()
+{
+    closeEvents();
+}
+
+void PerfSampler::closeEvents() noexcept
+{
+    for (const auto& event : m_events)
+    {
+        munmap(event.ring, event.ringBytes);
+        close(event.fd);
+    }
+    m_events.clear();
+}
+
+void PerfSampler::setEnabled(const bool enabled) const noexcept
+{
+    for (const auto& event : m_events)
+    {
+        ioctl(event.fd, enabled ? PERF_EVENT_IOC_ENABLE : PERF_EVENT_IOC_DISABLE, 0);
+    }
+}
+
+void PerfSampler::wait(const std::chrono::milliseconds timeout) const noexcept
+{
+    std::vector<pollfd> fds;
+    fds.reserve(m_events.size());
+    for (const auto& event : m_events)
+    {
+        fds.push_back(pollfd{event.fd, POLLIN, 0});
+    }
+    poll(fds.data(), fds.size(), static_cast<int>(timeout.count()));
+}
+
+void PerfSampler::drain(const std::function<void(const Sample&)>& onSample)
+{
+    const auto pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+
+    for (const auto& event : m_events)
+    {
+        auto* meta = static_cast<perf_event_mmap_page*>(event.ring);
+        const auto* data = static_cast<const std::byte*>(event.ring) + pageSize;
+        const auto dataSize = event.ringBytes - pageSize;
+
+        const auto head = __atomic_load_n(&meta->data_head, __ATOMIC_ACQUIRE);
+        auto tail = meta->data_tail;
+
+        while (tail < head)
+        {
+            // Headers are 8-byte aligned and never wrap; a record body may.
+            perf_event_header header{};
+            std::memcpy(&header, data + tail % dataSize, sizeof(header));
+            if (header.size < sizeof(header) || header.size > head - tail)
+            {
+                tail = head;
+                break;
+            }
+
+            const auto offset = tail % dataSize;
+            if (offset + header.size <= dataSize)
+            {
+                handleRecord(std::span(data + offset, header.size), onSample);
+            }
+            else
+            {
+                const auto first = dataSize - offset;
+                m_record.resize(header.size);
+                std::memcpy(m_record.data(), data + offset, first);
+                std::memcpy(m_record.data() + first, data, header.size - first);
+                handleRecord(m_record, onSample);
+            }
+            tail += header.size;
+        }
+
+        __atomic_store_n(&meta->data_tail, tail, __ATOMIC_RELEASE);
+    }
+}
+
+void PerfSampler::handleRecord(const std::span<const std::byte> record, const std::function<void(const Sample&)>& onSample)
+{
+    perf_event_header header{};
+    Reader reader{record};
+    reader.read(header);
+
+    if (header.type == PERF_RECORD_LOST)
+    {
+        uint64_t id = 0;
+        uint64_t lost = 0;
+        if (reader.read(id) && reader.read(lost))
+        {
+            m_lostSamples += lost;
+        }
+        return;
+    }
+
+    if (header.type != PERF_RECORD_SAMPLE)
+    {
+        return;
+    }
+
+    uint32_t pid = 0;
+    uint32_t tid = 0;
+    uint64_t depth = 0;
+    if (!reader.read(pid) || !reader.read(tid) || !reader.read(depth))
+    {
+        return;
+    }
+
+    // The callchain interleaves context markers such as PERF_CONTEXT_USER with the addresses.
+    m_callchain.clear();
+    for (uint64_t i = 0; i < depth; ++i)
+    {
+        uint64_t address = 0;
+        if (!reader.read(address))
+        {
+            return;
+        }
+        if (address < PERF_CONTEXT_MAX)
+        {
+            m_callchain.push_back(static_cast<uintptr_t>(address));
+        }
+    }
+
+    Sample sample{static_cast<pid_t>(tid), m_callchain, nullptr};
+
+    uint64_t abi = PERF_SAMPLE_REGS_ABI_NONE;
+    if (m_userStack && reader.read(abi) && abi != PERF_SAMPLE_REGS_ABI_NONE)
+    {
+        std::array<uint64_t, std::popcount(userRegisterMask)> regs{};
+        for (auto& reg : regs)
+        {
+            reader.read(reg);
+        }
+
+        uint64_t stackSize = 0;
+        reader.read(stackSize);
+        const auto stack = reader.take(stackSize);
+        uint64_t dynamicSize = 0;
+        if (stackSize != 0)
+        {
+            reader.read(dynamicSize);
+        }
+
+        m_snapshot.tid = sample.tid;
+#if defined(__x86_64__)
+        m_snapshot.regs.rbp = regs[0];
+        m_snapshot.regs.rsp = regs[1];
+        m_snapshot.regs.rip = regs[2];
+#elif defined(__aarch64__)
+        m_snapshot.regs.regs[29] = regs[0];
+        m_snapshot.regs.regs[30] = regs[1];
+        m_snapshot.regs.sp = regs[2];
+        m_snapshot.regs.pc = regs[3];
+#endif
+        m_snapshot.stackStart = m_snapshot.stackPointer();
+        const auto valid = stack.first(std::min<size_t>(dynamicSize, stack.size()));
+        m_snapshot.stack.assign(valid.begin(), valid.end());
+        sample.snapshot = &m_snapshot;
+    }
+
+    onSample(sample);
+}
@@ -1,4 +1,7 @@
 #include "PlatformUtils.h"
+#include "ModuleMap.h"
+#include "Symbolizer.h"
+#include "ThreadPool.h"
 #include <unistd.h>
 #include <dirent.h>
 #include <sys/types.h>
@@ -6,6 +9,7 @@
 #include <sys/user.h>
 #include <sys/ptrace.h>
 #include <sys/wait.h>
+#include <sys/uio.h>
 #include <signal.h>
 #include <fcntl.h>
 #include <climits>
@@ -13,11 +17,37 @@
 #include <cstdlib>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
 #include <array>
 #include <charconv>
 #include <format>
+#include <future>
 #include <regex>
+#include <system_error>
+#include <unordered_set>
+#include <utility>
 
+/// @brief Anonymous namespace
+namespace
+{
+    void copyStack(const size_t maxStackBytes, const ModuleMap* modules, StackSnapshot& snapshot) noexcept
+    {
+        const auto sp = snapshot.stackPointer();
+        auto size = maxStackBytes;
+
+        if (modules != nullptr)
+        {
+            if (const auto* mapping = modules->find(sp); mapping != nullptr)
+            {
+                size = std::min<size_t>(size, mapping->end - sp);
+            }
+        }
+
+        snapshot.stackStart = sp;
+        snapshot.stack.resize(size);
+        snapshot.stack.resize(PlatformUtils::readMemory(snapshot.tid, sp, snapshot.stack));
+    }
+}
 
 bool PlatformUtils::isProcessRunning(const pid_t pid) noexcept
 {
@@ -89,6 +119,195 @@ void PlatformUtils::detachFromProcess(const pid_t pid) noexcept
     ptrace(PTRACE_DETACH, pid, nullptr, nullptr);
 }
 
+std::vector<pid_t> PlatformUtils::listThreads(const pid_t pid) noexcept
+{
+    std::vector<pid_t> tids;
+    const auto path = std::format("/proc/{}/task", pid);
+    DIR* dir = opendir(path.c_str());
+
+    if (dir == nullptr)
+    {
+        return tids;
+    }
+
+    const dirent* entry = nullptr;
+    while ((entry = readdir(dir)) != nullptr)
+    {
+        pid_t tid = 0;
+        auto [ptr, ec] = std::from_chars(entry->d_name, entry->d_name + std::strlen(entry->d_name), tid);
+        if (ec == std::errc() && *ptr == '\0')
+        {
+            tids.push_back(tid);
+        }
+    }
+
+    closedir(dir);
+    std::ranges::sort(tids);
+    return tids;
+}
+
+std::optional<std::string> PlatformUtils::getThreadName(const pid_t pid, const pid_t tid) noexcept
+{
+    const auto path = std::format("/proc/{}/task/{}/comm", pid, tid);
+    std::ifstream commFile(path);
+
+    if (!commFile)
+    {
+        return std::nullopt;
+    }
+
+    std::string name;
+    std::getline(commFile, name);
+    return name.empty() ? std::nullopt : std::optional{name};
+}
+
+std::optional<StackSnapshot::Syscall> PlatformUtils::readThreadSyscall(const pid_t pid, const pid_t tid) noexcept
+{
+    std::ifstream syscallFile(std::format("/proc/{}/task/{}/syscall", pid, tid));
+    std::string line;
+    if (!syscallFile || !std::getline(syscallFile, line))
+    {
+        return std::nullopt;
+    }
+    return parseSyscall(line);
+}
+
+std::optional<StackSnapshot::Syscall> PlatformUtils::parseSyscall(const std::string_view text) noexcept
+{
+    // Either "running", "-1 sp pc", or the number followed by six hex arguments, sp and pc.
+    auto nextField = [rest = text]() mutable
+    {
+        const auto begin = std::min(rest.find_first_not_of(" \n"), rest.size());
+        rest.remove_prefix(begin);
+        const auto field = rest.substr(0, std::min(rest.find_first_of(" \n"), rest.size()));
+        rest.remove_prefix(field.size());
+        return field;
+    };
+
+    StackSnapshot::Syscall result;
+    const auto number = nextField();
+    if (number.empty() || number == "running")
+    {
+        return number.empty() ? std::nullopt : std::optional{result};
+    }
+
+    if (std::from_chars(number.data(), number.data() + number.size(), result.number).ec != std::errc())
+    {
+        return std::nullopt;
+    }
+    if (result.number == StackSnapshot::notInSyscall)
+    {
+        return result;
+    }
+
+    for (auto& arg : result.args)
+    {
+        const auto field = nextField();
+        if (!field.starts_with("0x") || std::from_chars(field.data() + 2, field.data() + field.size(), arg, 16).ec != std::errc())
+        {
+            return std::nullopt;
+        }
+    }
+    return result;
+}
+
+std::optional<PlatformUtils::StoppedThread> PlatformUtils::stopThread(const pid_t tid) noexcept
+{
+    if (ptrace(PTRACE_SEIZE, tid, nullptr, nullptr) == -1)
+    {
+        return std::nullopt;
+    }
+
+    if (ptrace(PTRACE_INTERRUPT, tid, nullptr, nullptr) == -1)
+    {
+        ptrace(PTRACE_DETACH, tid, nullptr, nullptr);
+        return std::nullopt;
+    }
+
+    auto thread = waitForStop(tid);
+    if (!thread)
+    {
+        ptrace(PTRACE_DETACH, tid, nullptr, nullptr);
+    }
+    return thread;
+}
+
+std::vector<PlatformUtils::StoppedThread> PlatformUtils::stopAllThreads(const pid_t pid) noexcept
+{
+    std::vector<StoppedThread> stopped;
+    stopAllThreads(pid, stopped);
+    return stopped;
+}
+
+void PlatformUtils::stopAllThreads(const pid_t pid, std::vector<StoppedThread>& stopped) noexcept
+{
+    constexpr int maxScans = 4;
+
+    stopped.clear();
+    std::unordered_set<pid_t> seen;
+
+    for (int scan = 0; scan < maxScans; ++scan)
+    {
+        std::vector<pid_t> seized;
+        for (const auto tid : listThreads(pid))
+        {
+            if (seen.insert(tid).second && ptrace(PTRACE_SEIZE, tid, nullptr, nullptr) != -1)
+            {
+                seized.push_back(tid);
+            }
+        }
+
+        if (seized.empty())
+        {
+            break;
+        }
+
+        // A thread that cannot be interrupted or never reports its stop stays seized unless it is detached here.
+        std::erase_if(seized, [](const pid_t tid)
+        {
+            if (ptrace(PTRACE_INTERRUPT, tid, nullptr, nullptr) == -1)
+            {
+                ptrace(PTRACE_DETACH, tid, nullptr, nullptr);
+                return true;
+            }
+            return false;
+        });
+
+        for (const auto tid : seized)
+        {
+            if (const auto thread = waitForStop(tid))
+            {
+                stopped.push_back(*thread);
+            }
+            else
+            {
+                ptrace(PTRACE_DETACH, tid, nullptr, nullptr);
+            }
+        }
+    }
+}
+
+std::optional<PlatformUtils::StoppedThread> PlatformUtils::waitForStop(const pid_t tid) noexcept
+{
+    int status = 0;
+    if (waitpid(tid, &status, __WALL) == -1 || !WIFSTOPPED(status))
+    {
+        return std::nullopt;
+    }
+
+    // A signal-delivery-stop may be reported before our interrupt; hand the signal back on detach.
+    const bool interrupted = (status >> 16) == PTRACE_EVENT_STOP;
+    return StoppedThread{tid, interrupted ? 0 : WSTOPSIG(status)};
+}
+
+void PlatformUtils::releaseThreads(const std::span<const StoppedThread> threads) noexcept
+{
+    for (const auto& thread : threads)
+    {
+        ptrace(PTRACE_DETACH, thread.tid, nullptr, reinterpret_cast<void*>(static_cast<intptr_t>(thread.pendingSignal)));
+    }
+}
+
 std::optional<std::string> PlatformUtils::getExecutablePath(const pid_t pid) noexcept
 {
     std::array<char, PATH_MAX> path{};
@@ -104,73 +323,421 @@ std::optional<std::string> PlatformUtils::getExecutablePath(const pid_t pid) noe
     return std::string(path.data());
 }
 
-std::vector<StackFrame> PlatformUtils::readProcessStack(const pid_t pid) noexcept
+std::vector<uintptr_t> PlatformUtils::readProcessAddresses(
+    const pid_t pid,
+    const ModuleMap& modules,
+    const size_t maxStackBytes,
+    const Unwinder::Method method,
+    const size_t maxFrames) noexcept
 {
-    std::vector<StackFrame> frames;
+    const auto snapshot = captureStackSnapshot(pid, maxStackBytes, &modules);
+    if (!snapshot)
+    {
+        return {};
+    }
+    return Unwinder::unwind(*snapshot, modules, method, maxFrames);
+}
 
-    const auto execPath = getExecutablePath(pid);
-    if (!execPath)
+std::vector<StackFrame> PlatformUtils::readProcessStack(
+    const pid_t pid,
+    const size_t maxStackBytes,
+    const Unwinder::Method method) noexcept
+{
+    const auto modules = ModuleMap::read(pid);
+    const auto snapshot = captureStackSnapshot(pid, maxStackBytes, modules ? &*modules : nullptr);
+    if (!snapshot)
     {
-        return frames;
+        return {};
     }
 
-    user_regs_struct regs{};
-    if (ptrace(PTRACE_GETREGS, pid, nullptr, &regs) == -1)
+    if (!modules)
     {
-        return frames;
+        return resolveProcessAddresses(pid, walkFramePointers(*snapshot));
     }
 
-#if defined(__x86_64__)
-    auto ip = regs.rip;
-    auto bp = regs.rbp;
-#elif defined(__i386__)
-    auto ip = regs.eip;
-    auto bp = regs.ebp;
-#elif defined(__aarch64__)
-    auto ip = regs.pc;
-    auto bp = regs.regs[29];
-#else
-    return frames;
-#endif
+    const auto addresses = Unwinder::unwind(*snapshot, *modules, method, defaultMaxFrames);
+    return resolveProcessAddresses(*modules, addresses);
+}
+
+size_t PlatformUtils::readMemory(const pid_t pid, const uintptr_t address, const std::span<std::byte> buffer) noexcept
+{
+    if (buffer.empty())
+    {
+        return 0;
+    }
 
-    frames.push_back(resolveAddress(*execPath, ip));
+    // One remote iovec per page: the kernel never splits an iovec, so a read that
+    // runs into an unmapped page still returns everything before it.
+    const auto pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    std::array<iovec, 256> remote{};
+    size_t total = 0;
 
-    constexpr std::size_t maxFrames = 64;
-    for (std::size_t i = 0; i < maxFrames && bp != 0; ++i)
+    while (total < buffer.size())
     {
-        std::uintptr_t nextBp = 0;
-        std::uintptr_t retAddr = 0;
+        size_t count = 0;
+        size_t batchBytes = 0;
+        auto cursor = address + total;
+        while (count < remote.size() && total + batchBytes < buffer.size())
+        {
+            const auto chunk = std::min<size_t>(pageSize - (cursor % pageSize), buffer.size() - total - batchBytes);
+            remote[count++] = iovec{reinterpret_cast<void*>(cursor), chunk};
+            cursor += chunk;
+            batchBytes += chunk;
+        }
 
-        errno = 0;
-        nextBp = static_cast<std::uintptr_t>(
-            ptrace(PTRACE_PEEKDATA, pid, bp, nullptr)
-        );
-        if (errno != 0)
+        iovec local{buffer.data() + total, batchBytes};
+        const auto read = process_vm_readv(pid, &local, 1, remote.data(), count, 0);
+        if (read <= 0)
         {
             break;
         }
 
-        errno = 0;
-        retAddr = static_cast<std::uintptr_t>(
-            ptrace(PTRACE_PEEKDATA, pid, bp + sizeof(void*), nullptr)
-        );
-        if (errno != 0)
+        total += static_cast<size_t>(read);
+        if (static_cast<size_t>(read) < batchBytes)
+        {
+            return total;
+        }
+    }
+
+    if (total > 0)
+    {
+        return total;
+    }
+
+    const auto memPath = std::format("/proc/{}/mem", pid);
+    const int fd = open(memPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        return 0;
+    }
+
+    while (total < buffer.size())
+    {
+        const auto chunk = std::min<size_t>(pageSize - ((address + total) % pageSize), buffer.size() - total);
+        const auto read = pread(fd, buffer.data() + total, chunk, static_cast<off_t>(address + total));
+        if (read <= 0)
         {
             break;
         }
+        total += static_cast<size_t>(read);
+    }
+
+    close(fd);
+    return total;
+}
+
+std::optional<StackSnapshot> PlatformUtils::captureStackSnapshot(
+    const pid_t tid,
+    const size_t maxStackBytes,
+    const ModuleMap* modules) noexcept
+{
+    StackSnapshot snapshot;
+    if (!captureStackSnapshot(tid, maxStackBytes, modules, snapshot))
+    {
+        return std::nullopt;
+    }
+    return snapshot;
+}
+
+bool PlatformUtils::captureStackSnapshot(
+    const pid_t tid,
+    const size_t maxStackBytes,
+    const ModuleMap* modules,
+    StackSnapshot& snapshot) noexcept
+{
+    snapshot.tid = tid;
+
+    if (ptrace(PTRACE_GETREGS, tid, nullptr, &snapshot.regs) == -1)
+    {
+        return false;
+    }
+
+    copyStack(maxStackBytes, modules, snapshot);
+    return true;
+}
+
+void PlatformUtils::captureStackSnapshots(
+    const std::span<const StoppedThread> threads,
+    const size_t maxStackBytes,
+    const ModuleMap* modules,
+    const std::span<StackSnapshot> snapshots,
+    const std::span<uint8_t> captured,
+    ThreadPool* pool) noexcept
+{
+    constexpr size_t minShardSize = 8;
+
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        snapshots[i].tid = threads[i].tid;
+        captured[i] = ptrace(PTRACE_GETREGS, threads[i].tid, nullptr, &snapshots[i].regs) != -1;
+        if (!captured[i])
+        {
+            snapshots[i].stack.clear();
+        }
+    }
+
+    auto copyShard = [&](const size_t begin, const size_t end) noexcept
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            if (captured[i])
+            {
+                copyStack(maxStackBytes, modules, snapshots[i]);
+            }
+        }
+    };
+
+    if (pool == nullptr || threads.size() < 2 * minShardSize)
+    {
+        copyShard(0, threads.size());
+        return;
+    }
+
+    // The calling thread copies the first shard itself instead of idling until the pool is done.
+    const auto shardSize = std::max(minShardSize, (threads.size() + pool->size()) / (pool->size() + 1));
+    std::vector<std::future<void>> pending;
+    size_t begin = shardSize;
+    try
+    {
+        pending.reserve(threads.size() / shardSize);
+        for (; begin < threads.size(); begin += shardSize)
+        {
+            const auto end = std::min(begin + shardSize, threads.size());
+            pending.push_back(pool->submit([&copyShard, begin, end] { copyShard(begin, end); }));
+        }
+    }
+    catch (const std::bad_alloc&)
+    {
+    }
+    catch (const std::system_error&)
+    {
+    }
+
+    // Shards the pool could not take are copied here, so every captured thread gets its stack.
+    copyShard(0, std::min(shardSize, threads.size()));
+    if (begin < threads.size())
+    {
+        copyShard(begin, threads.size());
+    }
+
+    for (auto& future : pending)
+    {
+        future.wait();
+    }
+}
+
+std::vector<uintptr_t> PlatformUtils::walkFramePointers(const StackSnapshot& snapshot, const size_t maxFrames) noexcept
+{
+    std::vector<uintptr_t> addresses{snapshot.programCounter()};
 
-        if (retAddr == 0)
+    // The thread may be running again; words beyond the copy would belong to a different stack.
+    auto bp = snapshot.framePointer();
+    while (addresses.size() < maxFrames && bp != 0)
+    {
+        const auto nextBp = snapshot.readWord(bp);
+        const auto retAddr = snapshot.readWord(bp + sizeof(void*));
+
+        if (!nextBp || !retAddr || *retAddr == 0)
         {
             break;
         }
 
-        frames.push_back(resolveAddress(*execPath, retAddr));
-        bp = nextBp;
+        addresses.push_back(*retAddr);
 
-        if (nextBp <= bp && nextBp != 0)
+        if (*nextBp <= bp && *nextBp != 0)
         {
             break;
         }
+        bp = *nextBp;
+    }
+
+    return addresses;
+}
+
+std::vector<StackFrame> PlatformUtils::resolveProcessAddresses(const pid_t pid, const std::span<const uintptr_t> addresses) noexcept
+{
+    std::vector<StackFrame> frames;
+    frames.reserve(addresses.size());
+    for (const auto address : addresses)
+    {
+        frames.emplace_back(address);
+    }
+
+    const auto modules = ModuleMap::read(pid);
+    if (modules)
+    {
+        return resolveProcessAddresses(*modules, addresses);
+    }
+
+    if (const auto execPath = getExecutablePath(pid))
+    {
+        for (auto& frame : frames)
+        {
+            frame = resolveAddress(*execPath, frame.getAddress());
+        }
+    }
+    return frames;
+}
+
+std::vector<StackFrame> PlatformUtils::resolveProcessAddresses(
+    const ModuleMap& modules,
+    const std::span<const uintptr_t> addresses,
+    ThreadPool* pool) noexcept
+{
+    std::vector<uintptr_t> lookupAddresses;
+    lookupAddresses.reserve(addresses.size());
+    for (size_t i = 0; i < addresses.size(); ++i)
+    {
+        lookupAddresses.push_back(callSiteAddress(addresses, i));
+    }
+
+    auto frames = resolveModuleAddresses(modules, lookupAddresses, pool);
+    for (size_t i = 0; i < frames.size(); ++i)
+    {
+        frames[i].setAddress(addresses[i]);
+    }
+    return frames;
+}
+
+std::vector<StackFrame> PlatformUtils::resolveModuleAddresses(
+    const ModuleMap& modules,
+    const std::span<const uintptr_t> addresses,
+    ThreadPool* pool) noexcept
+{
+    constexpr size_t minShardSize = 256;
+
+    std::vector<StackFrame> frames;
+    frames.reserve(addresses.size());
+    for (const auto address : addresses)
+    {
+        frames.emplace_back(address);
+    }
+
+    /// @brief Lookup pairs a frame index with the file offset its address maps to. \struct Lookup
+    struct Lookup
+    {
+        size_t frameIndex{0};
+        uint64_t fileOffset{0};
+    };
+
+    std::vector<std::vector<Lookup>> byModule(modules.modules().size());
+    for (size_t i = 0; i < addresses.size(); ++i)
+    {
+        const auto* mapping = modules.find(addresses[i]);
+        if (mapping != nullptr && mapping->moduleId != ModuleMap::noModule)
+        {
+            byModule[mapping->moduleId].push_back(Lookup{i, ModuleMap::fileOffset(*mapping, addresses[i])});
+        }
+    }
+
+    // A shard whose module cannot be loaded or indexed, because memory ran out or a lock could not be taken,
+    // names its remaining frames after the failure instead of leaving them unresolved without a reason.
+    // Naming the frames interns strings too; if even that runs out of memory they stay bare addresses.
+    auto markFailed = [&modules, &frames](const size_t moduleId, const std::span<const Lookup> shard) noexcept
+    {
+        try
+        {
+            for (const auto& lookup : shard)
+            {
+                frames[lookup.frameIndex].setFunctionName(symbolizationFailed);
+                frames[lookup.frameIndex].setModule(modules.modules()[moduleId]);
+            }
+        }
+        catch (const std::bad_alloc&)
+        {
+        }
+    };
+
+    // Every lookup writes only its own frame, so shards of one module can run concurrently.
+    auto resolveShard = [&modules, &frames, &addresses, &markFailed](const size_t moduleId, const std::span<const Lookup> shard) noexcept
+    {
+        const auto& modulePath = modules.modules()[moduleId];
+        size_t resolved = 0;
+        try
+        {
+            auto& symbolizer = Symbolizer::instance();
+            for (; resolved < shard.size(); ++resolved)
+            {
+                const auto [frameIndex, fileOffset] = shard[resolved];
+                const auto linkAddress = symbolizer.linkAddress(modulePath, fileOffset);
+                if (linkAddress)
+                {
+                    frames[frameIndex] = resolveAddress(modulePath, *linkAddress);
+                    frames[frameIndex].setAddress(addresses[frameIndex]);
+                }
+                frames[frameIndex].setModule(modulePath);
+            }
+        }
+        catch (const std::bad_alloc&)
+        {
+            markFailed(moduleId, shard.subspan(resolved));
+        }
+        catch (const std::system_error&)
+        {
+            markFailed(moduleId, shard.subspan(resolved));
+        }
+    };
+
+    if (pool == nullptr || addresses.size() < 2 * minShardSize)
+    {
+        for (size_t moduleId = 0; moduleId < byModule.size(); ++moduleId)
+        {
+            resolveShard(moduleId, byModule[moduleId]);
+        }
+        return frames;
+    }
+
+    /// @brief Shard is a slice of the lookups of one module. \struct Shard
+    struct Shard
+    {
+        size_t moduleId{0};
+        std::span<const Lookup> lookups;
+    };
+
+    const auto shardSize = std::max(minShardSize, addresses.size() / (pool->size() * 4));
+    std::vector<Shard> shards;
+    for (size_t moduleId = 0; moduleId < byModule.size(); ++moduleId)
+    {
+        const std::span<const Lookup> lookups = byModule[moduleId];
+        for (size_t begin = 0; begin < lookups.size(); begin += shardSize)
+        {
+            shards.push_back(Shard{moduleId, lookups.subspan(begin, std::min(shardSize, lookups.size() - begin))});
+        }
+    }
+
+    // Reserved up front so a submitted task never loses its future, which would let it outlive this frame.
+    std::vector<std::future<void>> pending;
+    pending.reserve(shards.size());
+    try
+    {
+        for (const auto& shard : shards)
+        {
+            pending.push_back(pool->submit([&resolveShard, shard] { resolveShard(shard.moduleId, shard.lookups); }));
+        }
+    }
+    catch (const std::bad_alloc&)
+    {
+    }
+    catch (const std::system_error&)
+    {
+    }
+
+    // Shards the pool could not take are resolved here rather than dropped.
+    for (size_t i = pending.size(); i < shards.size(); ++i)
+    {
+        resolveShard(shards[i].moduleId, shards[i].lookups);
+    }
+
+    for (size_t i = 0; i < pending.size(); ++i)
+    {
+        try
+        {
+            pending[i].get();
+        }
+        catch (const std::future_error&)
+        {
+            markFailed(shards[i].moduleId, shards[i].lookups);
+        }
     }
 
     return frames;
@@ -193,6 +760,22 @@ bool PlatformUtils::isAddr2lineAvailable() noexcept
 }
 
 StackFrame PlatformUtils::resolveAddress(std::string_view execPath, uintptr_t address) noexcept
+{
+    try
+    {
+        if (auto frame = Symbolizer::instance().resolve(execPath, address))
+        {
+            return std::move(*frame);
+        }
+    }
+    catch (...)
+    {
+    }
+
+    return resolveWithAddr2line(execPath, address);
+}
+
+StackFrame PlatformUtils::resolveWithAddr2line(std::string_view execPath, uintptr_t address) noexcept
 {
     StackFrame frame(address);
 
@@ -201,7 +784,7 @@ StackFrame PlatformUtils::resolveAddress(std::string_view execPath, uintptr_t ad
         return frame;
     }
 
-    const auto cmd = std::format("addr2line - e {} -f -C -p {:x} 2>/dev/null", execPath, address);
+    const auto cmd = std::format("addr2line -e {} -f -C -p {:x} 2>/dev/null", execPath, address);
 
     FILE* pipe = popen(cmd.c_str(), "r");
     if (pipe == nullptr)
@@ -215,6 +798,7 @@ StackFrame PlatformUtils::resolveAddress(std::string_view execPath, uintptr_t ad
     {
         result += buffer.data();
     }
+    pclose(pipe);
 
     if (result.empty() || result.find("??") != std::string::npos)
     {
@@ -231,13 +815,13 @@ StackFrame PlatformUtils::resolveAddress(std::string_view execPath, uintptr_t ad
     {
         frame.setFunctionName(result.substr(0, atPos));
 
-        const auto localStr = result.substr(atPos, 4);
+        const auto localStr = result.substr(atPos + 4);
         const auto colonPos = localStr.rfind(':');
         if (colonPos != std::string::npos)
         {
             frame.setSourceFile(localStr.substr(0, colonPos));
             size_t lineNum = 0;
-            const auto lineStr = localStr.substr(0, colonPos + 1);
+            const auto lineStr = std::string_view(localStr).substr(colonPos + 1);
             auto [ptr, ec] = std::from_chars(lineStr.data(), lineStr.data() + lineStr.size(), lineNum);
 
             if (ec == std::errc())
@@ -0,0 +1,443 @@
+#include "ProcessScanner.h"
+#include "PlatformUtils.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/// @brief Anonymous namespace
+namespace
+{
+    constexpr size_t scanBufferSize = 4096;
+    constexpr size_t minShardSize = 1024;
+
+    /// @brief Dirent64 mirrors the kernel's linux_dirent64 record returned by getdents64. \struct Dirent64
+    struct Dirent64
+    {
+        uint64_t inode;
+        int64_t offset;
+        unsigned short length;
+        unsigned char type;
+        char name[1];
+    };
+
+    template <typename T>
+    bool parseNumber(std::string_view& text, T& value) noexcept
+    {
+        const auto begin = text.find_first_not_of(" \t");
+        if (begin == std::string_view::npos)
+        {
+            return false;
+        }
+        text.remove_prefix(begin);
+
+        const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (ec != std::errc())
+        {
+            return false;
+        }
+        text.remove_prefix(static_cast<size_t>(ptr - text.data()));
+        return true;
+    }
+
+    void skipFields(std::string_view& text, size_t count) noexcept
+    {
+        while (count-- > 0)
+        {
+            const auto begin = text.find_first_not_of(' ');
+            const auto end = text.find(' ', begin == std::string_view::npos ? text.size() : begin);
+            text.remove_prefix(std::min(end, text.size()));
+        }
+    }
+
+    bool parseStat(const std::string_view stat, ProcessScanner::ProcessInfo& info)
+    {
+        // The command name may itself contain spaces and parentheses; it ends at the last ')'.
+        const auto open = stat.find('(');
+        const auto close = stat.rfind(')');
+        if (open == std::string_view::npos || close == std::string_view::npos || close < open)
+        {
+            return false;
+        }
+        info.name.assign(stat.substr(open + 1, close - open - 1));
+
+        auto rest = stat.substr(close + 1);
+        const auto stateBegin = rest.find_first_not_of(' ');
+        if (stateBegin == std::string_view::npos)
+        {
+            return false;
+        }
+        info.state = rest[stateBegin];
+        rest.remove_prefix(stateBegin + 1);
+
+        uint64_t utime = 0;
+        uint64_t stime = 0;
+        int64_t threads = 0;
+        int64_t rssPages = 0;
+
+        // Fields after the state, counted from 4 (ppid) as in proc(5).
+        if (!parseNumber(rest, info.parentPid))
+        {
+            return false;
+        }
+        skipFields(rest, 9);
+        if (!parseNumber(rest, utime) || !parseNumber(rest, stime))
+        {
+            return false;
+        }
+        skipFields(rest, 4);
+        if (!parseNumber(rest, threads))
+        {
+            return false;
+        }
+        skipFields(rest, 3);
+        if (!parseNumber(rest, rssPages))
+        {
+            return false;
+        }
+
+        static const auto pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+        info.cpuTicks = utime + stime;
+        info.threads = static_cast<uint32_t>(std::max<int64_t>(threads, 0));
+        info.rssBytes = static_cast<uint64_t>(std::max<int64_t>(rssPages, 0)) * pageSize;
+        return true;
+    }
+
+    std::string_view readFileAt(const int dirFd, const char* path, const std::span<char> buffer) noexcept
+    {
+        const int fd = openat(dirFd, path, O_RDONLY | O_CLOEXEC);
+        if (fd == -1)
+        {
+            return {};
+        }
+
+        size_t total = 0;
+        while (total < buffer.size())
+        {
+            const auto bytes = ::read(fd, buffer.data() + total, buffer.size() - total);
+            if (bytes <= 0)
+            {
+                break;
+            }
+            total += static_cast<size_t>(bytes);
+        }
+
+        close(fd);
+        return std::string_view(buffer.data(), total);
+    }
+
+    std::string_view readWholeFileAt(const int dirFd, const char* path, std::vector<char>& buffer)
+    {
+        const int fd = openat(dirFd, path, O_RDONLY | O_CLOEXEC);
+        if (fd == -1)
+        {
+            return {};
+        }
+
+        // /proc sizes its files at zero, so the buffer grows until a read reports the end.
+        size_t total = 0;
+        for (;;)
+        {
+            if (total == buffer.size())
+            {
+                buffer.resize(std::max(buffer.size() * 2, scanBufferSize));
+            }
+
+            const auto bytes = ::read(fd, buffer.data() + total, buffer.size() - total);
+            if (bytes <= 0)
+            {
+                break;
+            }
+            total += static_cast<size_t>(bytes);
+        }
+
+        close(fd);
+        return std::string_view(buffer.data(), total);
+    }
+
+    const char* makePath(std::array<char, 64>& path, const pid_t id, const std::string_view file) noexcept
+    {
+        auto [end, ec] = std::to_chars(path.data(), path.data() + path.size() - file.size() - 2, id);
+        if (ec != std::errc())
+        {
+            return nullptr;
+        }
+        *end++ = '/';
+        end = std::copy(file.begin(), file.end(), end);
+        *end = '\0';
+        return path.data();
+    }
+
+    uint64_t statusCounter(const std::string_view status, const std::string_view key) noexcept
+    {
+        const auto pos = status.find(key);
+        if (pos == std::string_view::npos)
+        {
+            return 0;
+        }
+
+        auto line = status.substr(pos + key.size());
+        uint64_t value = 0;
+        static_cast<void>(parseNumber(line, value));
+        return value;
+    }
+
+    void parseStatus(const std::string_view status, ProcessScanner::ProcessInfo& info) noexcept
+    {
+        const auto uidPos = status.find("\nUid:");
+        if (uidPos == std::string_view::npos)
+        {
+            return;
+        }
+
+        auto line = status.substr(uidPos + 5);
+        static_cast<void>(parseNumber(line, info.uid));
+    }
+}
+
+double ProcessScanner::ProcessInfo::cpuSeconds() const noexcept
+{
+    static const auto ticksPerSecond = static_cast<double>(sysconf(_SC_CLK_TCK));
+    return static_cast<double>(cpuTicks) / ticksPerSecond;
+}
+
+ProcessScanner::ProcessScanner() noexcept
+    : m_procFd(open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC))
+{
+
+}
+
+ProcessScanner::~ProcessScanner()
+{
+    if (m_procFd != -1)
+    {
+        close(m_procFd);
+    }
+}
+
+std::vector<ProcessScanner::ProcessInfo> ProcessScanner::scan(ThreadPool* pool) const
+{
+    const auto pids = listPids();
+
+    auto scanRange = [this](const std::span<const pid_t> range)
+    {
+        std::vector<ProcessInfo> rows;
+        rows.reserve(range.size());
+        for (const auto pid : range)
+        {
+            if (auto info = read(pid))
+            {
+                rows.push_back(std::move(*info));
+            }
+        }
+        return rows;
+    };
+
+    std::vector<ProcessInfo> processes;
+    if (pool == nullptr || pids.size() < 2 * minShardSize)
+    {
+        processes = scanRange(pids);
+    }
+    else
+    {
+        const auto shardSize = std::max(minShardSize, pids.size() / pool->size());
+        std::vector<std::future<std::vector<ProcessInfo>>> pending;
+
+        for (size_t begin = 0; begin < pids.size(); begin += shardSize)
+        {
+            const auto shard = std::span(pids).subspan(begin, std::min(shardSize, pids.size() - begin));
+            pending.push_back(pool->submit([&scanRange, shard] { return scanRange(shard); }));
+        }
+
+        processes.reserve(pids.size());
+        for (auto& future : pending)
+        {
+            auto rows = future.get();
+            std::ranges::move(rows, std::back_inserter(processes));
+        }
+    }
+
+    std::ranges::sort(processes, {}, &ProcessInfo::pid);
+    return processes;
+}
+
+std::optional<ProcessScanner::ProcessInfo> ProcessScanner::read(const pid_t pid) const
+{
+    // One buffer per scanning thread, reused for every process it reads.
+    thread_local std::array<char, scanBufferSize> buffer{};
+
+    ProcessInfo info;
+    info.pid = pid;
+
+    const auto stat = readProcFile(pid, "stat", buffer);
+    if (stat.empty() || !parseStat(stat, info))
+    {
+        return std::nullopt;
+    }
+
+    parseStatus(readProcFile(pid, "status", buffer), info);
+    return info;
+}
+
+std::vector<ProcessScanner::ThreadInfo> ProcessScanner::readThreads(const pid_t pid, const std::span<const pid_t> tids) const
+{
+    thread_local std::array<char, scanBufferSize> buffer{};
+    // status outgrows the scan buffer on machines with many CPUs or groups, and the switch counters come last.
+    thread_local std::vector<char> statusBuffer;
+
+    std::vector<ThreadInfo> threads;
+    std::array<char, 64> path{};
+    const auto* taskPath = makePath(path, pid, "task");
+    const int taskFd = taskPath != nullptr ? openat(m_procFd, taskPath, O_RDONLY | O_DIRECTORY | O_CLOEXEC) : -1;
+    if (taskFd == -1)
+    {
+        return threads;
+    }
+
+    threads.reserve(tids.size());
+    for (const auto tid : tids)
+    {
+        auto readFile = [&](const std::string_view file)
+        {
+            const auto* relative = makePath(path, tid, file);
+            return relative != nullptr ? readFileAt(taskFd, relative, buffer) : std::string_view{};
+        };
+
+        // The state follows the command name, which ends at the last ')'.
+        const auto stat = readFile("stat");
+        const auto nameEnd = stat.rfind(')');
+        if (nameEnd == std::string_view::npos || nameEnd + 2 >= stat.size())
+        {
+            continue;
+        }
+
+        ThreadInfo info;
+        info.tid = tid;
+        info.state = stat[nameEnd + 2];
+
+        // The kernel reports "0" when the thread is running or wchan is hidden.
+        if (const auto wchan = readFile("wchan"); !wchan.empty() && wchan != "0")
+        {
+            info.wchan.assign(wchan);
+        }
+
+        info.syscall = PlatformUtils::parseSyscall(readFile("syscall"));
+
+        const auto* statusPath = makePath(path, tid, "status");
+        const auto status = statusPath != nullptr ? readWholeFileAt(taskFd, statusPath, statusBuffer) : std::string_view{};
+        info.voluntarySwitches = statusCounter(status, "\nvoluntary_ctxt_switches:");
+        info.involuntarySwitches = statusCounter(status, "\nnonvoluntary_ctxt_switches:");
+
+        // schedstat: nanoseconds on the CPU, nanoseconds waiting on a run queue, timeslices.
+        auto schedstat = readFile("schedstat");
+        uint64_t runNs = 0;
+        uint64_t waitNs = 0;
+        if (parseNumber(schedstat, runNs) && parseNumber(schedstat, waitNs))
+        {
+            info.runTime = std::chrono::nanoseconds(runNs);
+            info.runQueueTime = std::chrono::nanoseconds(waitNs);
+        }
+        threads.push_back(std::move(info));
+    }
+
+    close(taskFd);
+    return threads;
+}
+
+void ProcessScanner::sort(const std::span<ProcessInfo> processes, const SortKey key, const bool descending) noexcept
+{
+    auto order = [descending](const auto& lhs, const auto& rhs)
+    {
+        return descending ? rhs < lhs : lhs < rhs;
+    };
+
+    auto byKey = [&](const ProcessInfo& lhs, const ProcessInfo& rhs)
+    {
+        switch (key)
+        {
+            case SortKey::Parent:  return order(std::tie(lhs.parentPid, lhs.pid), std::tie(rhs.parentPid, rhs.pid));
+            case SortKey::Name:    return order(std::tie(lhs.name, lhs.pid), std::tie(rhs.name, rhs.pid));
+            case SortKey::State:   return order(std::tie(lhs.state, lhs.pid), std::tie(rhs.state, rhs.pid));
+            case SortKey::Threads: return order(std::tie(lhs.threads, lhs.pid), std::tie(rhs.threads, rhs.pid));
+            case SortKey::Rss:     return order(std::tie(lhs.rssBytes, lhs.pid), std::tie(rhs.rssBytes, rhs.pid));
+            case SortKey::Cpu:     return order(std::tie(lhs.cpuTicks, lhs.pid), std::tie(rhs.cpuTicks, rhs.pid));
+            case SortKey::Pid:     break;
+        }
+        return order(lhs.pid, rhs.pid);
+    };
+
+    std::ranges::sort(processes, byKey);
+}
+
+std::optional<ProcessScanner::SortKey> ProcessScanner::parseSortKey(const std::string_view name) noexcept
+{
+    if (name == "pid") return SortKey::Pid;
+    if (name == "ppid") return SortKey::Parent;
+    if (name == "name") return SortKey::Name;
+    if (name == "state") return SortKey::State;
+    if (name == "threads") return SortKey::Threads;
+    if (name == "rss") return SortKey::Rss;
+    if (name == "cpu") return SortKey::Cpu;
+    return std::nullopt;
+}
+
+std::vector<pid_t> ProcessScanner::listPids() const
+{
+    std::vector<pid_t> pids;
+    if (m_procFd == -1)
+    {
+        return pids;
+    }
+
+    const int dirFd = openat(m_procFd, ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd == -1)
+    {
+        return pids;
+    }
+
+    alignas(Dirent64) std::array<char, 32 * 1024> buffer{};
+    while (true)
+    {
+        const auto read = syscall(SYS_getdents64, dirFd, buffer.data(), buffer.size());
+        if (read <= 0)
+        {
+            break;
+        }
+
+        for (long offset = 0; offset < read;)
+        {
+            const auto* entry = reinterpret_cast<const Dirent64*>(buffer.data() + offset);
+            offset += entry->length;
+
+            if (entry->type != DT_DIR)
+            {
+                continue;
+            }
+
+            const char* name = entry->name;
+            pid_t pid = 0;
+            const auto [ptr, ec] = std::from_chars(name, name + std::strlen(name), pid);
+            if (ec == std::errc() && *ptr == '\0')
+            {
+                pids.push_back(pid);
+            }
+        }
+    }
+
+    close(dirFd);
+    return pids;
+}
+
+std::string_view ProcessScanner::readProcFile(const pid_t pid, const std::string_view file, const std::span<char> buffer) const noexcept
+{
+    std::array<char, 64> path{};
+    const auto* relative = makePath(path, pid, file);
+    return relative != nullptr ? readFileAt(m_procFd, relative, buffer) : std::string_view{};
+}
@@ -0,0 +1,305 @@
+#include "ProfileWriter.h"
+#include "PlatformUtils.h"
+#include <array>
+#include <format>
+#include <iterator>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/// @brief Anonymous namespace
+namespace
+{
+    /// @brief Field numbers of the pprof profile.proto messages. \namespace Pprof
+    namespace Pprof
+    {
+        constexpr uint32_t profileSampleType = 1;
+        constexpr uint32_t profileSample = 2;
+        constexpr uint32_t profileLocation = 4;
+        constexpr uint32_t profileFunction = 5;
+        constexpr uint32_t profileStringTable = 6;
+        constexpr uint32_t profilePeriodType = 11;
+        constexpr uint32_t profilePeriod = 12;
+
+        constexpr uint32_t valueTypeType = 1;
+        constexpr uint32_t valueTypeUnit = 2;
+
+        constexpr uint32_t sampleLocationId = 1;
+        constexpr uint32_t sampleValue = 2;
+
+        constexpr uint32_t locationId = 1;
+        constexpr uint32_t locationAddress = 3;
+        constexpr uint32_t locationLine = 4;
+
+        constexpr uint32_t lineFunctionId = 1;
+        constexpr uint32_t lineLine = 2;
+
+        constexpr uint32_t functionId = 1;
+        constexpr uint32_t functionName = 2;
+        constexpr uint32_t functionSystemName = 3;
+        constexpr uint32_t functionFilename = 4;
+    }
+
+    constexpr uint32_t wireVarint = 0;
+    constexpr uint32_t wireLengthDelimited = 2;
+
+    void putVarint(std::string& out, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    void putUint(std::string& out, const uint32_t field, const uint64_t value)
+    {
+        putVarint(out, (static_cast<uint64_t>(field) << 3) | wireVarint);
+        putVarint(out, value);
+    }
+
+    void putBytes(std::string& out, const uint32_t field, const std::string_view bytes)
+    {
+        putVarint(out, (static_cast<uint64_t>(field) << 3) | wireLengthDelimited);
+        putVarint(out, bytes.size());
+        out.append(bytes);
+    }
+
+    void putPacked(std::string& out, std::string& scratch, const uint32_t field, const std::span<const uint64_t> values)
+    {
+        scratch.clear();
+        for (const auto value : values)
+        {
+            putVarint(scratch, value);
+        }
+        putBytes(out, field, scratch);
+    }
+
+    /// @brief MessageStream writes top-level length-delimited fields straight to the output, reusing one encode buffer. \class MessageStream
+    class MessageStream
+    {
+    public:
+        explicit MessageStream(std::ostream& os) noexcept
+            : m_os(os)
+        {
+        }
+
+        std::string& begin() noexcept
+        {
+            m_body.clear();
+            return m_body;
+        }
+
+        void end(const uint32_t field)
+        {
+            m_header.clear();
+            putVarint(m_header, (static_cast<uint64_t>(field) << 3) | wireLengthDelimited);
+            putVarint(m_header, m_body.size());
+            m_os.write(m_header.data(), static_cast<std::streamsize>(m_header.size()));
+            m_os.write(m_body.data(), static_cast<std::streamsize>(m_body.size()));
+        }
+
+        void writeUint(const uint32_t field, const uint64_t value)
+        {
+            m_header.clear();
+            putUint(m_header, field, value);
+            m_os.write(m_header.data(), static_cast<std::streamsize>(m_header.size()));
+        }
+
+        std::string& scratch() noexcept
+        {
+            return m_scratch;
+        }
+
+    private:
+        std::ostream& m_os;
+        std::string m_header;
+        std::string m_body;
+        std::string m_scratch;
+    };
+
+    /// @brief StringTable interns the views handed to it; they must outlive the table. \class StringTable
+    class StringTable
+    {
+    public:
+        StringTable()
+        {
+            static_cast<void>(intern(""));
+        }
+
+        [[nodiscard]] uint64_t intern(const std::string_view text)
+        {
+            const auto [it, inserted] = m_ids.try_emplace(text, m_strings.size());
+            if (inserted)
+            {
+                m_strings.push_back(text);
+            }
+            return it->second;
+        }
+
+        [[nodiscard]] const std::vector<std::string_view>& strings() const noexcept
+        {
+            return m_strings;
+        }
+
+    private:
+        std::vector<std::string_view> m_strings;
+        std::unordered_map<std::string_view, uint64_t> m_ids;
+    };
+
+    /// @brief Location is one deduplicated call site of the pprof location table. \struct Location
+    struct Location
+    {
+        uint64_t address{0};
+        uint64_t functionId{0};
+        uint64_t line{0};
+    };
+
+    /// @brief Function is one deduplicated entry of the pprof function table. \struct Function
+    struct Function
+    {
+        uint64_t nameId{0};
+        uint64_t fileId{0};
+    };
+}
+
+void ProfileWriter::writeFolded(std::ostream& os, const StackProfile& profile)
+{
+    auto out = std::ostreambuf_iterator<char>(os);
+
+    for (const auto& [stack, count] : profile.stacks())
+    {
+        for (size_t i = stack.size(); i-- > 0;)
+        {
+            const auto* frame = profile.frameAt(stack, i);
+            if (frame != nullptr && frame->hasSymbolInfo())
+            {
+                os << frame->getFunctionName();
+            }
+            else
+            {
+                out = std::format_to(out, "0x{:x}", stack[i]);
+            }
+
+            if (i != 0)
+            {
+                os.put(';');
+            }
+        }
+        out = std::format_to(out, " {}\n", count);
+    }
+}
+
+void ProfileWriter::writePprof(std::ostream& os, const StackProfile& profile, const uint32_t frequency)
+{
+    const auto period = frequency != 0 ? 1'000'000'000ULL / frequency : 0ULL;
+
+    StringTable strings;
+    std::vector<Function> functions;
+    std::unordered_map<uint64_t, uint64_t> functionIds;
+    std::vector<Location> locations;
+    std::unordered_map<uintptr_t, uint64_t> locationIds;
+
+    auto locationFor = [&](const std::vector<uintptr_t>& stack, const size_t index)
+    {
+        const auto callSite = PlatformUtils::callSiteAddress(stack, index);
+        const auto [it, inserted] = locationIds.try_emplace(callSite, locations.size() + 1);
+        if (!inserted)
+        {
+            return it->second;
+        }
+
+        Location location{callSite, 0, 0};
+        if (const auto* frame = profile.frameAt(stack, index); frame != nullptr && frame->hasSymbolInfo())
+        {
+            // Interned ids identify a name and file pair without comparing strings.
+            const auto key = (uint64_t{frame->getFunctionId()} << 32) | frame->getSourceFileId();
+            const auto [fn, added] = functionIds.try_emplace(key, functions.size() + 1);
+            if (added)
+            {
+                functions.push_back(Function{strings.intern(frame->getFunctionName()), strings.intern(frame->getSourceFile())});
+            }
+            location.functionId = fn->second;
+            location.line = frame->getLineNumber();
+        }
+        locations.push_back(location);
+        return it->second;
+    };
+
+    MessageStream stream(os);
+
+    const std::array<std::pair<std::string_view, std::string_view>, 2> sampleTypes{{
+        {"samples", "count"},
+        {"cpu", "nanoseconds"}
+    }};
+    for (const auto& [type, unit] : sampleTypes)
+    {
+        auto& body = stream.begin();
+        putUint(body, Pprof::valueTypeType, strings.intern(type));
+        putUint(body, Pprof::valueTypeUnit, strings.intern(unit));
+        stream.end(Pprof::profileSampleType);
+    }
+
+    std::vector<uint64_t> ids;
+    for (const auto& [stack, count] : profile.stacks())
+    {
+        ids.clear();
+        for (size_t i = 0; i < stack.size(); ++i)
+        {
+            ids.push_back(locationFor(stack, i));
+        }
+
+        const std::array<uint64_t, 2> values{count, count * period};
+        auto& body = stream.begin();
+        putPacked(body, stream.scratch(), Pprof::sampleLocationId, ids);
+        putPacked(body, stream.scratch(), Pprof::sampleValue, values);
+        stream.end(Pprof::profileSample);
+    }
+
+    for (size_t i = 0; i < locations.size(); ++i)
+    {
+        const auto& location = locations[i];
+        auto& body = stream.begin();
+        putUint(body, Pprof::locationId, i + 1);
+        putUint(body, Pprof::locationAddress, location.address);
+
+        if (location.functionId != 0)
+        {
+            auto& line = stream.scratch();
+            line.clear();
+            putUint(line, Pprof::lineFunctionId, location.functionId);
+            putUint(line, Pprof::lineLine, location.line);
+            putBytes(body, Pprof::locationLine, line);
+        }
+        stream.end(Pprof::profileLocation);
+    }
+
+    for (size_t i = 0; i < functions.size(); ++i)
+    {
+        auto& body = stream.begin();
+        putUint(body, Pprof::functionId, i + 1);
+        putUint(body, Pprof::functionName, functions[i].nameId);
+        putUint(body, Pprof::functionSystemName, functions[i].nameId);
+        putUint(body, Pprof::functionFilename, functions[i].fileId);
+        stream.end(Pprof::profileFunction);
+    }
+
+    {
+        auto& body = stream.begin();
+        putUint(body, Pprof::valueTypeType, strings.intern("cpu"));
+        putUint(body, Pprof::valueTypeUnit, strings.intern("nanoseconds"));
+        stream.end(Pprof::profilePeriodType);
+    }
+    stream.writeUint(Pprof::profilePeriod, period);
+
+    for (const auto text : strings.strings())
+    {
+        auto& body = stream.begin();
+        body.append(text);
+        stream.end(Pprof::profileStringTable);
+    }
+}
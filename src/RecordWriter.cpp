@@ -0,0 +1,219 @@
+#include "RecordWriter.h"
+#include "StringInterner.h"
+#include <cstring>
+#include <format>
+#include <iterator>
+#include <vector>
+
+RecordWriter::RecordWriter(std::ostream& os, const Format format)
+    : m_outputStream(os)
+    , m_format(format)
+{
+    if (m_format == Format::Binary)
+    {
+        const BinaryFileHeader header{binaryMagic, binaryVersion, 0};
+        appendBinary(RecordType::FileHeader, std::as_bytes(std::span(&header, 1)));
+        flush();
+    }
+}
+
+void RecordWriter::write(const Record& record)
+{
+    const auto timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(record.timestamp.time_since_epoch()).count();
+
+    if (m_format == Format::Binary)
+    {
+        // Definitions go into the buffer ahead of the stack that refers to them.
+        std::vector<BinaryFrame> frames;
+        frames.reserve(record.frames.size());
+        for (const auto& frame : record.frames)
+        {
+            frames.push_back(BinaryFrame{
+                frame.getAddress(),
+                streamId(frame.getModuleId()),
+                streamId(frame.getFunctionId()),
+                streamId(frame.getSourceFileId()),
+                static_cast<uint32_t>(frame.getLineNumber())});
+        }
+
+        if (record.state != nullptr)
+        {
+            appendBinaryState(*record.state);
+        }
+
+        const BinaryStack stack{record.pid, record.tid, static_cast<uint64_t>(timestampNs), static_cast<uint32_t>(frames.size()), 0};
+        appendBinary(RecordType::Stack, std::as_bytes(std::span(&stack, 1)), std::as_bytes(std::span(frames)));
+        flush();
+        return;
+    }
+
+    std::vector<uint32_t> moduleIds;
+    moduleIds.reserve(record.frames.size());
+    for (const auto& frame : record.frames)
+    {
+        moduleIds.push_back(streamId(frame.getModuleId()));
+    }
+
+    auto out = std::back_inserter(m_buffer);
+    std::format_to(out, R"({{"type":"stack","pid":{},"tid":{},"timestamp_ns":{},"frames":[)", record.pid, record.tid, timestampNs);
+    for (size_t i = 0; i < record.frames.size(); ++i)
+    {
+        const auto& frame = record.frames[i];
+        std::format_to(out, R"({}{{"address":"0x{:x}","module":{})", i == 0 ? "" : ",", frame.getAddress(), moduleIds[i]);
+
+        if (frame.hasSymbolInfo())
+        {
+            m_buffer += R"(,"function":)";
+            appendJsonString(frame.getFunctionName());
+        }
+        if (!frame.getSourceFile().empty())
+        {
+            m_buffer += R"(,"file":)";
+            appendJsonString(frame.getSourceFile());
+            std::format_to(out, R"(,"line":{})", frame.getLineNumber());
+        }
+        m_buffer += '}';
+    }
+    m_buffer += ']';
+
+    if (record.state != nullptr)
+    {
+        appendJsonState(*record.state);
+    }
+    m_buffer += "}\n";
+    flush();
+}
+
+std::optional<RecordWriter::Format> RecordWriter::parseFormat(const std::string_view name) noexcept
+{
+    if (name == "jsonl")
+    {
+        return Format::JsonLines;
+    }
+    if (name == "binary")
+    {
+        return Format::Binary;
+    }
+    return std::nullopt;
+}
+
+uint32_t RecordWriter::streamId(const uint32_t internedId)
+{
+    if (internedId == StringInterner::emptyId)
+    {
+        return noString;
+    }
+
+    const auto [it, inserted] = m_stringIds.try_emplace(internedId, m_nextStringId);
+    if (!inserted)
+    {
+        return it->second;
+    }
+    ++m_nextStringId;
+
+    const auto text = StringInterner::instance().view(internedId);
+    if (m_format == Format::Binary)
+    {
+        const BinaryString definition{it->second, static_cast<uint32_t>(text.size())};
+        appendBinary(RecordType::String, std::as_bytes(std::span(&definition, 1)), std::as_bytes(std::span(text)));
+    }
+    else
+    {
+        std::format_to(std::back_inserter(m_buffer), R"({{"type":"module","id":{},"path":)", it->second);
+        appendJsonString(text);
+        m_buffer += "}\n";
+    }
+    return it->second;
+}
+
+void RecordWriter::appendJsonString(const std::string_view text)
+{
+    m_buffer += '"';
+    for (const char c : text)
+    {
+        switch (c)
+        {
+            case '"':  m_buffer += "\\\""; break;
+            case '\\': m_buffer += "\\\\"; break;
+            case '\n': m_buffer += "\\n"; break;
+            case '\t': m_buffer += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    std::format_to(std::back_inserter(m_buffer), "\\u{:04x}", static_cast<unsigned>(c));
+                }
+                else
+                {
+                    m_buffer += c;
+                }
+        }
+    }
+    m_buffer += '"';
+}
+
+void RecordWriter::appendJsonState(const ProcessScanner::ThreadInfo& state)
+{
+    auto out = std::back_inserter(m_buffer);
+    std::format_to(out, R"(,"state":{{"code":"{}")", state.state);
+    if (!state.wchan.empty())
+    {
+        m_buffer += R"(,"wchan":)";
+        appendJsonString(state.wchan);
+    }
+    if (state.syscall)
+    {
+        std::format_to(out, R"(,"syscall":{})", state.syscall->number);
+        if (state.syscall->number != StackSnapshot::notInSyscall)
+        {
+            const auto& args = state.syscall->args;
+            std::format_to(out, R"(,"syscall_args":["0x{:x}","0x{:x}","0x{:x}","0x{:x}","0x{:x}","0x{:x}"])",
+                args[0], args[1], args[2], args[3], args[4], args[5]);
+        }
+    }
+    std::format_to(out, R"(,"voluntary_switches":{},"involuntary_switches":{},"run_ns":{},"runqueue_ns":{}}})",
+        state.voluntarySwitches, state.involuntarySwitches, state.runTime.count(), state.runQueueTime.count());
+}
+
+void RecordWriter::appendBinaryState(const ProcessScanner::ThreadInfo& state)
+{
+    BinaryThreadState binary;
+    binary.tid = state.tid;
+    binary.state = state.state;
+    binary.wchanId = state.wchan.empty() ? noString : streamId(StringInterner::instance().intern(state.wchan));
+    binary.syscall = state.syscall ? state.syscall->number : unknownSyscall;
+    if (state.syscall)
+    {
+        binary.syscallArgs = state.syscall->args;
+    }
+    binary.voluntarySwitches = state.voluntarySwitches;
+    binary.involuntarySwitches = state.involuntarySwitches;
+    binary.runNs = static_cast<uint64_t>(state.runTime.count());
+    binary.runQueueNs = static_cast<uint64_t>(state.runQueueTime.count());
+    appendBinary(RecordType::ThreadState, std::as_bytes(std::span(&binary, 1)));
+}
+
+void RecordWriter::appendBinary(const RecordType type, const std::span<const std::byte> payload, const std::span<const std::byte> tail)
+{
+    constexpr size_t alignment = 8;
+    const auto unpadded = sizeof(BinaryHeader) + payload.size() + tail.size();
+    const auto length = (unpadded + alignment - 1) / alignment * alignment;
+
+    const BinaryHeader header{static_cast<uint32_t>(length), type, 0};
+    const auto offset = m_buffer.size();
+    m_buffer.resize(offset + length, '\0');
+
+    auto* destination = m_buffer.data() + offset;
+    std::memcpy(destination, &header, sizeof(header));
+    std::memcpy(destination + sizeof(header), payload.data(), payload.size());
+    if (!tail.empty())
+    {
+        std::memcpy(destination + sizeof(header) + payload.size(), tail.data(), tail.size());
+    }
+}
+
+void RecordWriter::flush()
+{
+    m_outputStream.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+    m_outputStream.flush();
+    m_buffer.clear();
+}
@@ -0,0 +1,218 @@
+#include "SelfTrace.h"
+#include "PlatformUtils.h"
+#include <algorithm>
+#include <array>
+#include <unwind.h>
+#include <unistd.h>
+
+/// @brief Anonymous namespace
+namespace
+{
+    /// @brief BacktraceState is the output of one walk of the unwinder. \struct BacktraceState
+    struct BacktraceState
+    {
+        std::span<uintptr_t> addresses;
+        size_t skip{0};
+        size_t count{0};
+    };
+
+    _Unwind_Reason_Code collectFrame(_Unwind_Context* context, void* argument)
+    {
+        auto& state = *static_cast<BacktraceState*>(argument);
+        const auto address = static_cast<uintptr_t>(_Unwind_GetIP(context));
+        if (address == 0 || state.count == state.addresses.size())
+        {
+            return _URC_END_OF_STACK;
+        }
+
+        if (state.skip > 0)
+        {
+            --state.skip;
+            return _URC_NO_REASON;
+        }
+
+        // Relaxed atomic stores, so readers copying a slot under its seqlock never race with the write.
+        std::atomic_ref(state.addresses[state.count++]).store(address, std::memory_order_relaxed);
+        return _URC_NO_REASON;
+    }
+}
+
+// Everything the unwinder touches besides _dl_find_object lives on this stack; prepare() makes sure libgcc is loaded
+// before a signal can arrive.
+[[gnu::noinline]] size_t SelfTrace::captureInto(const std::span<uintptr_t> addresses, const size_t skip) noexcept
+{
+    // The first frame reported is this function.
+    BacktraceState state{addresses, skip + 1, 0};
+    _Unwind_Backtrace(collectFrame, &state);
+    return state.count;
+}
+
+void SelfTrace::prepare() noexcept
+{
+    std::array<uintptr_t, 4> addresses{};
+    static_cast<void>(captureInto(addresses));
+}
+
+SelfTrace::SelfTrace(const size_t slots, const size_t maxFrames)
+    : m_slotCount(std::max<size_t>(slots, 1))
+    , m_maxFrames(std::max<size_t>(maxFrames, 1))
+    , m_slots(std::make_unique<Slot[]>(m_slotCount))
+    , m_addresses(std::make_unique_for_overwrite<uintptr_t[]>(m_slotCount * m_maxFrames))
+{
+    prepare();
+}
+
+[[gnu::noinline]] SelfTrace::Handle SelfTrace::capture(const size_t skip) noexcept
+{
+    const auto ticket = m_nextTicket.fetch_add(1, std::memory_order_relaxed);
+    const auto index = ticket % m_slotCount;
+    auto& slot = m_slots[index];
+
+    // Never wait for the slot: the writer holding it may be the very code this signal handler interrupted.
+    auto current = slot.ticket.load(std::memory_order_relaxed);
+    do
+    {
+        if ((current & writingBit) != 0 || current > ticket)
+        {
+            return Handle{};
+        }
+    }
+    while (!slot.ticket.compare_exchange_weak(current, ticket | writingBit, std::memory_order_relaxed));
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const auto count = captureInto(std::span(&m_addresses[index * m_maxFrames], m_maxFrames), skip + 1);
+    slot.count.store(static_cast<uint32_t>(count), std::memory_order_relaxed);
+    slot.ticket.store(ticket, std::memory_order_release);
+    return Handle{ticket};
+}
+
+std::vector<uintptr_t> SelfTrace::addresses(const Handle handle) const
+{
+    if (!handle.valid())
+    {
+        return {};
+    }
+
+    const auto index = handle.ticket % m_slotCount;
+    const auto& slot = m_slots[index];
+    if (slot.ticket.load(std::memory_order_acquire) != handle.ticket)
+    {
+        return {};
+    }
+
+    const auto count = std::min<size_t>(slot.count.load(std::memory_order_relaxed), m_maxFrames);
+    std::vector<uintptr_t> stack(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        stack[i] = std::atomic_ref(m_addresses[index * m_maxFrames + i]).load(std::memory_order_relaxed);
+    }
+
+    // A capture that reused the slot during the copy has changed the ticket; its half-written stack is dropped.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.ticket.load(std::memory_order_relaxed) != handle.ticket)
+    {
+        return {};
+    }
+    return stack;
+}
+
+std::vector<StackFrame> SelfTrace::symbolize(const Handle handle, ThreadPool* pool)
+{
+    return symbolize(addresses(handle), pool);
+}
+
+std::vector<std::vector<StackFrame>> SelfTrace::symbolize(const std::span<const Handle> handles, ThreadPool* pool)
+{
+    // Stacks are copied out first; only the copies are resolved and read.
+    std::vector<std::vector<uintptr_t>> copies;
+    copies.reserve(handles.size());
+    for (const auto handle : handles)
+    {
+        copies.push_back(addresses(handle));
+    }
+
+    std::vector<std::span<const uintptr_t>> stacks(copies.begin(), copies.end());
+
+    const std::scoped_lock lock(m_mutex);
+    resolvePending(stacks, pool);
+
+    std::vector<std::vector<StackFrame>> result;
+    result.reserve(stacks.size());
+    for (const auto stack : stacks)
+    {
+        result.push_back(framesOf(stack));
+    }
+    return result;
+}
+
+std::vector<StackFrame> SelfTrace::symbolize(const std::span<const uintptr_t> stack, ThreadPool* pool)
+{
+    const std::scoped_lock lock(m_mutex);
+    resolvePending(std::span(&stack, 1), pool);
+    return framesOf(stack);
+}
+
+void SelfTrace::resolvePending(const std::span<const std::span<const uintptr_t>> stacks, ThreadPool* pool)
+{
+    std::vector<uintptr_t> pending;
+    for (const auto stack : stacks)
+    {
+        for (size_t i = 0; i < stack.size(); ++i)
+        {
+            const auto callSite = PlatformUtils::callSiteAddress(stack, i);
+            if (!m_frames.contains(callSite))
+            {
+                pending.push_back(callSite);
+            }
+        }
+    }
+
+    if (pending.empty())
+    {
+        return;
+    }
+
+    std::ranges::sort(pending);
+    const auto [first, last] = std::ranges::unique(pending);
+    pending.erase(first, last);
+
+    // The map is re-read when a call site lies outside it, i.e. in a library loaded since the last read.
+    const bool stale = !m_modules || std::ranges::any_of(pending, [this](const uintptr_t address)
+    {
+        return m_modules->find(address) == nullptr;
+    });
+    if (stale)
+    {
+        if (auto modules = ModuleMap::read(getpid()))
+        {
+            m_modules = std::move(*modules);
+        }
+    }
+
+    if (!m_modules)
+    {
+        for (const auto address : pending)
+        {
+            m_frames.emplace(address, StackFrame(address));
+        }
+        return;
+    }
+
+    auto resolved = PlatformUtils::resolveModuleAddresses(*m_modules, pending, pool);
+    for (size_t i = 0; i < pending.size(); ++i)
+    {
+        m_frames.emplace(pending[i], std::move(resolved[i]));
+    }
+}
+
+std::vector<StackFrame> SelfTrace::framesOf(const std::span<const uintptr_t> stack) const
+{
+    std::vector<StackFrame> frames;
+    frames.reserve(stack.size());
+    for (size_t i = 0; i < stack.size(); ++i)
+    {
+        frames.push_back(m_frames.at(PlatformUtils::callSiteAddress(stack, i)));
+        frames.back().setAddress(stack[i]);
+    }
+    return frames;
+}
@@ -1,31 +1,40 @@
 #include "StackFrame.h"
-#include <utility>
 
 StackFrame::StackFrame(
     const std::uintptr_t addr,
-    std::string func,
-    std::string file,
+    const std::string_view func,
+    const std::string_view file,
     const size_t line
-) noexcept
+)
     : m_address(addr)
-    , m_functionName(std::move(func))
-    , m_sourceFile(std::move(file))
-    , m_lineNumber(line)
+    , m_functionId(StringInterner::instance().intern(func))
+    , m_fileId(StringInterner::instance().intern(file))
+    , m_lineNumber(static_cast<uint32_t>(line))
 {
 
 }
 
-void StackFrame::setFunctionName(std::string name) noexcept
+void StackFrame::setAddress(const std::uintptr_t addr) noexcept
 {
-    m_functionName = std::move(name);
+    m_address = addr;
 }
 
-void StackFrame::setSourceFile(std::string file) noexcept
+void StackFrame::setFunctionName(const std::string_view name)
 {
-    m_sourceFile = std::move(file);
+    m_functionId = StringInterner::instance().intern(name);
+}
+
+void StackFrame::setSourceFile(const std::string_view file)
+{
+    m_fileId = StringInterner::instance().intern(file);
+}
+
+void StackFrame::setModule(const std::string_view path)
+{
+    m_moduleId = StringInterner::instance().intern(path);
 }
 
 void StackFrame::setLineNumber(const std::size_t line) noexcept
 {
-    m_lineNumber = line;
+    m_lineNumber = static_cast<uint32_t>(line);
 }
@@ -0,0 +1,98 @@
+#include "StackProfile.h"
+#include "PlatformUtils.h"
+#include <algorithm>
+
+size_t StackProfile::AddressHash::operator()(const std::span<const uintptr_t> stack) const noexcept
+{
+    // FNV-1a over the words; the addresses are already well distributed.
+    uint64_t hash = 14695981039346656037ULL;
+    for (const auto address : stack)
+    {
+        hash ^= address;
+        hash *= 1099511628211ULL;
+    }
+    return static_cast<size_t>(hash);
+}
+
+const std::vector<uintptr_t>& StackProfile::add(const std::span<const uintptr_t> stack, const uint64_t count)
+{
+    m_totalSamples += count;
+
+    thread_local std::vector<uintptr_t> key;
+    key.assign(stack.begin(), stack.end());
+
+    if (const auto it = m_stacks.find(key); it != m_stacks.end())
+    {
+        it->second += count;
+        return it->first;
+    }
+    return m_stacks.emplace(key, count).first->first;
+}
+
+std::vector<const StackProfile::StackCounts::value_type*> StackProfile::sortedByCount() const
+{
+    std::vector<const StackCounts::value_type*> sorted;
+    sorted.reserve(m_stacks.size());
+    for (const auto& entry : m_stacks)
+    {
+        sorted.push_back(&entry);
+    }
+
+    std::ranges::sort(sorted, [](const auto* lhs, const auto* rhs)
+    {
+        return lhs->second != rhs->second ? lhs->second > rhs->second : lhs->first < rhs->first;
+    });
+    return sorted;
+}
+
+void StackProfile::symbolize(const ModuleMap& modules, ThreadPool* pool)
+{
+    std::vector<uintptr_t> pending;
+    for (const auto& [stack, count] : m_stacks)
+    {
+        for (size_t i = 0; i < stack.size(); ++i)
+        {
+            const auto address = PlatformUtils::callSiteAddress(stack, i);
+            if (!m_frames.contains(address))
+            {
+                pending.push_back(address);
+            }
+        }
+    }
+
+    std::ranges::sort(pending);
+    const auto [first, last] = std::ranges::unique(pending);
+    pending.erase(first, last);
+
+    auto resolved = PlatformUtils::resolveModuleAddresses(modules, pending, pool);
+    for (size_t i = 0; i < pending.size(); ++i)
+    {
+        m_frames.emplace(pending[i], std::move(resolved[i]));
+    }
+}
+
+std::vector<StackFrame> StackProfile::frames(const std::span<const uintptr_t> stack) const
+{
+    std::vector<StackFrame> result;
+    result.reserve(stack.size());
+
+    for (size_t i = 0; i < stack.size(); ++i)
+    {
+        if (const auto* frame = frameAt(stack, i))
+        {
+            result.push_back(*frame);
+            result.back().setAddress(stack[i]);
+        }
+        else
+        {
+            result.emplace_back(stack[i]);
+        }
+    }
+    return result;
+}
+
+const StackFrame* StackProfile::frameAt(const std::span<const uintptr_t> stack, const size_t index) const
+{
+    const auto it = m_frames.find(PlatformUtils::callSiteAddress(stack, index));
+    return it != m_frames.end() ? &it->second : nullptr;
+}
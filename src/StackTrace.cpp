@@ -1,10 +1,21 @@
 #include "StackTrace.h"
+#include "PerfSampler.h"
 #include "PlatformUtils.h"
+#include "SelfTrace.h"
+#include "ThreadGroups.h"
+#include "ThreadPool.h"
 #include <algorithm>
+#include <future>
 #include <ranges>
+#include <thread>
+#include <unistd.h>
 
 StackTrace::StackTrace(const size_t maxDepth) noexcept
     : m_maxDepth(maxDepth)
+    , m_stackSnapshotBytes(PlatformUtils::defaultStackSnapshotBytes)
+    , m_unwindMethod(Unwinder::Method::Dwarf)
+    , m_samplingBackend(SamplingBackend::Ptrace)
+    , m_perfStackBytes(PerfSampler::defaultStackBytes)
 {
 
 }
@@ -14,69 +25,390 @@ void StackTrace::setMaxDepth(const size_t depth) noexcept
     m_maxDepth = depth;
 }
 
+void StackTrace::setStackSnapshotSize(const size_t bytes) noexcept
+{
+    m_stackSnapshotBytes = bytes;
+    m_perfStackBytes = std::min(bytes, PerfSampler::maxStackBytes);
+}
+
+void StackTrace::setUnwindMethod(const Unwinder::Method method) noexcept
+{
+    m_unwindMethod = method;
+}
+
+void StackTrace::setSamplingBackend(const SamplingBackend backend) noexcept
+{
+    m_samplingBackend = backend;
+}
+
 std::vector<StackFrame> StackTrace::captureCurrentThread() const
 {
-    const auto st = std::stacktrace::current();
-    return convertStackTrace(st);
+    std::vector<uintptr_t> addresses(m_maxDepth);
+    addresses.resize(SelfTrace::captureInto(addresses));
+    return PlatformUtils::resolveProcessAddresses(getpid(), addresses);
 }
 
-std::expected<std::vector<StackFrame>, StackTrace::Error> StackTrace::captureProcess(const pid_t pid) const
+std::expected<std::vector<StackFrame>, StackTrace::Error> StackTrace::captureProcess(const pid_t pid, CaptureStats* stats) const
 {
     if (!PlatformUtils::isProcessRunning(pid))
     {
         return std::unexpected(Error::ProcessNotRunning);
     }
 
-    if (!PlatformUtils::attachToProcess(pid))
+    const auto modules = ModuleMap::read(pid);
+    if (!modules)
+    {
+        return std::unexpected(Error::CaptureFailed);
+    }
+
+    const auto capture = captureRaw(pid, *modules);
+    if (!capture)
+    {
+        return std::unexpected(capture.error());
+    }
+
+    if (stats != nullptr)
+    {
+        stats->record(capture->stopDuration);
+    }
+
+    // The target is already running again; symbolization is a separate stage.
+    return PlatformUtils::resolveProcessAddresses(*modules, capture->addresses, &ThreadPool::shared());
+}
+
+std::expected<StackTrace::RawCapture, StackTrace::Error> StackTrace::captureRaw(const pid_t pid, const ModuleMap& modules) const
+{
+    using Clock = std::chrono::steady_clock;
+    const auto stopStart = Clock::now();
+
+    const auto stopped = PlatformUtils::stopThread(pid);
+    if (!stopped)
     {
-        return std::unexpected(Error::AttachFailed);
+        return std::unexpected(PlatformUtils::isProcessRunning(pid) ? Error::AttachFailed : Error::ProcessNotRunning);
     }
 
-    auto frames = PlatformUtils::readProcessStack(pid);
-    PlatformUtils::detachFromProcess(pid);
+    // Only registers and raw stack bytes are copied while the target is stopped.
+    const auto snapshot = PlatformUtils::captureStackSnapshot(pid, m_stackSnapshotBytes, &modules);
+    PlatformUtils::releaseThreads(std::span(&*stopped, 1));
+    const auto stopDuration = Clock::now() - stopStart;
 
-    if (frames.empty())
+    if (!snapshot)
     {
         return std::unexpected(Error::CaptureFailed);
     }
 
-    if (frames.size() > m_maxDepth)
+    RawCapture capture;
+    capture.addresses = Unwinder::unwind(*snapshot, modules, m_unwindMethod, m_maxDepth);
+    capture.stopDuration = std::chrono::duration_cast<std::chrono::nanoseconds>(stopDuration);
+    return capture;
+}
+
+std::expected<StackProfile, StackTrace::Error> StackTrace::sampleProcess(
+    const pid_t pid,
+    const uint32_t frequency,
+    const std::chrono::milliseconds duration,
+    CaptureStats* stats,
+    const SampleCallback& onSample) const
+{
+    if (!PlatformUtils::isProcessRunning(pid))
+    {
+        return std::unexpected(Error::ProcessNotRunning);
+    }
+
+    const auto modules = ModuleMap::read(pid);
+    if (!modules || frequency == 0)
     {
-        frames.resize(m_maxDepth);
+        return std::unexpected(Error::CaptureFailed);
     }
 
-    return frames;
+    // Clamped so the interval below never truncates to zero and turns the loop into a busy wait.
+    const auto rate = std::min(frequency, maxSampleFrequency);
+    if (m_samplingBackend == SamplingBackend::Perf)
+    {
+        auto profile = samplePerf(pid, *modules, rate, duration, stats, onSample);
+        if (profile && !onSample)
+        {
+            profile->symbolize(*modules, &ThreadPool::shared());
+        }
+        return profile;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    const auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::seconds(1)) / rate;
+    auto next = Clock::now();
+    const auto end = next + duration;
+
+    StackProfile profile;
+    size_t samples = 0;
+    while (next < end)
+    {
+        const auto capture = captureRaw(pid, *modules);
+        if (capture)
+        {
+            ++samples;
+            if (onSample)
+            {
+                onSample(pid, capture->addresses);
+            }
+            else
+            {
+                profile.add(capture->addresses);
+            }
+            if (stats != nullptr)
+            {
+                stats->record(capture->stopDuration);
+            }
+        }
+        else if (capture.error() == Error::ProcessNotRunning)
+        {
+            break;
+        }
+
+        // Ticks missed because a capture overran are dropped rather than bunched up.
+        next = std::max(next + interval, Clock::now());
+        std::this_thread::sleep_until(next);
+    }
+
+    if (samples == 0)
+    {
+        return std::unexpected(Error::CaptureFailed);
+    }
+
+    if (!onSample)
+    {
+        profile.symbolize(*modules, &ThreadPool::shared());
+    }
+    return profile;
 }
 
-std::string StackTrace::errorToString(const Error error) noexcept
+std::expected<StackProfile, StackTrace::Error> StackTrace::samplePerf(
+    const pid_t pid,
+    const ModuleMap& modules,
+    const uint32_t frequency,
+    const std::chrono::milliseconds duration,
+    CaptureStats* stats,
+    const SampleCallback& onSample) const
 {
-    switch (error)
+    const auto stackBytes = m_unwindMethod == Unwinder::Method::Dwarf ? m_perfStackBytes : 0;
+    auto sampler = PerfSampler::open(pid, frequency, stackBytes, m_maxDepth);
+    if (!sampler)
     {
-        case Error::ProcessNotRunning: return "Process is not running";
-        case Error::AttachFailed: return "Failed to attach to process";
-        case Error::DetachFailed: return "Failed to detach from process";
-        case Error::CaptureFailed: return "Failed to capture stack trace";
+        return std::unexpected(PlatformUtils::isProcessRunning(pid) ? Error::PerfUnavailable : Error::ProcessNotRunning);
     }
-    return "Unknown error";
+
+    StackProfile profile;
+    size_t samples = 0;
+    const auto addSample = [&](const pid_t tid, const std::span<const uintptr_t> stack)
+    {
+        ++samples;
+        if (onSample)
+        {
+            onSample(tid, stack);
+        }
+        else
+        {
+            profile.add(stack);
+        }
+    };
+
+    const auto drainSample = [&](const PerfSampler::Sample& sample)
+    {
+        const auto callchain = sample.callchain.first(std::min(sample.callchain.size(), m_maxDepth));
+        if (sample.snapshot == nullptr)
+        {
+            addSample(sample.tid, callchain);
+            return;
+        }
+
+        // Keep the kernel's callchain where the stack copy was too short to unwind further.
+        const auto unwound = Unwinder::unwind(*sample.snapshot, modules, Unwinder::Method::Dwarf, m_maxDepth);
+        addSample(sample.tid, unwound.size() >= sample.callchain.size() ? std::span<const uintptr_t>(unwound) : callchain);
+    };
+
+    using Clock = std::chrono::steady_clock;
+    const auto end = Clock::now() + duration;
+    constexpr auto drainInterval = std::chrono::milliseconds(100);
+
+    sampler->setEnabled(true);
+    for (auto now = Clock::now(); now < end && PlatformUtils::isProcessRunning(pid); now = Clock::now())
+    {
+        sampler->wait(std::min(drainInterval, std::chrono::ceil<std::chrono::milliseconds>(end - now)));
+        sampler->drain(drainSample);
+    }
+    sampler->setEnabled(false);
+    sampler->drain(drainSample);
+
+    if (stats != nullptr)
+    {
+        stats->lostSamples += sampler->lostSamples();
+        stats->unsampledThreads += sampler->unsampledThreads();
+    }
+
+    if (samples == 0)
+    {
+        return std::unexpected(Error::CaptureFailed);
+    }
+    return profile;
+}
+
+std::expected<std::vector<StackTrace::ThreadStack>, StackTrace::Error> StackTrace::captureAllThreads(const pid_t pid, CaptureStats* stats) const
+{
+    const auto modules = ModuleMap::read(pid);
+    if (!modules)
+    {
+        return std::unexpected(PlatformUtils::isProcessRunning(pid) ? Error::CaptureFailed : Error::ProcessNotRunning);
+    }
+
+    // Scheduler state is read in one batch right before the stop; a stopped thread would only show as traced.
+    const ProcessScanner scanner;
+    auto states = scanner.readThreads(pid, PlatformUtils::listThreads(pid));
+    std::ranges::sort(states, {}, &ProcessScanner::ThreadInfo::tid);
+
+    const auto threads = captureThreadAddresses(pid, *modules, stats);
+    if (!threads)
+    {
+        return std::unexpected(threads.error());
+    }
+
+    // Symbolize through the groups so threads parked in the same stack are resolved once.
+    ThreadGroups groups;
+    for (const auto& thread : *threads)
+    {
+        groups.add(thread.tid, thread.addresses);
+    }
+    groups.symbolize(*modules, &ThreadPool::shared());
+
+    std::vector<ThreadStack> stacks;
+    stacks.reserve(threads->size());
+    for (const auto& thread : *threads)
+    {
+        ThreadStack stack{thread.tid, PlatformUtils::getThreadName(pid, thread.tid).value_or(""), groups.frames(thread.addresses), {}};
+
+        const auto state = std::ranges::lower_bound(states, thread.tid, {}, &ProcessScanner::ThreadInfo::tid);
+        if (state != states.end() && state->tid == thread.tid)
+        {
+            stack.state = std::move(*state);
+        }
+        stack.state.tid = thread.tid;
+
+        // The registers taken during the stop are exact where /proc could only see the thread running.
+        if (thread.syscall)
+        {
+            stack.state.syscall = thread.syscall;
+        }
+        stacks.push_back(std::move(stack));
+    }
+    return stacks;
 }
 
-std::vector<StackFrame> StackTrace::convertStackTrace(const std::stacktrace& st) const
+std::expected<ThreadGroups, StackTrace::Error> StackTrace::captureThreadGroups(const pid_t pid, CaptureStats* stats) const
 {
-    std::vector<StackFrame> frames;
-    const auto stSize = static_cast<std::size_t>(st.size());
-    const auto limit = std::min(stSize, m_maxDepth);
-    frames.reserve(limit);
+    const auto modules = ModuleMap::read(pid);
+    if (!modules)
+    {
+        return std::unexpected(PlatformUtils::isProcessRunning(pid) ? Error::CaptureFailed : Error::ProcessNotRunning);
+    }
+
+    const auto threads = captureThreadAddresses(pid, *modules, stats);
+    if (!threads)
+    {
+        return std::unexpected(threads.error());
+    }
+
+    ThreadGroups groups;
+    for (const auto& thread : *threads)
+    {
+        groups.add(thread.tid, thread.addresses);
+    }
+    groups.symbolize(*modules, &ThreadPool::shared());
+    return groups;
+}
+
+std::expected<std::vector<StackTrace::RawThreadStack>, StackTrace::Error> StackTrace::captureThreadAddresses(
+    const pid_t pid,
+    const ModuleMap& modules,
+    CaptureStats* stats) const
+{
+    using Clock = std::chrono::steady_clock;
+    const auto stopStart = Clock::now();
+
+    const auto threads = PlatformUtils::stopAllThreads(pid);
+    if (threads.empty())
+    {
+        return std::unexpected(PlatformUtils::isProcessRunning(pid) ? Error::AttachFailed : Error::ProcessNotRunning);
+    }
+
+    auto& pool = ThreadPool::shared();
+    std::vector<StackSnapshot> snapshots(threads.size());
+    std::vector<uint8_t> captured(threads.size());
+    PlatformUtils::captureStackSnapshots(threads, m_stackSnapshotBytes, &modules, snapshots, captured, &pool);
+    PlatformUtils::releaseThreads(threads);
 
-    for (size_t i = 0; i < limit; ++i)
+    if (stats != nullptr)
     {
-        const auto& entry = st[i];
-        frames.emplace_back(
-            reinterpret_cast<uintptr_t>(entry.native_handle()),
-            entry.description(),
-            entry.source_file(),
-            entry.source_line()
-        );
+        stats->record(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - stopStart));
     }
 
-    return frames;
+    // Threads whose registers could not be read are dropped before unwinding.
+    size_t kept = 0;
+    for (size_t i = 0; i < snapshots.size(); ++i)
+    {
+        if (captured[i])
+        {
+            std::swap(snapshots[kept++], snapshots[i]);
+        }
+    }
+    snapshots.resize(kept);
+
+    if (snapshots.empty())
+    {
+        return std::unexpected(Error::CaptureFailed);
+    }
+
+    std::vector<std::future<RawThreadStack>> pending;
+    pending.reserve(snapshots.size());
+
+    for (const auto& snapshot : snapshots)
+    {
+        pending.push_back(pool.submit([this, &modules, &snapshot]
+        {
+            return RawThreadStack{snapshot.tid, Unwinder::unwind(snapshot, modules, m_unwindMethod, m_maxDepth), snapshot.syscall()};
+        }));
+    }
+
+    std::vector<RawThreadStack> stacks;
+    stacks.reserve(pending.size());
+    for (auto& future : pending)
+    {
+        stacks.push_back(future.get());
+    }
+
+    std::ranges::sort(stacks, {}, &RawThreadStack::tid);
+    return stacks;
+}
+
+std::optional<StackTrace::SamplingBackend> StackTrace::parseSamplingBackend(const std::string_view name) noexcept
+{
+    if (name == "ptrace")
+    {
+        return SamplingBackend::Ptrace;
+    }
+    if (name == "perf")
+    {
+        return SamplingBackend::Perf;
+    }
+    return std::nullopt;
+}
+
+std::string StackTrace::errorToString(const Error error) noexcept
+{
+    switch (error)
+    {
+        case Error::ProcessNotRunning: return "Process is not running";
+        case Error::AttachFailed: return "Failed to attach to process";
+        case Error::DetachFailed: return "Failed to detach from process";
+        case Error::CaptureFailed: return "Failed to capture stack trace";
+        case Error::PerfUnavailable: return "perf_event_open is not permitted or not supported for this process, or its ring buffers exceed kernel.perf_event_mlock_kb";
+    }
+    return "Unknown error";
 }
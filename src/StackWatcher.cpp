@@ -0,0 +1,137 @@
+#include "StackWatcher.h"
+#include "StackProfile.h"
+#include <algorithm>
+
+/// @brief Anonymous namespace
+namespace
+{
+    size_t differingFrames(const std::span<const uintptr_t> previous, const std::span<const uintptr_t> current) noexcept
+    {
+        // Stacks grow inwards, so the outermost frames are the ones two captures of a thread share.
+        size_t common = 0;
+        while (common < previous.size() && common < current.size()
+            && previous[previous.size() - 1 - common] == current[current.size() - 1 - common])
+        {
+            ++common;
+        }
+        return current.size() - common;
+    }
+}
+
+std::expected<StackWatcher, StackWatcher::Error> StackWatcher::open(
+    const pid_t pid,
+    const TraceSession::Options& options,
+    const size_t maxFrames)
+{
+    auto session = TraceSession::open(pid, options);
+    if (!session)
+    {
+        return std::unexpected(session.error());
+    }
+    return StackWatcher(std::move(*session), maxFrames);
+}
+
+StackWatcher::StackWatcher(TraceSession session, const size_t maxFrames) noexcept
+    : m_session(std::move(session))
+    , m_maxFrames(maxFrames)
+{
+
+}
+
+std::expected<std::vector<StackWatcher::Change>, StackWatcher::Error> StackWatcher::poll(ThreadPool* pool, std::chrono::nanoseconds* stopDuration)
+{
+    reserveThreads(PlatformUtils::listThreads(m_session.pid()).size());
+
+    auto count = m_session.captureAllThreads(m_addresses, m_ranges, m_maxFrames, stopDuration, pool);
+    if (count && m_session.stoppedThreads() > m_ranges.size())
+    {
+        // More threads were started than the headroom allowed for; capture again with room for all of them.
+        reserveThreads(m_session.stoppedThreads());
+        count = m_session.captureAllThreads(m_addresses, m_ranges, m_maxFrames, stopDuration, pool);
+    }
+
+    if (!count)
+    {
+        return std::unexpected(count.error());
+    }
+
+    // A thread left out of a capture that was still too small is unseen, not exited.
+    const bool complete = m_session.stoppedThreads() <= *count;
+
+    std::vector<Change> changes;
+    std::unordered_map<pid_t, ThreadState> current;
+    current.reserve(*count);
+    bool refreshed = false;
+
+    for (const auto& range : std::span(m_ranges).first(*count))
+    {
+        const auto stack = std::span<const uintptr_t>(m_addresses).subspan(range.offset, range.count);
+        const auto hash = StackProfile::AddressHash{}(stack);
+
+        // An unchanged thread keeps its frames and is not reported.
+        const auto previous = m_threads.find(range.tid);
+        if (previous != m_threads.end() && previous->second.hash == hash && std::ranges::equal(previous->second.addresses, stack))
+        {
+            current.emplace(range.tid, std::move(previous->second));
+            continue;
+        }
+
+        // A library loaded since the last poll shows up as an address outside the map.
+        if (!refreshed && std::ranges::any_of(stack, [&](const uintptr_t address) { return !m_session.isMapped(address); }))
+        {
+            refreshed = true;
+            (void)m_session.refreshModules();
+        }
+
+        ThreadState state{hash, std::vector<uintptr_t>(stack.begin(), stack.end()), m_session.symbolize(stack, pool)};
+        if (previous == m_threads.end())
+        {
+            changes.push_back(Change{range.tid, ChangeKind::Started, nullptr, stack.size()});
+        }
+        else
+        {
+            changes.push_back(Change{range.tid, ChangeKind::Changed, nullptr, differingFrames(previous->second.addresses, stack)});
+        }
+        current.emplace(range.tid, std::move(state));
+    }
+
+    for (auto& [tid, state] : m_threads)
+    {
+        if (current.contains(tid))
+        {
+            continue;
+        }
+
+        if (complete)
+        {
+            changes.push_back(Change{tid, ChangeKind::Exited, nullptr, 0});
+        }
+        else
+        {
+            current.emplace(tid, std::move(state));
+        }
+    }
+
+    m_threads = std::move(current);
+    for (auto& change : changes)
+    {
+        if (change.kind != ChangeKind::Exited)
+        {
+            change.frames = &m_threads.at(change.tid).frames;
+        }
+    }
+
+    std::ranges::sort(changes, {}, &Change::tid);
+    return changes;
+}
+
+void StackWatcher::reserveThreads(const size_t threads)
+{
+    // Headroom for threads started between listing and stopping them.
+    const auto wanted = threads + threads / 4 + 8;
+    if (wanted > m_ranges.size())
+    {
+        m_ranges.resize(wanted);
+        m_addresses.resize(wanted * m_maxFrames);
+    }
+}
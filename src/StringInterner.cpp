@@ -0,0 +1,104 @@
+#include "StringInterner.h"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+StringInterner& StringInterner::instance() noexcept
+{
+    // Never destroyed: frames held by other statics may still be printed during exit.
+    static auto* interner = new StringInterner;
+    return *interner;
+}
+
+StringInterner::~StringInterner()
+{
+    for (auto& block : m_blocks)
+    {
+        delete[] block.load(std::memory_order_relaxed);
+    }
+}
+
+uint32_t StringInterner::intern(const std::string_view text)
+{
+    if (text.empty())
+    {
+        return emptyId;
+    }
+
+    {
+        const std::shared_lock lock(m_mutex);
+        if (const auto it = m_index.find(text); it != m_index.end())
+        {
+            return it->second;
+        }
+    }
+
+    const std::unique_lock lock(m_mutex);
+    if (const auto it = m_index.find(text); it != m_index.end())
+    {
+        return it->second;
+    }
+
+    // The last id is kept for the placeholder, so a full interner degrades to one shared name instead of failing.
+    if (m_nextId > overflowId)
+    {
+        return overflowId;
+    }
+
+    const auto id = m_nextId;
+    const auto blockIndex = id >> blockBits;
+    auto* block = m_blocks[blockIndex].load(std::memory_order_relaxed);
+    if (block == nullptr)
+    {
+        block = new std::string_view[blockSize];
+        m_blocks[blockIndex].store(block, std::memory_order_release);
+    }
+
+    ++m_nextId;
+    if (id == overflowId)
+    {
+        block[id & (blockSize - 1)] = overflowText;
+        return id;
+    }
+
+    const auto stored = store(text);
+    block[id & (blockSize - 1)] = stored;
+    m_index.emplace(stored, id);
+    return id;
+}
+
+size_t StringInterner::size() const noexcept
+{
+    const std::shared_lock lock(m_mutex);
+    return std::min<size_t>(m_nextId - 1, maxStrings);
+}
+
+size_t StringInterner::storageBytes() const noexcept
+{
+    const std::shared_lock lock(m_mutex);
+    return m_storageBytes;
+}
+
+std::string_view StringInterner::store(const std::string_view text)
+{
+    // Long strings get a chunk of their own so they do not waste the tail of the current one.
+    if (text.size() > chunkBytes / 4)
+    {
+        auto& chunk = m_chunks.emplace_back(std::make_unique_for_overwrite<char[]>(text.size()));
+        std::memcpy(chunk.get(), text.data(), text.size());
+        m_storageBytes += text.size();
+        return {chunk.get(), text.size()};
+    }
+
+    if (m_chunk == nullptr || chunkBytes - m_chunkUsed < text.size())
+    {
+        m_chunk = m_chunks.emplace_back(std::make_unique_for_overwrite<char[]>(chunkBytes)).get();
+        m_chunkUsed = 0;
+        m_storageBytes += chunkBytes;
+    }
+
+    char* destination = m_chunk + m_chunkUsed;
+    std::memcpy(destination, text.data(), text.size());
+    m_chunkUsed += text.size();
+    return {destination, text.size()};
+}
@@ -0,0 +1,367 @@
+#include "SymbolCache.h"
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/// @brief Anonymous namespace
+namespace
+{
+    constexpr std::array<char, 8> indexMagic{'M', 'X', 'T', 'R', 'I', 'D', 'X', '1'};
+    constexpr uint32_t indexVersion = 2;
+
+    /// @brief Set in IndexHeader::flags once the line table is part of the index.
+    constexpr uint32_t hasLinesFlag = 1;
+    constexpr std::string_view indexSuffix = ".idx";
+
+    /// @brief IndexHeader is the fixed header at the start of every index file, followed by 8-byte aligned arrays. \struct IndexHeader
+    struct IndexHeader
+    {
+        std::array<char, 8> magic{};
+        uint32_t version{0};
+        uint32_t flags{0};
+        uint64_t symbolCount{0};
+        uint64_t namesSize{0};
+        uint64_t rowCount{0};
+        uint64_t fileCount{0};
+        uint64_t fileNamesSize{0};
+    };
+
+    /// @brief Layout holds the offsets of each array inside an index file. \struct Layout
+    struct Layout
+    {
+        uint64_t symbols{0};
+        uint64_t names{0};
+        uint64_t rows{0};
+        uint64_t fileOffsets{0};
+        uint64_t fileNames{0};
+        uint64_t total{0};
+    };
+
+    constexpr uint64_t align8(const uint64_t value) noexcept
+    {
+        return (value + 7) & ~uint64_t{7};
+    }
+
+    std::optional<Layout> layoutFor(const IndexHeader& header, const uint64_t fileSize) noexcept
+    {
+        if (header.symbolCount > fileSize || header.namesSize > fileSize || header.rowCount > fileSize
+            || header.fileCount > fileSize || header.fileNamesSize > fileSize)
+        {
+            return std::nullopt;
+        }
+
+        Layout layout;
+        layout.symbols = align8(sizeof(IndexHeader));
+        layout.names = align8(layout.symbols + header.symbolCount * sizeof(ElfSymbolTable::Entry));
+        layout.rows = align8(layout.names + header.namesSize);
+        layout.fileOffsets = align8(layout.rows + header.rowCount * sizeof(DwarfLineTable::Row));
+        layout.fileNames = align8(layout.fileOffsets + header.fileCount * sizeof(uint32_t));
+        layout.total = layout.fileNames + header.fileNamesSize;
+        return layout;
+    }
+
+    bool writeAll(const int fd, const void* data, size_t size) noexcept
+    {
+        const auto* bytes = static_cast<const char*>(data);
+        while (size > 0)
+        {
+            const auto written = write(fd, bytes, size);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return false;
+            }
+            bytes += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    bool writeAt(const int fd, uint64_t& position, const uint64_t offset, const void* data, const size_t size) noexcept
+    {
+        static constexpr std::array<char, 8> padding{};
+        if (offset < position || offset - position > padding.size())
+        {
+            return false;
+        }
+
+        if (!writeAll(fd, padding.data(), static_cast<size_t>(offset - position)) || !writeAll(fd, data, size))
+        {
+            return false;
+        }
+
+        position = offset + size;
+        return true;
+    }
+
+    bool isValidBuildId(const std::string_view buildId) noexcept
+    {
+        return buildId.size() >= 2 && std::ranges::all_of(buildId, [](const char c)
+        {
+            return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f');
+        });
+    }
+
+    bool makeDirectories(const std::string& path)
+    {
+        for (size_t pos = 1; pos <= path.size(); ++pos)
+        {
+            if (pos == path.size() || path[pos] == '/')
+            {
+                const auto prefix = path.substr(0, pos);
+                if (mkdir(prefix.c_str(), 0755) == -1 && errno != EEXIST)
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+}
+
+SymbolCache::SymbolCache(std::string directory, const uint64_t maxBytes) noexcept
+    : m_directory(std::move(directory))
+    , m_maxBytes(maxBytes)
+{
+
+}
+
+std::optional<std::string> SymbolCache::defaultDirectory()
+{
+    if (const char* dir = std::getenv("MEXTRACE_CACHE_DIR"); dir != nullptr && *dir != '\0')
+    {
+        return std::string(dir);
+    }
+
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg != nullptr && *xdg != '\0')
+    {
+        return std::format("{}/mexTrace", xdg);
+    }
+
+    if (const char* home = std::getenv("HOME"); home != nullptr && *home != '\0')
+    {
+        return std::format("{}/.cache/mexTrace", home);
+    }
+
+    return std::nullopt;
+}
+
+std::optional<SymbolCache::Index> SymbolCache::load(const std::string_view buildId) const
+{
+    if (!isValidBuildId(buildId))
+    {
+        return std::nullopt;
+    }
+
+    const auto path = indexPath(buildId);
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        return std::nullopt;
+    }
+
+    struct stat st{};
+    if (fstat(fd, &st) == -1 || static_cast<size_t>(st.st_size) < sizeof(IndexHeader))
+    {
+        close(fd);
+        return std::nullopt;
+    }
+
+    const auto size = static_cast<size_t>(st.st_size);
+    void* base = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (base == MAP_FAILED)
+    {
+        return std::nullopt;
+    }
+
+    std::shared_ptr<const void> mapping(base, [size](const void* ptr)
+    {
+        munmap(const_cast<void*>(ptr), size);
+    });
+
+    const auto* bytes = static_cast<const char*>(base);
+    IndexHeader header;
+    std::memcpy(&header, bytes, sizeof(header));
+
+    if (header.magic != indexMagic || header.version != indexVersion)
+    {
+        return std::nullopt;
+    }
+
+    const auto layout = layoutFor(header, size);
+    if (!layout || layout->total != size)
+    {
+        return std::nullopt;
+    }
+
+    utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+
+    Index index;
+    index.symbols = ElfSymbolTable::fromStorage(
+        {reinterpret_cast<const ElfSymbolTable::Entry*>(bytes + layout->symbols), header.symbolCount},
+        {bytes + layout->names, header.namesSize},
+        mapping);
+    if ((header.flags & hasLinesFlag) != 0)
+    {
+        index.lines = DwarfLineTable::fromStorage(
+            {reinterpret_cast<const DwarfLineTable::Row*>(bytes + layout->rows), header.rowCount},
+            {reinterpret_cast<const uint32_t*>(bytes + layout->fileOffsets), header.fileCount},
+            {bytes + layout->fileNames, header.fileNamesSize},
+            std::move(mapping));
+    }
+    return index;
+}
+
+bool SymbolCache::store(const std::string_view buildId, const ElfSymbolTable& symbols, const DwarfLineTable* lineTable) const
+{
+    if (!isValidBuildId(buildId) || !makeDirectories(m_directory))
+    {
+        return false;
+    }
+
+    static const DwarfLineTable noLines;
+    const auto& lines = lineTable != nullptr ? *lineTable : noLines;
+
+    IndexHeader header;
+    header.magic = indexMagic;
+    header.version = indexVersion;
+    header.flags = lineTable != nullptr ? hasLinesFlag : 0;
+    header.symbolCount = symbols.entries().size();
+    header.namesSize = symbols.names().size();
+    header.rowCount = lines.rows().size();
+    header.fileCount = lines.fileOffsets().size();
+    header.fileNamesSize = lines.fileNames().size();
+
+    const auto layout = layoutFor(header, ~uint64_t{0});
+    if (!layout || layout->total > m_maxBytes)
+    {
+        return false;
+    }
+
+    // Both paths are built before the temporary file exists, so nothing can throw while it would be left behind.
+    const auto path = indexPath(buildId);
+    auto tempPath = std::format("{}/.{}.XXXXXX", m_directory, buildId);
+    const int fd = mkstemp(tempPath.data());
+    if (fd == -1)
+    {
+        return false;
+    }
+
+    uint64_t position = 0;
+    const bool written =
+        writeAt(fd, position, 0, &header, sizeof(header))
+        && writeAt(fd, position, layout->symbols, symbols.entries().data(), symbols.entries().size_bytes())
+        && writeAt(fd, position, layout->names, symbols.names().data(), symbols.names().size_bytes())
+        && writeAt(fd, position, layout->rows, lines.rows().data(), lines.rows().size_bytes())
+        && writeAt(fd, position, layout->fileOffsets, lines.fileOffsets().data(), lines.fileOffsets().size_bytes())
+        && writeAt(fd, position, layout->fileNames, lines.fileNames().data(), lines.fileNames().size_bytes());
+
+    close(fd);
+
+    if (!written || rename(tempPath.c_str(), path.c_str()) == -1)
+    {
+        unlink(tempPath.c_str());
+        return false;
+    }
+
+    evict();
+    return true;
+}
+
+void SymbolCache::evict() const
+{
+    const auto lockPath = std::format("{}/.lock", m_directory);
+    const int lockFd = open(lockPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (lockFd == -1)
+    {
+        return;
+    }
+
+    if (flock(lockFd, LOCK_EX | LOCK_NB) == -1)
+    {
+        close(lockFd);
+        return;
+    }
+
+    /// @brief CacheFile describes one index file considered for eviction. \struct CacheFile
+    struct CacheFile
+    {
+        std::string path;
+        uint64_t size{0};
+        timespec modified{};
+    };
+
+    std::vector<CacheFile> files;
+    uint64_t totalSize = 0;
+
+    if (DIR* dir = opendir(m_directory.c_str()); dir != nullptr)
+    {
+        const dirent* entry = nullptr;
+        while ((entry = readdir(dir)) != nullptr)
+        {
+            const std::string_view name = entry->d_name;
+            if (!name.ends_with(indexSuffix))
+            {
+                continue;
+            }
+
+            auto path = std::format("{}/{}", m_directory, name);
+            struct stat st{};
+            if (stat(path.c_str(), &st) == 0)
+            {
+                totalSize += static_cast<uint64_t>(st.st_size);
+                files.push_back(CacheFile{std::move(path), static_cast<uint64_t>(st.st_size), st.st_mtim});
+            }
+        }
+        closedir(dir);
+    }
+
+    if (totalSize > m_maxBytes)
+    {
+        std::ranges::sort(files, [](const CacheFile& lhs, const CacheFile& rhs)
+        {
+            if (lhs.modified.tv_sec != rhs.modified.tv_sec)
+            {
+                return lhs.modified.tv_sec < rhs.modified.tv_sec;
+            }
+            return lhs.modified.tv_nsec < rhs.modified.tv_nsec;
+        });
+
+        for (const auto& file : files)
+        {
+            if (totalSize <= m_maxBytes)
+            {
+                break;
+            }
+            if (unlink(file.path.c_str()) == 0 || errno == ENOENT)
+            {
+                totalSize -= file.size;
+            }
+        }
+    }
+
+    flock(lockFd, LOCK_UN);
+    close(lockFd);
+}
+
+std::string SymbolCache::indexPath(const std::string_view buildId) const
+{
+    return std::format("{}/{}{}", m_directory, buildId, indexSuffix);
+}
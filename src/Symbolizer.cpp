@@ -0,0 +1,208 @@
+#include "Symbolizer.h"
+#include "Unwinder.h"
+#include <cxxabi.h>
+#include <elf.h>
+#include <cstdlib>
+
+Symbolizer& Symbolizer::instance() noexcept
+{
+    static Symbolizer symbolizer;
+    return symbolizer;
+}
+
+std::optional<StackFrame> Symbolizer::resolve(const std::string_view modulePath, const uintptr_t address)
+{
+    auto* module = loadModule(modulePath);
+    if (module == nullptr || module->symbols.empty())
+    {
+        return std::nullopt;
+    }
+
+    StackFrame frame(address);
+    if (const auto symbol = module->symbols.lookup(address))
+    {
+        frame.setFunctionName(demangle(symbol->name));
+    }
+
+    if (const auto location = lineTable(*module).lookup(address))
+    {
+        frame.setSourceFile(std::string(location->file));
+        frame.setLineNumber(location->line);
+    }
+
+    return frame;
+}
+
+std::optional<uint64_t> Symbolizer::linkAddress(const std::string_view modulePath, const uint64_t fileOffset)
+{
+    const auto* module = loadModule(modulePath);
+    if (module == nullptr)
+    {
+        return std::nullopt;
+    }
+
+    for (const auto& phdr : module->elf.programHeaders())
+    {
+        if (phdr.p_type == PT_LOAD && fileOffset >= phdr.p_offset && fileOffset - phdr.p_offset < phdr.p_filesz)
+        {
+            return phdr.p_vaddr + (fileOffset - phdr.p_offset);
+        }
+    }
+
+    return std::nullopt;
+}
+
+const CfiTable* Symbolizer::cfiTable(const std::string_view modulePath)
+{
+    auto* module = loadModule(modulePath);
+    if (module == nullptr)
+    {
+        return nullptr;
+    }
+
+    std::call_once(module->cfiOnce, [module]
+    {
+        module->cfi = CfiTable::build(module->elf, Unwinder::framePointerRegister);
+    });
+    return &module->cfi;
+}
+
+void Symbolizer::clear() noexcept
+{
+    const std::scoped_lock lock(m_mutex);
+    m_modules.clear();
+    m_modulesByBuildId.clear();
+}
+
+void Symbolizer::setCache(std::unique_ptr<SymbolCache> cache) noexcept
+{
+    const std::scoped_lock lock(m_mutex);
+    m_cache = std::move(cache);
+}
+
+std::string Symbolizer::demangle(const std::string_view name)
+{
+    if (!name.starts_with("_Z"))
+    {
+        return std::string(name);
+    }
+
+    int status = 0;
+    const std::string mangled(name);
+    char* demangled = abi::__cxa_demangle(mangled.c_str(), nullptr, nullptr, &status);
+
+    if (status != 0 || demangled == nullptr)
+    {
+        return mangled;
+    }
+
+    std::string result(demangled);
+    std::free(demangled);
+    return result;
+}
+
+Symbolizer::Module* Symbolizer::loadModule(const std::string_view modulePath)
+{
+    std::shared_ptr<ModuleSlot> slot;
+    {
+        const std::scoped_lock lock(m_mutex);
+
+        auto it = m_modules.find(modulePath);
+        if (it == m_modules.end())
+        {
+            it = m_modules.emplace(std::string(modulePath), std::make_shared<ModuleSlot>()).first;
+        }
+        slot = it->second;
+    }
+
+    // Indexing runs outside the lock so different modules load concurrently;
+    // threads asking for the same path wait for the first one.
+    std::call_once(slot->loaded, [this, &slot, modulePath]
+    {
+        slot->module = buildModule(modulePath);
+    });
+    return slot->module.get();
+}
+
+std::shared_ptr<Symbolizer::Module> Symbolizer::buildModule(const std::string_view modulePath)
+{
+    auto elf = ElfFile::open(modulePath);
+    if (!elf)
+    {
+        return nullptr;
+    }
+
+    const auto buildId = elf->buildId();
+    SymbolCache* cache = nullptr;
+    {
+        const std::scoped_lock lock(m_mutex);
+        if (buildId)
+        {
+            if (const auto it = m_modulesByBuildId.find(*buildId); it != m_modulesByBuildId.end())
+            {
+                return it->second;
+            }
+        }
+        cache = m_cache.get();
+    }
+
+    // Only the symbol table is built on the way to the first frame; .debug_line is decoded when a
+    // location is first asked for, and the cached index is completed then.
+    std::shared_ptr<Module> module;
+    if (auto index = buildId && cache != nullptr ? cache->load(*buildId) : std::nullopt)
+    {
+        module = std::make_shared<Module>(std::move(*elf), std::move(index->symbols));
+        if (index->lines)
+        {
+            std::call_once(module->linesOnce, [&]
+            {
+                module->lines = std::move(*index->lines);
+            });
+        }
+        else
+        {
+            module->pendingLinesBuildId = *buildId;
+        }
+    }
+    else
+    {
+        auto symbols = ElfSymbolTable::build(*elf);
+        module = std::make_shared<Module>(std::move(*elf), std::move(symbols));
+        if (buildId && cache != nullptr && !module->symbols.empty())
+        {
+            cache->store(*buildId, module->symbols, nullptr);
+            module->pendingLinesBuildId = *buildId;
+        }
+    }
+
+    if (!buildId)
+    {
+        return module;
+    }
+
+    const std::scoped_lock lock(m_mutex);
+    return m_modulesByBuildId.try_emplace(*buildId, std::move(module)).first->second;
+}
+
+const DwarfLineTable& Symbolizer::lineTable(Module& module)
+{
+    std::call_once(module.linesOnce, [this, &module]
+    {
+        module.lines = DwarfLineTable::build(module.elf);
+        if (module.pendingLinesBuildId.empty())
+        {
+            return;
+        }
+
+        SymbolCache* cache = nullptr;
+        {
+            const std::scoped_lock lock(m_mutex);
+            cache = m_cache.get();
+        }
+        if (cache != nullptr)
+        {
+            cache->store(module.pendingLinesBuildId, module.symbols, &module.lines);
+        }
+    });
+    return module.lines;
+}
@@ -0,0 +1,66 @@
+#include "ThreadGroups.h"
+#include "PlatformUtils.h"
+#include <algorithm>
+
+void ThreadGroups::add(const pid_t tid, const std::span<const uintptr_t> stack)
+{
+    m_tids[&m_profile.add(stack)].push_back(tid);
+}
+
+void ThreadGroups::symbolize(const ModuleMap& modules, ThreadPool* pool)
+{
+    m_profile.symbolize(modules, pool);
+}
+
+std::vector<ThreadGroups::Group> ThreadGroups::groups() const
+{
+    std::vector<Group> result;
+    const auto sorted = m_profile.sortedByCount();
+    result.reserve(sorted.size());
+
+    for (const auto* entry : sorted)
+    {
+        result.push_back(Group{&entry->first, &m_tids.at(&entry->first)});
+    }
+    return result;
+}
+
+ThreadGroups::TrieNode ThreadGroups::buildTrie() const
+{
+    TrieNode root;
+
+    for (const auto& [key, tids] : m_tids)
+    {
+        const auto& stack = *key;
+        auto* node = &root;
+        node->threadCount += tids.size();
+
+        for (size_t i = stack.size(); i-- > 0;)
+        {
+            const auto callSite = PlatformUtils::callSiteAddress(stack, i);
+            auto child = std::ranges::find(node->children, callSite, &TrieNode::address);
+            if (child == node->children.end())
+            {
+                node->children.push_back(TrieNode{callSite, m_profile.frameAt(stack, i), 0, {}, {}});
+                child = std::prev(node->children.end());
+            }
+
+            node = &*child;
+            node->threadCount += tids.size();
+        }
+        node->tids.insert(node->tids.end(), tids.begin(), tids.end());
+    }
+
+    auto sortChildren = [](auto& self, TrieNode& node) -> void
+    {
+        std::ranges::sort(node.children, std::ranges::greater{}, &TrieNode::threadCount);
+        std::ranges::sort(node.tids);
+        for (auto& child : node.children)
+        {
+            self(self, child);
+        }
+    };
+    sortChildren(sortChildren, root);
+
+    return root;
+}
@@ -0,0 +1,482 @@
+#include "TraceRunner.h"
+#include "PlatformUtils.h"
+#include "ProcessScanner.h"
+#include "ThreadPool.h"
+#include "Unwinder.h"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <format>
+#include <future>
+#include <thread>
+#include <unistd.h>
+
+/// @brief Anonymous namespace
+namespace
+{
+    /// @brief SampleQueue hands raw samples from the sampling loop to a consumer thread, so symbolizing and
+    ///        writing them never delays the next tick. \class SampleQueue
+    class SampleQueue
+    {
+    public:
+
+        /// @brief Sample is one queued raw stack. \struct Sample
+        struct Sample
+        {
+            pid_t tid{0};
+            std::chrono::system_clock::time_point timestamp;
+            std::vector<uintptr_t> addresses;
+        };
+
+        using Consumer = std::function<void(const Sample&)>;
+
+        /**
+         * @brief Ctor, starts the consumer thread.
+         * @param consume Called on the consumer thread for every sample, in the order they were pushed.
+         */
+        explicit SampleQueue(Consumer consume)
+            : m_consume(std::move(consume))
+            , m_consumer([this] { run(); })
+        {
+
+        }
+
+        /**
+         * @brief Destructor, consumes what is still queued and joins the consumer thread.
+         */
+        ~SampleQueue()
+        {
+            close();
+        }
+
+        SampleQueue(const SampleQueue&) = delete;
+        SampleQueue& operator=(const SampleQueue&) = delete;
+
+        /**
+         * @brief Queues a sample.
+         * @param tid The sampled thread.
+         * @param stack The program counter followed by the return addresses.
+         */
+        void push(const pid_t tid, const std::span<const uintptr_t> stack)
+        {
+            Sample sample{tid, std::chrono::system_clock::now(), std::vector<uintptr_t>(stack.begin(), stack.end())};
+            {
+                const std::lock_guard lock(m_mutex);
+                m_pending.push_back(std::move(sample));
+            }
+            m_ready.notify_one();
+        }
+
+        /**
+         * @brief Consumes what is still queued and joins the consumer thread.
+         */
+        void close()
+        {
+            {
+                const std::lock_guard lock(m_mutex);
+                m_closed = true;
+            }
+            m_ready.notify_one();
+            if (m_consumer.joinable())
+            {
+                m_consumer.join();
+            }
+        }
+
+    private:
+        Consumer m_consume;
+        std::mutex m_mutex;
+        std::condition_variable m_ready;
+        std::deque<Sample> m_pending;
+        bool m_closed{false};
+        std::thread m_consumer;
+
+        void run()
+        {
+            std::deque<Sample> batch;
+            for (;;)
+            {
+                {
+                    std::unique_lock lock(m_mutex);
+                    m_ready.wait(lock, [this] { return m_closed || !m_pending.empty(); });
+                    if (m_pending.empty())
+                    {
+                        return;
+                    }
+                    batch.swap(m_pending);
+                }
+
+                for (const auto& sample : batch)
+                {
+                    m_consume(sample);
+                }
+                batch.clear();
+            }
+        }
+    };
+}
+
+TraceRunner::RecordSink::RecordSink(std::ostream& os, const RecordWriter::Format format)
+    : m_writer(os, format)
+{
+
+}
+
+void TraceRunner::RecordSink::write(const RecordWriter::Record& record)
+{
+    const std::lock_guard lock(m_mutex);
+    m_writer.write(record);
+}
+
+void TraceRunner::Handler::onAttach(const std::optional<std::string>&, const std::optional<std::string>&)
+{
+
+}
+
+void TraceRunner::Handler::onError(std::string_view)
+{
+
+}
+
+void TraceRunner::Handler::onStack(const std::vector<StackFrame>&)
+{
+
+}
+
+void TraceRunner::Handler::onThreads(std::span<const ThreadStack>)
+{
+
+}
+
+void TraceRunner::Handler::onThreadGroups(const ThreadGroups&)
+{
+
+}
+
+void TraceRunner::Handler::onProfile(const StackProfile&)
+{
+
+}
+
+void TraceRunner::Handler::onChanges(size_t, std::span<const StackWatcher::Change>, size_t)
+{
+
+}
+
+bool TraceRunner::Handler::keepWatching()
+{
+    return true;
+}
+
+void TraceRunner::Handler::onExit()
+{
+
+}
+
+void TraceRunner::Handler::onWatchEnd(size_t)
+{
+
+}
+
+void TraceRunner::Handler::onHangReport(const HangDetector::Report&)
+{
+
+}
+
+void TraceRunner::Handler::onStats(const CaptureStats&)
+{
+
+}
+
+TraceRunner::RecordSink* TraceRunner::Handler::recordSink()
+{
+    return nullptr;
+}
+
+void TraceRunner::Handler::finish()
+{
+
+}
+
+TraceRunner::TraceRunner(const Options& options) noexcept
+    : m_options(options)
+{
+
+}
+
+void TraceRunner::run(const pid_t pid, Handler& handler) const
+{
+    capture(pid, handler);
+    handler.finish();
+}
+
+void TraceRunner::run(const std::span<const pid_t> targets, const size_t jobs, const HandlerFactory& makeHandler) const
+{
+    if (targets.size() == 1)
+    {
+        const auto handler = makeHandler(targets.front());
+        run(targets.front(), *handler);
+        return;
+    }
+
+    std::vector<std::unique_ptr<Handler>> handlers;
+    handlers.reserve(targets.size());
+    for (const auto pid : targets)
+    {
+        handlers.push_back(makeHandler(pid));
+    }
+
+    // The targets are captured concurrently, but each handler is finished in target order.
+    const auto workers = jobs != 0 ? jobs : std::max(1u, std::thread::hardware_concurrency());
+    ThreadPool pool(std::min(workers, targets.size()));
+    std::vector<std::future<void>> pending;
+    pending.reserve(targets.size());
+
+    for (size_t i = 0; i < targets.size(); ++i)
+    {
+        pending.push_back(pool.submit([this, pid = targets[i], &handler = *handlers[i]] { capture(pid, handler); }));
+    }
+
+    for (size_t i = 0; i < targets.size(); ++i)
+    {
+        pending[i].get();
+        handlers[i]->finish();
+    }
+}
+
+std::expected<std::vector<pid_t>, std::string> TraceRunner::findProcesses(const std::optional<std::regex>& pattern, ThreadPool* pool)
+{
+    const ProcessScanner scanner;
+    const auto processes = scanner.scan(pool);
+    if (processes.empty())
+    {
+        return std::unexpected("Failed to read /proc");
+    }
+
+    std::vector<pid_t> pids;
+    for (const auto& process : processes)
+    {
+        if (process.pid == getpid() || (pattern && !std::regex_search(process.name, *pattern)))
+        {
+            continue;
+        }
+        pids.push_back(process.pid);
+    }
+    std::ranges::sort(pids);
+    return pids;
+}
+
+std::optional<TraceRunner::SamplingBackend> TraceRunner::parseSamplingBackend(const std::string_view name) noexcept
+{
+    return StackTrace::parseSamplingBackend(name);
+}
+
+void TraceRunner::capture(const pid_t pid, Handler& handler) const
+{
+    if (!PlatformUtils::isProcessRunning(pid))
+    {
+        handler.onError(std::format("Process {} is not running", pid));
+        return;
+    }
+
+    handler.onAttach(PlatformUtils::getProcessName(pid), PlatformUtils::getExecutablePath(pid));
+
+    if (m_options.mode == Mode::Watch)
+    {
+        watch(pid, handler);
+        return;
+    }
+
+    if (m_options.mode == Mode::DetectHang)
+    {
+        const auto report = HangDetector::detect(pid, m_options.session, m_options.duration, HangDetector::defaultSamples, &ThreadPool::shared());
+        if (!report)
+        {
+            handler.onError(StackTrace::errorToString(report.error()));
+            return;
+        }
+        handler.onHangReport(*report);
+        return;
+    }
+
+    StackTrace tracer;
+    // Setting the snapshot size also sizes the perf ring buffers, so the default is left to the tracer.
+    if (m_options.session.stackBytes != TraceSession::defaultStackBytes)
+    {
+        tracer.setStackSnapshotSize(m_options.session.stackBytes);
+    }
+    tracer.setUnwindMethod(Unwinder::fromSession(m_options.session.unwindMethod));
+    tracer.setSamplingBackend(m_options.backend);
+
+    if (m_options.records)
+    {
+        if (auto* sink = handler.recordSink(); sink != nullptr)
+        {
+            streamRecords(tracer, pid, *sink, handler);
+        }
+        return;
+    }
+
+    CaptureStats stats;
+
+    switch (m_options.mode)
+    {
+        case Mode::Sample:
+        {
+            const auto result = tracer.sampleProcess(pid, m_options.sampleHz,
+                std::chrono::duration_cast<std::chrono::milliseconds>(m_options.duration), &stats);
+            if (!result)
+            {
+                handler.onError(StackTrace::errorToString(result.error()));
+                return;
+            }
+            handler.onProfile(*result);
+            break;
+        }
+        case Mode::ThreadGroups:
+        {
+            const auto result = tracer.captureThreadGroups(pid, &stats);
+            if (!result)
+            {
+                handler.onError(StackTrace::errorToString(result.error()));
+                return;
+            }
+            handler.onThreadGroups(*result);
+            break;
+        }
+        case Mode::AllThreads:
+        {
+            const auto result = tracer.captureAllThreads(pid, &stats);
+            if (!result)
+            {
+                handler.onError(StackTrace::errorToString(result.error()));
+                return;
+            }
+            handler.onThreads(*result);
+            break;
+        }
+        default:
+        {
+            const auto result = tracer.captureProcess(pid, &stats);
+            if (!result)
+            {
+                handler.onError(StackTrace::errorToString(result.error()));
+                return;
+            }
+            handler.onStack(*result);
+            break;
+        }
+    }
+
+    handler.onStats(stats);
+}
+
+void TraceRunner::streamRecords(const StackTrace& tracer, const pid_t pid, RecordSink& sink, Handler& handler) const
+{
+    CaptureStats stats;
+    const auto now = [] { return std::chrono::system_clock::now(); };
+
+    if (m_options.mode == Mode::Sample)
+    {
+        auto session = TraceSession::open(pid, m_options.session);
+        if (!session)
+        {
+            handler.onError(TraceSession::errorToString(session.error()));
+            return;
+        }
+
+        // The sampling thread only queues raw stacks; the consumer symbolizes them through the session,
+        // which memoizes every call site, and writes each record as soon as it is resolved.
+        SampleQueue queue([&](const SampleQueue::Sample& sample)
+        {
+            const auto frames = session->symbolize(sample.addresses);
+            sink.write({pid, sample.tid, sample.timestamp, frames});
+        });
+
+        const auto result = tracer.sampleProcess(pid, m_options.sampleHz,
+            std::chrono::duration_cast<std::chrono::milliseconds>(m_options.duration), &stats,
+            [&](const pid_t tid, const std::span<const uintptr_t> stack) { queue.push(tid, stack); });
+        queue.close();
+
+        if (!result)
+        {
+            handler.onError(StackTrace::errorToString(result.error()));
+            return;
+        }
+    }
+    else if (m_options.mode == Mode::AllThreads || m_options.mode == Mode::ThreadGroups)
+    {
+        const auto result = tracer.captureAllThreads(pid, &stats);
+        if (!result)
+        {
+            handler.onError(StackTrace::errorToString(result.error()));
+            return;
+        }
+
+        const auto timestamp = now();
+        for (const auto& thread : *result)
+        {
+            sink.write({pid, thread.tid, timestamp, thread.frames, &thread.state});
+        }
+    }
+    else
+    {
+        const auto result = tracer.captureProcess(pid, &stats);
+        if (!result)
+        {
+            handler.onError(StackTrace::errorToString(result.error()));
+            return;
+        }
+        sink.write({pid, pid, now(), *result});
+    }
+
+    handler.onStats(stats);
+}
+
+void TraceRunner::watch(const pid_t pid, Handler& handler) const
+{
+    using Clock = std::chrono::steady_clock;
+
+    auto watcher = StackWatcher::open(pid, m_options.session);
+    if (!watcher)
+    {
+        handler.onError(TraceSession::errorToString(watcher.error()));
+        return;
+    }
+
+    const auto interval = std::chrono::duration_cast<Clock::duration>(m_options.watchInterval);
+    CaptureStats stats;
+    size_t polls = 0;
+
+    while (handler.keepWatching())
+    {
+        const auto pollStart = Clock::now();
+
+        std::chrono::nanoseconds stopDuration{0};
+        const auto changes = watcher->poll(&ThreadPool::shared(), &stopDuration);
+        if (!changes)
+        {
+            if (changes.error() == TraceSession::Error::ProcessNotRunning)
+            {
+                handler.onExit();
+            }
+            else
+            {
+                handler.onError(TraceSession::errorToString(changes.error()));
+            }
+            break;
+        }
+        stats.record(stopDuration);
+        handler.onChanges(++polls, *changes, watcher->threadCount());
+
+        // Sleep in short slices so a stop request ends the watch promptly.
+        const auto nextPoll = pollStart + interval;
+        while (Clock::now() < nextPoll && handler.keepWatching())
+        {
+            std::this_thread::sleep_for(std::min<Clock::duration>(nextPoll - Clock::now(), std::chrono::milliseconds(100)));
+        }
+    }
+
+    handler.onWatchEnd(polls);
+    handler.onStats(stats);
+}
@@ -0,0 +1,254 @@
+#include "TraceSession.h"
+#include "ModuleMap.h"
+#include "PlatformUtils.h"
+#include "StackSnapshot.h"
+#include "SymbolCache.h"
+#include "Symbolizer.h"
+#include "Unwinder.h"
+#include <algorithm>
+#include <unordered_map>
+
+static_assert(TraceSession::defaultStackBytes == PlatformUtils::defaultStackSnapshotBytes);
+
+/// @brief State holds everything behind the stable interface of a session. \struct State
+struct TraceSession::State
+{
+    pid_t pid{0};
+    Options options;
+    ModuleMap modules;
+    StackSnapshot snapshot;
+    std::vector<StackSnapshot> threadSnapshots;
+    std::vector<PlatformUtils::StoppedThread> stopped;
+    std::vector<uint8_t> captured;
+    size_t stoppedThreads{0};
+    std::unordered_map<uintptr_t, StackFrame> frames;
+};
+
+std::expected<TraceSession, TraceSession::Error> TraceSession::open(const pid_t pid, const Options& options)
+{
+    if (!PlatformUtils::isProcessRunning(pid))
+    {
+        return std::unexpected(Error::ProcessNotRunning);
+    }
+
+    auto modules = ModuleMap::read(pid);
+    if (!modules)
+    {
+        return std::unexpected(Error::CaptureFailed);
+    }
+
+    auto state = std::make_unique<State>();
+    state->pid = pid;
+    state->options = options;
+    state->modules = std::move(*modules);
+    return TraceSession(std::move(state));
+}
+
+TraceSession::TraceSession(std::unique_ptr<State> state) noexcept
+    : m_state(std::move(state))
+{
+
+}
+
+TraceSession::TraceSession(TraceSession&& other) noexcept = default;
+
+TraceSession& TraceSession::operator=(TraceSession&& other) noexcept = default;
+
+TraceSession::~TraceSession() = default;
+
+pid_t TraceSession::pid() const noexcept
+{
+    return m_state->pid;
+}
+
+bool TraceSession::isMapped(const uintptr_t address) const noexcept
+{
+    return m_state->modules.find(address) != nullptr;
+}
+
+bool TraceSession::refreshModules()
+{
+    auto modules = ModuleMap::read(m_state->pid);
+    if (!modules)
+    {
+        return false;
+    }
+
+    m_state->modules = std::move(*modules);
+    m_state->frames.clear();
+    return true;
+}
+
+std::expected<size_t, TraceSession::Error> TraceSession::capture(
+    const pid_t tid,
+    const std::span<uintptr_t> addresses,
+    std::chrono::nanoseconds* stopDuration)
+{
+    using Clock = std::chrono::steady_clock;
+    const auto stopStart = Clock::now();
+
+    const auto stopped = PlatformUtils::stopThread(tid);
+    if (!stopped)
+    {
+        return std::unexpected(PlatformUtils::isProcessRunning(tid) ? Error::AttachFailed : Error::ProcessNotRunning);
+    }
+
+    auto& state = *m_state;
+    const bool captured = PlatformUtils::captureStackSnapshot(tid, state.options.stackBytes, &state.modules, state.snapshot);
+    PlatformUtils::releaseThreads(std::span(&*stopped, 1));
+
+    if (stopDuration != nullptr)
+    {
+        *stopDuration = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - stopStart);
+    }
+
+    if (!captured)
+    {
+        return std::unexpected(Error::CaptureFailed);
+    }
+    return Unwinder::unwind(state.snapshot, state.modules, Unwinder::fromSession(state.options.unwindMethod), addresses);
+}
+
+std::expected<size_t, TraceSession::Error> TraceSession::captureAllThreads(
+    const std::span<uintptr_t> addresses,
+    const std::span<ThreadRange> threads,
+    const size_t maxFrames,
+    std::chrono::nanoseconds* stopDuration,
+    ThreadPool* pool)
+{
+    using Clock = std::chrono::steady_clock;
+    const auto stopStart = Clock::now();
+
+    // Snapshots, the stop list and the capture flags are kept across calls so their buffers are reused.
+    auto& state = *m_state;
+    PlatformUtils::stopAllThreads(state.pid, state.stopped);
+    const auto& stopped = state.stopped;
+    if (stopped.empty())
+    {
+        return std::unexpected(PlatformUtils::isProcessRunning(state.pid) ? Error::AttachFailed : Error::ProcessNotRunning);
+    }
+
+    state.stoppedThreads = stopped.size();
+    const auto count = std::min(stopped.size(), threads.size());
+    if (state.threadSnapshots.size() < count)
+    {
+        state.threadSnapshots.resize(count);
+    }
+
+    state.captured.assign(count, 0);
+    PlatformUtils::captureStackSnapshots(
+        std::span(stopped).first(count),
+        state.options.stackBytes,
+        &state.modules,
+        std::span(state.threadSnapshots).first(count),
+        state.captured,
+        pool);
+    PlatformUtils::releaseThreads(stopped);
+
+    if (stopDuration != nullptr)
+    {
+        *stopDuration = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - stopStart);
+    }
+
+    size_t written = 0;
+    size_t offset = 0;
+    for (size_t i = 0; i < count && offset < addresses.size(); ++i)
+    {
+        if (!state.captured[i])
+        {
+            continue;
+        }
+
+        const auto out = addresses.subspan(offset, std::min(maxFrames, addresses.size() - offset));
+        const auto frames = Unwinder::unwind(state.threadSnapshots[i], state.modules, Unwinder::fromSession(state.options.unwindMethod), out);
+        threads[written++] = ThreadRange{state.threadSnapshots[i].tid, static_cast<uint32_t>(offset), static_cast<uint32_t>(frames)};
+        offset += frames;
+    }
+
+    if (written == 0)
+    {
+        return std::unexpected(Error::CaptureFailed);
+    }
+
+    std::ranges::sort(threads.first(written), {}, &ThreadRange::tid);
+    return written;
+}
+
+size_t TraceSession::stoppedThreads() const noexcept
+{
+    return m_state->stoppedThreads;
+}
+
+std::vector<StackFrame> TraceSession::symbolize(const std::span<const uintptr_t> stack, ThreadPool* pool)
+{
+    auto& frames = m_state->frames;
+
+    std::vector<uintptr_t> pending;
+    for (size_t i = 0; i < stack.size(); ++i)
+    {
+        const auto callSite = PlatformUtils::callSiteAddress(stack, i);
+        if (!frames.contains(callSite))
+        {
+            pending.push_back(callSite);
+        }
+    }
+
+    if (!pending.empty())
+    {
+        std::ranges::sort(pending);
+        const auto [first, last] = std::ranges::unique(pending);
+        pending.erase(first, last);
+
+        auto resolved = PlatformUtils::resolveModuleAddresses(m_state->modules, pending, pool);
+        for (size_t i = 0; i < pending.size(); ++i)
+        {
+            frames.emplace(pending[i], std::move(resolved[i]));
+        }
+    }
+
+    std::vector<StackFrame> result;
+    result.reserve(stack.size());
+    for (size_t i = 0; i < stack.size(); ++i)
+    {
+        result.push_back(frames.at(PlatformUtils::callSiteAddress(stack, i)));
+        result.back().setAddress(stack[i]);
+    }
+    return result;
+}
+
+std::optional<TraceSession::UnwindMethod> TraceSession::parseUnwindMethod(const std::string_view name) noexcept
+{
+    const auto method = Unwinder::parseMethod(name);
+    if (!method)
+    {
+        return std::nullopt;
+    }
+    return *method == Unwinder::Method::FramePointer ? UnwindMethod::FramePointer : UnwindMethod::Dwarf;
+}
+
+bool TraceSession::enableSymbolCache(std::string directory)
+{
+    if (directory.empty())
+    {
+        auto defaultDirectory = SymbolCache::defaultDirectory();
+        if (!defaultDirectory)
+        {
+            return false;
+        }
+        directory = std::move(*defaultDirectory);
+    }
+
+    Symbolizer::instance().setCache(std::make_unique<SymbolCache>(std::move(directory)));
+    return true;
+}
+
+std::string TraceSession::errorToString(const Error error) noexcept
+{
+    switch (error)
+    {
+        case Error::ProcessNotRunning: return "Process is not running";
+        case Error::AttachFailed: return "Failed to attach to process";
+        case Error::CaptureFailed: return "Failed to capture stack trace";
+    }
+    return "Unknown error";
+}
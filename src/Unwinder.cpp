@@ -0,0 +1,213 @@
+#include "Unwinder.h"
+#include "PlatformUtils.h"
+#include "Symbolizer.h"
+#include <algorithm>
+
+/// @brief Anonymous namespace
+namespace
+{
+    /// @brief Registers is the subset of the register file needed to step from one frame to its caller. \struct Registers
+    struct Registers
+    {
+        uintptr_t pc{0};
+        uintptr_t sp{0};
+        uintptr_t fp{0};
+        std::optional<uintptr_t> lr;
+    };
+
+    std::optional<uintptr_t> recoverRegister(
+        const StackSnapshot& snapshot,
+        const CfiTable::RegisterRule& rule,
+        const uintptr_t cfa,
+        const std::optional<uintptr_t> sameValue) noexcept
+    {
+        switch (rule.kind)
+        {
+            case CfiTable::RuleKind::Offset:
+                return snapshot.readWord(cfa + static_cast<uintptr_t>(static_cast<intptr_t>(rule.value)));
+            case CfiTable::RuleKind::ValOffset:
+                return cfa + static_cast<uintptr_t>(static_cast<intptr_t>(rule.value));
+            case CfiTable::RuleKind::SameValue:
+                return sameValue;
+            default:
+                return std::nullopt;
+        }
+    }
+
+    /// @brief Result of a CFI step, distinguishing "no CFI here" from "CFI marks the outermost frame". \enum CfiStep
+    enum class CfiStep : uint8_t
+    {
+        Stepped,
+        Unavailable,
+        Outermost
+    };
+
+    CfiStep stepWithCfi(const StackSnapshot& snapshot, const ModuleMap& modules, Registers& regs, const bool firstFrame)
+    {
+        // Return addresses point past the call; evaluate the rules of the call instruction itself.
+        const auto lookupAddress = firstFrame ? regs.pc : regs.pc - 1;
+        const auto* mapping = modules.find(lookupAddress);
+        if (mapping == nullptr || mapping->moduleId == ModuleMap::noModule)
+        {
+            return CfiStep::Unavailable;
+        }
+
+        auto& symbolizer = Symbolizer::instance();
+        const auto& modulePath = modules.modules()[mapping->moduleId];
+        const auto linkAddress = symbolizer.linkAddress(modulePath, ModuleMap::fileOffset(*mapping, lookupAddress));
+        const auto* table = symbolizer.cfiTable(modulePath);
+        if (!linkAddress || table == nullptr)
+        {
+            return CfiStep::Unavailable;
+        }
+
+        const auto row = table->find(*linkAddress);
+        if (!row || row->cfaIsExpression)
+        {
+            return CfiStep::Unavailable;
+        }
+
+        uintptr_t cfaBase = 0;
+        if (row->cfaRegister == Unwinder::stackPointerRegister)
+        {
+            cfaBase = regs.sp;
+        }
+        else if (row->cfaRegister == Unwinder::framePointerRegister)
+        {
+            cfaBase = regs.fp;
+        }
+        else
+        {
+            return CfiStep::Unavailable;
+        }
+
+        if (row->returnAddress.kind == CfiTable::RuleKind::Undefined)
+        {
+            return CfiStep::Outermost;
+        }
+
+        const auto cfa = cfaBase + static_cast<uintptr_t>(static_cast<intptr_t>(row->cfaOffset));
+        const auto returnAddress = recoverRegister(snapshot, row->returnAddress, cfa, regs.lr);
+        if (!returnAddress)
+        {
+            return CfiStep::Unavailable;
+        }
+
+        auto framePointer = row->framePointer.kind == CfiTable::RuleKind::Undefined
+            ? std::optional{regs.fp}
+            : recoverRegister(snapshot, row->framePointer, cfa, regs.fp);
+
+        regs.pc = *returnAddress;
+        regs.sp = cfa;
+        regs.fp = framePointer.value_or(0);
+        regs.lr.reset();
+        return CfiStep::Stepped;
+    }
+
+    bool stepWithFramePointer(const StackSnapshot& snapshot, Registers& regs) noexcept
+    {
+        if (regs.fp == 0 || regs.fp < regs.sp)
+        {
+            return false;
+        }
+
+        const auto nextFp = snapshot.readWord(regs.fp);
+        const auto returnAddress = snapshot.readWord(regs.fp + sizeof(void*));
+        if (!nextFp || !returnAddress)
+        {
+            return false;
+        }
+
+        regs.pc = *returnAddress;
+        regs.sp = regs.fp + 2 * sizeof(void*);
+        regs.fp = *nextFp;
+        regs.lr.reset();
+        return true;
+    }
+}
+
+std::vector<uintptr_t> Unwinder::unwind(
+    const StackSnapshot& snapshot,
+    const ModuleMap& modules,
+    const Method method,
+    const size_t maxFrames) noexcept
+{
+    std::vector<uintptr_t> addresses(maxFrames);
+    addresses.resize(unwind(snapshot, modules, method, addresses));
+    return addresses;
+}
+
+size_t Unwinder::unwind(
+    const StackSnapshot& snapshot,
+    const ModuleMap& modules,
+    const Method method,
+    const std::span<uintptr_t> addresses) noexcept
+{
+    if (addresses.empty())
+    {
+        return 0;
+    }
+
+#if defined(__x86_64__) || defined(__aarch64__)
+    Registers regs{snapshot.programCounter(), snapshot.stackPointer(), snapshot.framePointer(), std::nullopt};
+#if defined(__aarch64__)
+    regs.lr = snapshot.regs.regs[linkRegister];
+#endif
+
+    size_t count = 0;
+    addresses[count++] = regs.pc;
+
+    try
+    {
+        while (count < addresses.size())
+        {
+            const auto previousSp = regs.sp;
+            const auto step = method == Method::Dwarf
+                ? stepWithCfi(snapshot, modules, regs, count == 1)
+                : CfiStep::Unavailable;
+
+            if (step == CfiStep::Outermost)
+            {
+                break;
+            }
+
+            if (step == CfiStep::Unavailable && !stepWithFramePointer(snapshot, regs))
+            {
+                break;
+            }
+
+            // The stack grows down: a caller frame never lies below its callee.
+            if (regs.pc == 0 || regs.sp <= previousSp)
+            {
+                break;
+            }
+
+            addresses[count++] = regs.pc;
+        }
+    }
+    catch (...)
+    {
+    }
+
+    return count;
+#else
+    static_cast<void>(modules);
+    static_cast<void>(method);
+    const auto walked = PlatformUtils::walkFramePointers(snapshot, addresses.size());
+    std::ranges::copy(walked, addresses.begin());
+    return walked.size();
+#endif
+}
+
+std::optional<Unwinder::Method> Unwinder::parseMethod(const std::string_view name) noexcept
+{
+    if (name == "fp")
+    {
+        return Method::FramePointer;
+    }
+    if (name == "dwarf")
+    {
+        return Method::Dwarf;
+    }
+    return std::nullopt;
+}
@@ -1,13 +1,32 @@
-#include "StackTrace.h"
 #include "ConsolePrinter.h"
-#include "PlatformUtils.h"
+#include "CrashHandler.h"
+#include "ProcessScanner.h"
+#include "ProfileWriter.h"
+#include "RecordWriter.h"
+#include "SelfTrace.h"
+#include "ThreadPool.h"
+#include "TraceRunner.h"
+#include "TraceSession.h"
+#include <csignal>
 #include <cstdlib>
+#include <cstring>
+#include <expected>
+#include <fstream>
+#include <iostream>
 #include <print>
 #include <string>
 #include <string_view>
 #include <span>
 #include <charconv>
+#include <chrono>
 #include <algorithm>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <regex>
+#include <sstream>
+#include <utility>
+#include <vector>
 
 /// @brief Anonymous namespace
 namespace
@@ -15,36 +34,391 @@ namespace
     /// @brief Options struct to hold command-line options. \struct Options
     struct Options
     {
-        pid_t pid{0};
+        std::vector<pid_t> pids;
+        bool all{false};
+        std::string namePattern;
+        size_t jobs{0};
         bool list{false};
+        std::string listSort{"pid"};
+        std::string stateFilter;
+        size_t top{0};
         bool verbose{false};
         bool help{false};
         bool self{false};
+        bool noCache{false};
+        bool allThreads{false};
+        bool group{false};
+        bool tree{false};
+        size_t stackBytes{0};
+        uint32_t sampleHz{0};
+        double durationSec{5.0};
+        double watchSec{0.0};
+        bool detectHang{false};
+        TraceSession::UnwindMethod unwindMethod{TraceSession::UnwindMethod::Dwarf};
+        TraceRunner::SamplingBackend backend{TraceRunner::SamplingBackend::Ptrace};
+        std::string cacheDir;
+        std::string format{"text"};
+        std::string outputPath;
+        std::string crashFile;
+        std::string usageError;
     };
-}
 
+    /// @brief Set by SIGINT to end --watch.
+    volatile std::sig_atomic_t watchInterrupted = 0;
+
+    /// @brief Set when --detect-hang finds a lock cycle or convoy in any target.
+    std::atomic<bool> hangSuspected{false};
+
+    /// @brief TargetPrinter prints what TraceRunner captured from one target. When several targets are captured
+    ///        at once, its output is buffered and written out by finish(), so targets appear in PID order. \class TargetPrinter
+    class TargetPrinter : public TraceRunner::Handler
+    {
+    public:
+
+        /**
+         * @brief Ctor.
+         * @param opts The command-line options.
+         * @param pid The target.
+         * @param multipleTargets Whether other targets are captured concurrently.
+         * @param sharedSink The sink records bound for stdout are streamed to, or nullptr to write them directly.
+         */
+        TargetPrinter(const Options& opts, const pid_t pid, const bool multipleTargets, TraceRunner::RecordSink* sharedSink)
+            : m_opts(opts)
+            , m_pid(pid)
+            , m_multipleTargets(multipleTargets)
+            , m_sharedSink(sharedSink)
+            , m_out(multipleTargets ? static_cast<std::ostream&>(m_outBuffer) : std::cout)
+            , m_log(multipleTargets ? static_cast<std::ostream&>(m_logBuffer) : std::cerr)
+        {
+
+        }
+
+        void onAttach(const std::optional<std::string>& name, const std::optional<std::string>& path) override
+        {
+            if (!m_opts.verbose)
+            {
+                return;
+            }
+
+            const ConsolePrinter printer(m_out);
+            printer.printInfo(std::format("Attaching to process: {}", m_pid));
+            if (name)
+            {
+                printer.printInfo(std::format("Process name: {}", *name));
+            }
+            if (path)
+            {
+                printer.printInfo(std::format("Executable path: {}", *path));
+            }
+        }
+
+        void onError(const std::string_view message) override
+        {
+            // Record streams keep stdout for the records themselves.
+            ConsolePrinter(m_sink != nullptr ? m_log : m_out).printError(message);
+        }
+
+        void onStack(const std::vector<StackFrame>& frames) override
+        {
+            ConsolePrinter(m_out).printStackTrace(frames);
+            m_summary = std::format("Captured stack trace for process {}", m_pid);
+        }
+
+        void onThreads(const std::span<const TraceRunner::ThreadStack> threads) override
+        {
+            const ConsolePrinter printer(m_out);
+            for (const auto& thread : threads)
+            {
+                printer.printThreadHeader(thread);
+                printer.printStackTrace(thread.frames);
+            }
+            m_summary = std::format("Captured {} thread stacks for process {}", threads.size(), m_pid);
+        }
+
+        void onThreadGroups(const ThreadGroups& groups) override
+        {
+            const ConsolePrinter printer(m_out);
+            if (m_opts.group)
+            {
+                printer.printThreadGroups(groups);
+            }
+            if (m_opts.tree)
+            {
+                printer.printStackTrie(groups.buildTrie());
+            }
+            m_summary = std::format("Captured {} thread stacks ({} distinct) for process {}",
+                groups.threadCount(), groups.groups().size(), m_pid);
+        }
+
+        void onProfile(const StackProfile& profile) override
+        {
+            if (m_opts.format != "text")
+            {
+                writeProfile(profile);
+                return;
+            }
+
+            const ConsolePrinter printer(m_out);
+            for (const auto* entry : profile.sortedByCount())
+            {
+                const auto percent = 100.0 * static_cast<double>(entry->second) / static_cast<double>(profile.totalSamples());
+                printer.printInfo(std::format("{} samples ({:.1f}%)", entry->second, percent));
+                printer.printStackTrace(profile.frames(entry->first));
+            }
+            m_summary = std::format("Collected {} samples ({} unique stacks) from process {}",
+                profile.totalSamples(), profile.stacks().size(), m_pid);
+        }
+
+        void onChanges(const size_t poll, const std::span<const StackWatcher::Change> changes, const size_t threadCount) override
+        {
+            // Quiet ticks print nothing, so a stuck process leaves the screen alone.
+            if (!changes.empty())
+            {
+                const ConsolePrinter printer(m_out);
+                printer.printInfo(std::format("Poll {}: {} change(s) among {} thread(s)", poll, changes.size(), threadCount));
+                printer.printStackChanges(changes);
+            }
+        }
+
+        bool keepWatching() override
+        {
+            return watchInterrupted == 0;
+        }
+
+        void onExit() override
+        {
+            ConsolePrinter(m_out).printInfo(std::format("Process {} exited", m_pid));
+        }
+
+        void onWatchEnd(const size_t polls) override
+        {
+            m_summary = std::format("Watched process {} for {} polls", m_pid, polls);
+        }
+
+        void onHangReport(const HangDetector::Report& report) override
+        {
+            const ConsolePrinter printer(m_out);
+            printer.printHangReport(report);
+
+            ConsolePrinter(m_log).printInfo(std::format("Target stopped {} times, {:.1f} us at most",
+                report.samples, std::chrono::duration<double, std::micro>(report.maxStop).count()));
+
+            if (report.hangSuspected())
+            {
+                hangSuspected = true;
+                printer.printWarning(std::format("Process {}: {} of {} threads stuck, {} lock cycle(s), {} convoy(s)",
+                    m_pid, report.stuck.size(), report.threadCount, report.cycles.size(), report.convoys.size()));
+                return;
+            }
+            printer.printSuccess(std::format("Process {}: {} of {} threads did not move, no lock cycles or convoys",
+                m_pid, report.stuck.size(), report.threadCount));
+        }
+
+        void onStats(const TraceRunner::CaptureStats& stats) override
+        {
+            printStats(stats);
+            if (!m_summary.empty())
+            {
+                ConsolePrinter(m_out).printSuccess(m_summary);
+            }
+        }
+
+        TraceRunner::RecordSink* recordSink() override
+        {
+            const auto path = outputPath();
+            if (m_sharedSink != nullptr && path.empty())
+            {
+                // Targets streaming to stdout together share one writer, so their records reach it as they are taken.
+                m_sink = m_sharedSink;
+                return m_sink;
+            }
+
+            if (!path.empty())
+            {
+                m_file.open(path, std::ios::binary | std::ios::trunc);
+                if (!m_file)
+                {
+                    ConsolePrinter(m_log).printError(std::format("Failed to open {}", path));
+                    return nullptr;
+                }
+            }
+            m_sink = &m_ownSink.emplace(path.empty() ? m_out : m_file, *RecordWriter::parseFormat(m_opts.format));
+            return m_sink;
+        }
+
+        void finish() override
+        {
+            if (m_multipleTargets)
+            {
+                std::cout << m_outBuffer.str() << std::flush;
+                std::cerr << m_logBuffer.str() << std::flush;
+            }
+        }
+
+    private:
+        const Options& m_opts;
+        pid_t m_pid;
+        bool m_multipleTargets;
+        TraceRunner::RecordSink* m_sharedSink;
+        std::ostringstream m_outBuffer;
+        std::ostringstream m_logBuffer;
+        std::ostream& m_out;
+        std::ostream& m_log;
+        std::ofstream m_file;
+        std::optional<TraceRunner::RecordSink> m_ownSink;
+        TraceRunner::RecordSink* m_sink{nullptr};
+        std::string m_summary;
+
+        std::string outputPath() const
+        {
+            // Every target gets its own file when several processes are captured at once.
+            return m_multipleTargets && !m_opts.outputPath.empty() ? std::format("{}.{}", m_opts.outputPath, m_pid) : m_opts.outputPath;
+        }
+
+        void writeProfile(const StackProfile& profile)
+        {
+            const ConsolePrinter printer(m_out);
+
+            if (m_opts.format != "folded" && m_opts.format != "pprof")
+            {
+                printer.printError(std::format("Unknown output format: {}", m_opts.format));
+                return;
+            }
+
+            const auto path = outputPath();
+
+            std::ofstream file;
+            if (!path.empty())
+            {
+                file.open(path, std::ios::binary | std::ios::trunc);
+                if (!file)
+                {
+                    printer.printError(std::format("Failed to open {}", path));
+                    return;
+                }
+            }
+            std::ostream& os = path.empty() ? m_out : file;
+
+            if (m_opts.format == "folded")
+            {
+                ProfileWriter::writeFolded(os, profile);
+            }
+            else
+            {
+                ProfileWriter::writePprof(os, profile, m_opts.sampleHz);
+            }
+            os.flush();
+        }
+
+        void printStats(const TraceRunner::CaptureStats& stats) const
+        {
+            const ConsolePrinter printer(m_log);
+            if (stats.lostSamples != 0)
+            {
+                printer.printWarning(std::format("{} samples were lost because the ring buffer was full", stats.lostSamples));
+            }
+
+            if (stats.unsampledThreads != 0)
+            {
+                printer.printWarning(std::format("{} threads were not sampled because perf could not map a ring buffer for them; "
+                    "raise kernel.perf_event_mlock_kb or use --unwind fp for smaller rings", stats.unsampledThreads));
+            }
+
+            if (stats.stops == 0)
+            {
+                return;
+            }
+
+            const auto toMicros = [](const std::chrono::nanoseconds duration)
+            {
+                return std::chrono::duration<double, std::micro>(duration).count();
+            };
+
+            if (stats.stops == 1)
+            {
+                printer.printInfo(std::format("Target stopped for {:.1f} us", toMicros(stats.totalStop)));
+                return;
+            }
+
+            printer.printInfo(std::format("Target stopped {} times, {:.1f} us on average, {:.1f} us at most",
+                stats.stops, toMicros(stats.totalStop) / static_cast<double>(stats.stops), toMicros(stats.maxStop)));
+        }
+    };
+}
 
 void printHelp()
 {
     const ConsolePrinter printer;
     printer.printInfo("Usage: mexTrace [options]");
+    printer.printInfo("       mexTrace crash <file>  Symbolize the records written by CrashHandler");
     printer.printInfo("Options:");
-    printer.printInfo("  -p, --pid <pid>   Attach to specified process ID");
-    printer.printInfo("  -l, --list        List all running processes");
+    printer.printInfo("  -p, --pid <pid>   Attach to specified process ID (repeatable)");
+    printer.printInfo("  --all             Capture every process that can be attached to");
+    printer.printInfo("  --name <regex>    Capture (or with -l, list) every process whose name matches the regex");
+    printer.printInfo("  -j, --jobs <n>    Capture at most n processes concurrently (default: CPU count)");
+    printer.printInfo("  -l, --list        List running processes with state, threads, RSS and CPU time");
+    printer.printInfo("  --sort <column>   With -l, sort by pid (default), ppid, name, state, threads, rss or cpu");
+    printer.printInfo("  --top <n>         With -l, show only the first n rows");
+    printer.printInfo("  --state <letters> With -l, show only processes in the given states, e.g. RD");
     printer.printInfo("  -s, --self        Capture stack trace of this process");
+    printer.printInfo("  -t, --threads     Capture the stacks of all threads of the process");
+    printer.printInfo("  --group           With -t, print each distinct stack once with its TIDs");
+    printer.printInfo("  --tree            With -t, print all stacks as a tree showing where they diverge");
     printer.printInfo("  -h, --help        Show this help message");
     printer.printInfo("  -v, --verbose     Enable verbose output");
+    printer.printInfo(std::format("  --sample <hz>     Sample the process at the given rate, up to {} Hz, and aggregate identical stacks",
+        TraceRunner::maxSampleFrequency));
+    printer.printInfo("  --duration <sec>  How long to sample (default 5)");
+    printer.printInfo("  --watch <sec>     Re-capture every interval and print only the threads whose stacks changed");
+    printer.printInfo("  --detect-hang     Sample all threads over --duration and report stacks that never moved,");
+    printer.printInfo("                    the futexes they wait on, lock cycles and convoys; exits with 2 if any is found");
+    printer.printInfo("  --backend <name>  Sampling backend: ptrace (default, stops the target) or perf (perf_event_open)");
+    printer.printInfo("  --format <fmt>    Output format: text (default), jsonl or binary (one record per stack, streamed),");
+    printer.printInfo("                    or for samples also folded or pprof");
+    printer.printInfo("  -o, --output <f>  Write sample or record output to a file instead of stdout");
+    printer.printInfo("  --stack-bytes <n> Bytes of target stack to snapshot per capture; deeper frames are cut off (default 262144)");
+    printer.printInfo("  --unwind <method> Unwinding method: dwarf (default, uses .eh_frame) or fp");
+    printer.printInfo("  --cache-dir <dir> Directory for the persistent symbol index cache");
+    printer.printInfo("  --no-cache        Disable the persistent symbol index cache");
+}
+
+template <typename T>
+bool parseWhole(const std::string_view text, T& value)
+{
+    // A number followed by anything else, such as "4x", is a typo rather than a value.
+    const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return ec == std::errc() && ptr == text.data() + text.size();
 }
 
 Options parseArgs(const std::span<char*> args)
 {
     Options opts;
 
+    // Only the first bad value is reported; the remaining arguments are still consumed.
+    const auto reject = [&opts](const std::string_view option, const std::string_view value, const std::string_view expected)
+    {
+        if (opts.usageError.empty())
+        {
+            opts.usageError = std::format("Invalid value '{}' for {}: expected {}", value, option, expected);
+        }
+    };
+
     for (size_t i = 1; i < args.size(); ++i)
     {
         const std::string_view arg = args[i];
 
-        if (arg == "-h" || arg == "--help")
+        if (i == 1 && arg == "crash")
+        {
+            if (i + 1 < args.size())
+            {
+                opts.crashFile = args[++i];
+            }
+            else if (opts.usageError.empty())
+            {
+                opts.usageError = "crash requires a record file";
+            }
+        }
+        else if (arg == "-h" || arg == "--help")
         {
             opts.help = true;
         }
@@ -60,19 +434,137 @@ Options parseArgs(const std::span<char*> args)
         {
             opts.verbose = true;
         }
+        else if (arg == "-t" || arg == "--threads")
+        {
+            opts.allThreads = true;
+        }
+        else if (arg == "--all")
+        {
+            opts.all = true;
+        }
+        else if (arg == "--name" && i + 1 < args.size())
+        {
+            opts.namePattern = args[++i];
+        }
+        else if ((arg == "-j" || arg == "--jobs") && i + 1 < args.size())
+        {
+            ++i;
+            if (!parseWhole(args[i], opts.jobs) || opts.jobs == 0)
+            {
+                reject(arg, args[i], "a positive number of jobs");
+            }
+        }
+        else if (arg == "--sort" && i + 1 < args.size())
+        {
+            opts.listSort = args[++i];
+        }
+        else if (arg == "--state" && i + 1 < args.size())
+        {
+            opts.stateFilter = args[++i];
+        }
+        else if (arg == "--top" && i + 1 < args.size())
+        {
+            ++i;
+            if (!parseWhole(args[i], opts.top))
+            {
+                reject(arg, args[i], "a number of rows");
+            }
+        }
+        else if (arg == "--group")
+        {
+            opts.group = true;
+        }
+        else if (arg == "--tree")
+        {
+            opts.tree = true;
+        }
+        else if (arg == "--no-cache")
+        {
+            opts.noCache = true;
+        }
+        else if (arg == "--stack-bytes" && i + 1 < args.size())
+        {
+            ++i;
+            if (!parseWhole(args[i], opts.stackBytes) || opts.stackBytes == 0)
+            {
+                reject(arg, args[i], "a positive number of bytes");
+            }
+        }
+        else if (arg == "--sample" && i + 1 < args.size())
+        {
+            ++i;
+            if (!parseWhole(args[i], opts.sampleHz) || opts.sampleHz == 0 || opts.sampleHz > TraceRunner::maxSampleFrequency)
+            {
+                reject(arg, args[i], std::format("a rate from 1 to {} Hz", TraceRunner::maxSampleFrequency));
+            }
+        }
+        else if (arg == "--duration" && i + 1 < args.size())
+        {
+            ++i;
+            if (!parseWhole(args[i], opts.durationSec) || !(opts.durationSec > 0.0))
+            {
+                reject(arg, args[i], "a positive duration in seconds");
+            }
+        }
+        else if (arg == "--detect-hang")
+        {
+            opts.detectHang = true;
+        }
+        else if (arg == "--watch" && i + 1 < args.size())
+        {
+            ++i;
+            if (!parseWhole(args[i], opts.watchSec) || !(opts.watchSec > 0.0))
+            {
+                reject(arg, args[i], "a positive interval in seconds");
+            }
+        }
+        else if (arg == "--format" && i + 1 < args.size())
+        {
+            opts.format = args[++i];
+        }
+        else if ((arg == "-o" || arg == "--output") && i + 1 < args.size())
+        {
+            opts.outputPath = args[++i];
+        }
+        else if (arg == "--unwind" && i + 1 < args.size())
+        {
+            ++i;
+            if (const auto method = TraceSession::parseUnwindMethod(args[i]))
+            {
+                opts.unwindMethod = *method;
+            }
+            else
+            {
+                reject(arg, args[i], "dwarf or fp");
+            }
+        }
+        else if (arg == "--backend" && i + 1 < args.size())
+        {
+            ++i;
+            if (const auto backend = TraceRunner::parseSamplingBackend(args[i]))
+            {
+                opts.backend = *backend;
+            }
+            else
+            {
+                reject(arg, args[i], "ptrace or perf");
+            }
+        }
+        else if (arg == "--cache-dir" && i + 1 < args.size())
+        {
+            opts.cacheDir = args[++i];
+        }
         else if ((arg == "-p" || arg == "--pid") && i + 1 < args.size())
         {
             ++i;
-            const std::string_view pidStr = args[i];
-            auto [ptr, ec] = std::from_chars(
-                pidStr.data(),
-                pidStr.data() + pidStr.size(),
-                opts.pid
-            );
-
-            if (ec != std::errc())
+            pid_t pid = 0;
+            if (parseWhole(args[i], pid) && pid > 0)
+            {
+                opts.pids.push_back(pid);
+            }
+            else
             {
-                opts.pid = 0;
+                reject(arg, args[i], "a process ID");
             }
         }
     }
@@ -80,106 +572,271 @@ Options parseArgs(const std::span<char*> args)
     return opts;
 }
 
-void listProcesses()
+std::expected<std::optional<std::regex>, std::string> compileNamePattern(const Options& opts)
+{
+    if (opts.namePattern.empty())
+    {
+        return std::optional<std::regex>{};
+    }
+
+    try
+    {
+        return std::optional{std::regex(opts.namePattern, std::regex::extended | std::regex::nosubs)};
+    }
+    catch (const std::regex_error& e)
+    {
+        return std::unexpected(std::format("Invalid name pattern '{}': {}", opts.namePattern, e.what()));
+    }
+}
+
+ThreadPool* scanPool(const Options& opts)
+{
+    return opts.jobs == 1 ? nullptr : &ThreadPool::shared();
+}
+
+bool listProcesses(const Options& opts)
 {
     const ConsolePrinter printer;
-    auto result = PlatformUtils::getAllProcesses();
 
-    if (!result)
+    const auto sortKey = ProcessScanner::parseSortKey(opts.listSort);
+    if (!sortKey)
     {
-        printer.printError(result.error());
-        return;
+        printer.printError(std::format("Unknown sort column: {}", opts.listSort));
+        return false;
     }
 
-    printer.printInfo("Running processes:");
-    std::println("PID\tName");
-    std::println("----------------");
+    const auto pattern = compileNamePattern(opts);
+    if (!pattern)
+    {
+        printer.printError(pattern.error());
+        return false;
+    }
+
+    const ProcessScanner scanner;
+    auto processes = scanner.scan(scanPool(opts));
+    if (processes.empty())
+    {
+        printer.printError("Failed to read /proc");
+        return false;
+    }
 
-    for (const pid_t pid : *result)
+    std::erase_if(processes, [&](const ProcessScanner::ProcessInfo& process)
     {
-        if (auto name = PlatformUtils::getProcessName(pid))
+        if (!opts.stateFilter.empty() && opts.stateFilter.find(process.state) == std::string::npos)
         {
-            std::println("{}\t{}", pid, *name);
+            return true;
         }
-    }
+        return *pattern && !std::regex_search(process.name, **pattern);
+    });
+
+    // Quantities read best largest first; identifiers and names in natural order.
+    using enum ProcessScanner::SortKey;
+    const bool descending = *sortKey == Threads || *sortKey == Rss || *sortKey == Cpu;
+    ProcessScanner::sort(processes, *sortKey, descending);
+
+    const auto shown = opts.top != 0 ? std::min(opts.top, processes.size()) : processes.size();
+    printer.printProcessTable(std::span(processes).first(shown));
+    printer.printInfo(std::format("{} of {} matching processes shown", shown, processes.size()));
+    return true;
 }
 
-void attachToProcess(const pid_t pid, const bool verbose)
+TraceRunner::Options runnerOptionsFor(const Options& opts)
 {
-    const ConsolePrinter printer;
-
-    if (!PlatformUtils::isProcessRunning(pid))
+    TraceRunner::Options options;
+    if (opts.stackBytes != 0)
     {
-        printer.printError(std::format("Process {} is not running", pid));
-        return;
+        options.session.stackBytes = opts.stackBytes;
     }
+    options.session.unwindMethod = opts.unwindMethod;
+    options.backend = opts.backend;
+    options.sampleHz = opts.sampleHz;
+    options.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(opts.durationSec));
+    options.watchInterval = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(opts.watchSec));
+    options.records = RecordWriter::parseFormat(opts.format).has_value();
 
-    if (verbose)
+    using Mode = TraceRunner::Mode;
+    if (opts.watchSec != 0.0)
+    {
+        options.mode = Mode::Watch;
+    }
+    else if (opts.detectHang)
+    {
+        options.mode = Mode::DetectHang;
+    }
+    else if (opts.sampleHz != 0)
     {
-        printer.printInfo(std::format("Attaching to process: {}", pid));
+        options.mode = Mode::Sample;
+    }
+    else if (opts.allThreads)
+    {
+        options.mode = opts.group || opts.tree ? Mode::ThreadGroups : Mode::AllThreads;
+    }
+    return options;
+}
 
-        if (auto name = PlatformUtils::getProcessName(pid))
+std::vector<pid_t> selectTargets(const Options& opts)
+{
+    const ConsolePrinter printer;
+    std::vector<pid_t> targets = opts.pids;
+
+    if (opts.all || !opts.namePattern.empty())
+    {
+        const auto pattern = compileNamePattern(opts);
+        if (!pattern)
         {
-            printer.printInfo(std::format("Process name: {}", *name));
+            printer.printError(pattern.error());
+            return {};
         }
 
-        if (auto path = PlatformUtils::getExecutablePath(pid))
+        const auto processes = TraceRunner::findProcesses(*pattern, scanPool(opts));
+        if (!processes)
         {
-            printer.printInfo(std::format("Executable path: {}", *path));
+            printer.printError(processes.error());
+            return {};
         }
+        targets.insert(targets.end(), processes->begin(), processes->end());
     }
 
-    const StackTrace tracer;
-    auto result = tracer.captureProcess(pid);
+    std::ranges::sort(targets);
+    const auto [first, last] = std::ranges::unique(targets);
+    targets.erase(first, last);
+    return targets;
+}
+
+void captureTargets(const Options& opts, const std::span<const pid_t> targets)
+{
+    const TraceRunner runner(runnerOptionsFor(opts));
+    const bool multipleTargets = targets.size() > 1;
+
+    // Records bound for stdout are streamed through one shared writer; everything else is captured
+    // concurrently into private buffers and printed in PID order.
+    std::optional<TraceRunner::RecordSink> sharedSink;
+    if (const auto recordFormat = RecordWriter::parseFormat(opts.format); multipleTargets && recordFormat && opts.outputPath.empty())
+    {
+        sharedSink.emplace(std::cout, *recordFormat);
+    }
 
-    if (!result)
+    if (opts.watchSec != 0.0)
     {
-        printer.printError(StackTrace::errorToString(result.error()));
-        return;
+        std::signal(SIGINT, [](int) { watchInterrupted = 1; });
     }
 
-    printer.printStackTrace(*result);
-    printer.printSuccess(std::format("Captured stack trace for process {}", pid));
+    runner.run(targets, opts.jobs, [&](const pid_t pid)
+    {
+        return std::make_unique<TargetPrinter>(opts, pid, multipleTargets, sharedSink ? &*sharedSink : nullptr);
+    });
+
+    if (opts.watchSec != 0.0)
+    {
+        std::signal(SIGINT, SIG_DFL);
+    }
+}
+
+void configureSymbolCache(const Options& opts)
+{
+    if (!opts.noCache)
+    {
+        TraceSession::enableSymbolCache(opts.cacheDir);
+    }
 }
 
 void captureOwnStack()
 {
     const ConsolePrinter printer;
-    const StackTrace tracer;
+    SelfTrace trace(1, 128);
 
-    const auto frames = tracer.captureCurrentThread();
+    const auto frames = trace.symbolize(trace.capture());
     printer.printStackTrace(frames);
     printer.printSuccess("Captured current thread stack trace");
 }
 
+bool printCrashRecords(const Options& opts)
+{
+    const ConsolePrinter printer;
+
+    const auto reports = CrashHandler::read(opts.crashFile);
+    if (!reports)
+    {
+        printer.printError(reports.error());
+        return false;
+    }
+
+    for (const auto& report : *reports)
+    {
+        printer.printInfo(std::format("Process {} thread {} received {} (code {}) at 0x{:x}, {:%F %T} UTC",
+            report.pid, report.tid, strsignal(report.signal), report.code, report.faultAddress,
+            std::chrono::floor<std::chrono::seconds>(report.timestamp)));
+
+        std::string registers;
+        for (size_t i = 0; i < report.registers.size(); ++i)
+        {
+            const auto* separator = i + 1 == report.registers.size() ? "" : i % 4 == 3 ? "\n" : "  ";
+            registers += std::format("{:>7} 0x{:016x}{}", CrashHandler::registerName(i), report.registers[i], separator);
+        }
+        printer.printInfo(registers);
+
+        // The binaries are read from disk, so they must not have changed since the crash.
+        printer.printStackTrace(CrashHandler::symbolize(report, &ThreadPool::shared()));
+    }
+
+    printer.printSuccess(std::format("Symbolized {} crash record(s)", reports->size()));
+    return true;
+}
+
 int main(const int argc, char* argv[])
 {
     const auto args = std::span(argv, static_cast<std::size_t>(argc));
-    const auto [pid, list, verbose, help, self] = parseArgs(args);
+    const auto opts = parseArgs(args);
     const ConsolePrinter printer;
 
-    if (help)
+    if (opts.help)
     {
         printHelp();
         return EXIT_SUCCESS;
     }
 
-    if (list)
+    if (!opts.usageError.empty())
     {
-        listProcesses();
-        return EXIT_SUCCESS;
+        printer.printError(opts.usageError);
+        printer.printInfo("Use -h for help.");
+        return EXIT_FAILURE;
     }
 
-    if (self)
+    if (opts.list)
+    {
+        return listProcesses(opts) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    configureSymbolCache(opts);
+
+    if (!opts.crashFile.empty())
+    {
+        return printCrashRecords(opts) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if (opts.self)
     {
         captureOwnStack();
         return EXIT_SUCCESS;
     }
 
-    if (pid != 0)
+    if (!opts.pids.empty() || opts.all || !opts.namePattern.empty())
     {
-        attachToProcess(pid, verbose);
-        return EXIT_SUCCESS;
+        const auto targets = selectTargets(opts);
+        if (targets.empty())
+        {
+            printer.printError("No matching processes");
+            return EXIT_FAILURE;
+        }
+
+        if (opts.watchSec != 0.0 && targets.size() != 1)
+        {
+            printer.printError("--watch takes exactly one process");
+            return EXIT_FAILURE;
+        }
+
+        captureTargets(opts, targets);
+        return hangSuspected ? 2 : EXIT_SUCCESS;
     }
 
     printer.printWarning("No operation specified. Use -h for help.");
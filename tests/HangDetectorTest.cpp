@@ -0,0 +1,154 @@
+// Runs HangDetector against HangTarget processes and checks which waits it reports as a hang.
+// Exits with 0 if every check passed.
+
+#include "HangDetector.h"
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifndef MEXTRACE_HANG_TARGET
+#error "MEXTRACE_HANG_TARGET must name the HangTarget executable"
+#endif
+
+/// @brief Anonymous namespace
+namespace
+{
+    int failures = 0;
+
+    void check(const bool condition, const std::string_view mode, const std::string_view what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAIL %.*s: %.*s\n", static_cast<int>(mode.size()), mode.data(), static_cast<int>(what.size()), what.data());
+            ++failures;
+        }
+    }
+
+    /// @brief SpawnedTarget runs HangTarget in one mode until it is destroyed. \class SpawnedTarget
+    class SpawnedTarget
+    {
+    public:
+
+        /**
+         * @brief Ctor, starts the target and waits until its threads are blocked.
+         * @param mode The HangTarget mode.
+         * @param count The thread count passed to the mode.
+         */
+        SpawnedTarget(const std::string_view mode, const int count)
+        {
+            int pipeFds[2];
+            if (pipe(pipeFds) == -1)
+            {
+                return;
+            }
+
+            // Everything the child needs is built here; after fork() it only calls async-signal-safe functions.
+            std::string path(MEXTRACE_HANG_TARGET);
+            std::string modeArg(mode);
+            std::string countArg = std::to_string(count);
+            std::array<char*, 4> argv{path.data(), modeArg.data(), countArg.data(), nullptr};
+
+            m_pid = fork();
+            if (m_pid == 0)
+            {
+                dup2(pipeFds[1], STDOUT_FILENO);
+                close(pipeFds[0]);
+                close(pipeFds[1]);
+                execv(argv[0], argv.data());
+                _exit(127);
+            }
+
+            close(pipeFds[1]);
+            pollfd readyFd{pipeFds[0], POLLIN, 0};
+            std::array<char, 16> line{};
+            if (m_pid > 0 && poll(&readyFd, 1, 10'000) == 1 && read(pipeFds[0], line.data(), line.size()) > 0)
+            {
+                m_ready = std::string_view(line.data()).starts_with("ready");
+            }
+            close(pipeFds[0]);
+        }
+
+        /**
+         * @brief Destructor, kills and reaps the target.
+         */
+        ~SpawnedTarget()
+        {
+            if (m_pid > 0)
+            {
+                kill(m_pid, SIGKILL);
+                waitpid(m_pid, nullptr, 0);
+            }
+        }
+
+        SpawnedTarget(const SpawnedTarget&) = delete;
+        SpawnedTarget& operator=(const SpawnedTarget&) = delete;
+
+        /**
+         * @brief Gets the process ID of the target.
+         * @return The PID, or -1 if it could not be started.
+         */
+        [[nodiscard]] pid_t pid() const noexcept
+        {
+            return m_ready ? m_pid : -1;
+        }
+
+    private:
+        pid_t m_pid{-1};
+        bool m_ready{false};
+    };
+
+    std::optional<HangDetector::Report> detect(const std::string_view mode, const int count)
+    {
+        const SpawnedTarget target(mode, count);
+        check(target.pid() > 0, mode, "target did not start");
+        if (target.pid() <= 0)
+        {
+            return std::nullopt;
+        }
+
+        auto report = HangDetector::detect(target.pid(), TraceSession::Options{}, std::chrono::milliseconds(300));
+        check(report.has_value(), mode, "detection failed");
+        if (!report)
+        {
+            return std::nullopt;
+        }
+        return std::move(*report);
+    }
+}
+
+int main()
+{
+    // Idle workers on a condition variable are stuck, but nothing owns the word they wait on.
+    if (const auto report = detect("pool", 6))
+    {
+        check(report->stuck.size() >= 6, "pool", "idle workers are not reported as stuck");
+        check(report->convoys.empty(), "pool", "idle workers are reported as a convoy");
+        check(report->cycles.empty(), "pool", "idle workers are reported as a cycle");
+        check(!report->hangSuspected(), "pool", "idle workers are reported as a hang");
+    }
+
+    if (const auto report = detect("convoy", 3))
+    {
+        check(report->convoys.size() == 1, "convoy", "the contended mutex is not reported as one convoy");
+        check(!report->convoys.empty() && report->convoys.front().waiters.size() == 3, "convoy", "the convoy does not list every waiter");
+        check(!report->convoys.empty() && report->convoys.front().owner != 0, "convoy", "the convoy has no owner");
+        check(report->hangSuspected(), "convoy", "the convoy is not reported as a hang");
+    }
+
+    if (const auto report = detect("deadlock", 2))
+    {
+        check(report->cycles.size() == 1 && report->cycles.front().size() == 2, "deadlock", "the lock cycle is not reported");
+        check(report->hangSuspected(), "deadlock", "the lock cycle is not reported as a hang");
+    }
+
+    std::printf("%s\n", failures == 0 ? "all checks passed" : "checks failed");
+    return failures == 0 ? 0 : 1;
+}
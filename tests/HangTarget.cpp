@@ -0,0 +1,123 @@
+// Target process for HangDetectorTest. It parks its threads in a known wait, prints "ready"
+// on stdout once they are blocked and then waits to be inspected.
+//
+//   pool <count>     <count> idle workers waiting on one condition variable
+//   convoy <count>   <count> threads blocked on a mutex that another thread holds forever
+//   deadlock         two threads that each hold the mutex the other one wants
+
+#include <atomic>
+#include <charconv>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+/// @brief Anonymous namespace
+namespace
+{
+    std::atomic<int> parkedThreads{0};
+
+    int parseCount(const char* text, const int fallback)
+    {
+        const std::string_view view(text);
+        int value = fallback;
+        std::from_chars(view.data(), view.data() + view.size(), value);
+        return value;
+    }
+
+    void waitForParked(const int threads)
+    {
+        while (parkedThreads.load(std::memory_order_acquire) < threads)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    void waitAndSignalReady(const int threads)
+    {
+        waitForParked(threads);
+
+        // The threads announce themselves just before they block; give the last one time to get there.
+        usleep(100'000);
+        std::puts("ready");
+        std::fflush(stdout);
+    }
+
+    [[noreturn]] void idle()
+    {
+        for (;;)
+        {
+            pause();
+        }
+    }
+}
+
+int main(const int argc, char* argv[])
+{
+    const std::string_view mode = argc > 1 ? argv[1] : "pool";
+    const int count = argc > 2 ? parseCount(argv[2], 4) : 4;
+    std::vector<std::thread> threads;
+
+    if (mode == "pool")
+    {
+        std::mutex mutex;
+        std::condition_variable work;
+        for (int i = 0; i < count; ++i)
+        {
+            threads.emplace_back([&] {
+                std::unique_lock lock(mutex);
+                parkedThreads.fetch_add(1, std::memory_order_release);
+                work.wait(lock, [] { return false; });
+            });
+        }
+        waitAndSignalReady(count);
+        idle();
+    }
+
+    if (mode == "convoy")
+    {
+        std::mutex mutex;
+        threads.emplace_back([&] {
+            std::lock_guard lock(mutex);
+            parkedThreads.fetch_add(1, std::memory_order_release);
+            idle();
+        });
+        waitForParked(1);
+
+        for (int i = 0; i < count; ++i)
+        {
+            threads.emplace_back([&] {
+                parkedThreads.fetch_add(1, std::memory_order_release);
+                std::lock_guard lock(mutex);
+            });
+        }
+        waitAndSignalReady(count + 1);
+        idle();
+    }
+
+    if (mode == "deadlock")
+    {
+        std::mutex first;
+        std::mutex second;
+        std::atomic<int> holding{0};
+        const auto lockBoth = [&](std::mutex& held, std::mutex& wanted) {
+            std::lock_guard outer(held);
+            holding.fetch_add(1);
+            while (holding.load() < 2)
+            {
+                std::this_thread::yield();
+            }
+            parkedThreads.fetch_add(1, std::memory_order_release);
+            std::lock_guard inner(wanted);
+        };
+        threads.emplace_back([&] { lockBoth(first, second); });
+        threads.emplace_back([&] { lockBoth(second, first); });
+        waitAndSignalReady(2);
+        idle();
+    }
+
+    return 1;
+}